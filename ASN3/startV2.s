@@ -98,22 +98,26 @@ core_zero:
 	// described above. This will be sp_el0.
 AtEL1:	mov	sp, x1
 	
-	// Clear the .bss section using a loop. The __bss_start
-	// symbol is provided by the linker, and is the address in
-	// RAM where the .bss starts. The __bss_size symbol is
-	// also provided by the linker, and gives the size (in doublewords)
-	// of the .bss section.
+	// Clear the .bss section using a loop. The __bss_start and
+	// __bss_end symbols are provided by the linker, and are the
+	// addresses in RAM where the .bss starts and ends. Both are
+	// aligned to 64 bytes (see link.ld), so each pass of the loop
+	// writes 64 bytes with four stp instructions. (DC ZVA cannot
+	// be used: with the MMU off, memory is Device memory, on which
+	// it faults.)
 	adrp	x1, __bss_start		// Put address of .bss into x1
 	add	x1, x1, :lo12:__bss_start
-	ldr     w2, =__bss_size		// Put the size of the .bss section
-					// into w2, using a literal pool.
-					// w2 is our counter.
-
-top:	cbz     w2, endloop		// Exit loop if counter == 0
-	str     xzr, [x1], 8		// Write zeroes to RAM, x1 += 8
-	sub     w2, w2, 1		// Decrement counter (w2)
-	cbnz    w2, top			// Keep looping while counter != 0
-endloop:	
+	adrp	x2, __bss_end		// Put the end of .bss into x2
+	add	x2, x2, :lo12:__bss_end
+	b	test
+
+top:	stp	xzr, xzr, [x1]		// Write 64 bytes of zeroes to RAM
+	stp	xzr, xzr, [x1, 16]
+	stp	xzr, xzr, [x1, 32]
+	stp	xzr, xzr, [x1, 48]
+	add	x1, x1, 64		// x1 += 64
+test:	cmp	x1, x2			// Keep looping while x1 < x2
+	b.lo	top
 
 	// Branch to the main() routine, which should never return
   	bl      main
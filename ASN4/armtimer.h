@@ -0,0 +1,21 @@
+// The addresses of the ARM Timer registers.
+//
+// These are defined on page 196 of the Broadcom BCM2837 ARM Peripherals
+// Manual. The ARM Timer is based on an ARM SP804, and counts down at the
+// core clock divided by (pre-divider + 1), raising an interrupt and
+// reloading when it reaches 0.
+#include "gpio.h"
+
+#define ARM_TIMER_LOAD          ((volatile unsigned int *)(MMIO_BASE + 0x0000B400))
+#define ARM_TIMER_VALUE         ((volatile unsigned int *)(MMIO_BASE + 0x0000B404))
+#define ARM_TIMER_CONTROL       ((volatile unsigned int *)(MMIO_BASE + 0x0000B408))
+#define ARM_TIMER_IRQ_CLEAR     ((volatile unsigned int *)(MMIO_BASE + 0x0000B40C))
+#define ARM_TIMER_RAW_IRQ       ((volatile unsigned int *)(MMIO_BASE + 0x0000B410))
+#define ARM_TIMER_MASKED_IRQ    ((volatile unsigned int *)(MMIO_BASE + 0x0000B414))
+#define ARM_TIMER_RELOAD        ((volatile unsigned int *)(MMIO_BASE + 0x0000B418))
+#define ARM_TIMER_PREDIVIDER    ((volatile unsigned int *)(MMIO_BASE + 0x0000B41C))
+
+// Bits in the control register
+#define ARM_TIMER_CTRL_32BIT    (0x1 << 1)
+#define ARM_TIMER_CTRL_IRQ      (0x1 << 5)
+#define ARM_TIMER_CTRL_ENABLE   (0x1 << 7)
@@ -0,0 +1,95 @@
+// This file provides the alpha blending kernel used to stamp brushes (see
+// brush.c). It is written in assembly code so that it can use the NEON
+// vector registers, which the C code is compiled not to touch (see the
+// Makefile), so the IRQ handler does not need to save them.
+//
+// The frame buffer is accessed with the MMU off, so it is Device memory,
+// where every access must be aligned to its element size. Pixels are
+// therefore loaded and stored with ld1/st1 on 32-bit elements, and the
+// coverage bytes with ld1 on 8-bit elements.
+
+
+		.text
+		.balign 4
+
+// void blend_span_xrgb8888(unsigned int *dst, unsigned char *alpha,
+//                          unsigned int colour, int count)
+//
+// Blends colour over count 0x00RRGGBB pixels at dst, using one coverage
+// byte per pixel (0 leaves the pixel alone, 255 replaces it). Each channel
+// becomes (colour * a + dst * (255 - a)) / 255, rounded to nearest.
+//
+// Pixels are done 4 at a time. Groups of 4 that are fully covered are
+// just stored, and groups with no coverage are skipped without touching
+// the frame buffer. Up to 3 pixels at the end are done one at a time.
+// The alpha array is read up to 4 bytes past count.
+
+		.global blend_span_xrgb8888
+blend_span_xrgb8888:
+		dup	v0.4s, w2		// v0 = colour in all 4 pixels
+		movi	v7.16b, 255		// v7 = 255 in every byte
+		adr	x4, spread
+		ldr	q6, [x4]		// v6 = table to copy each alpha
+						// byte into its pixel's 4 bytes
+
+		subs	w3, w3, 4
+		b.lt	tail
+
+group:		ld1	{v1.8b}, [x1]		// Coverage of the next 4 pixels
+		add	x1, x1, 4
+		fmov	w5, s1
+		cbz	w5, next		// Fully transparent: skip
+		cmn	w5, 1
+		b.eq	opaque			// Fully opaque: store the colour
+
+		ld1	{v2.4s}, [x0]		// v2 = 4 destination pixels
+		tbl	v1.16b, {v1.16b}, v6.16b
+		sub	v3.16b, v7.16b, v1.16b	// v3 = 255 - a
+
+		umull	v4.8h, v0.8b, v1.8b	// colour * a + dst * (255 - a)
+		umlal	v4.8h, v2.8b, v3.8b	// for pixels 0 and 1 ...
+		umull2	v5.8h, v0.16b, v1.16b
+		umlal2	v5.8h, v2.16b, v3.16b	// ... and pixels 2 and 3
+
+		urshr	v16.8h, v4.8h, 8	// Divide by 255, rounding:
+		urshr	v17.8h, v5.8h, 8	// (t + ((t + 128) >> 8) + 128) >> 8
+		raddhn	v2.8b, v4.8h, v16.8h
+		raddhn2	v2.16b, v5.8h, v17.8h
+
+		st1	{v2.4s}, [x0]
+		b	next
+
+opaque:		st1	{v0.4s}, [x0]
+
+next:		add	x0, x0, 16
+		subs	w3, w3, 4
+		b.ge	group
+
+tail:		adds	w3, w3, 4
+		b.eq	done
+
+single:		ldrb	w5, [x1], 1		// Coverage of the next pixel
+		cbz	w5, skip
+		cmp	w5, 255
+		b.ne	blend
+		str	w2, [x0]
+		b	skip
+
+blend:		ld1	{v2.s}[0], [x0]
+		dup	v1.8b, w5
+		sub	v3.8b, v7.8b, v1.8b
+		umull	v4.8h, v0.8b, v1.8b
+		umlal	v4.8h, v2.8b, v3.8b
+		urshr	v16.8h, v4.8h, 8
+		raddhn	v2.8b, v4.8h, v16.8h
+		st1	{v2.s}[0], [x0]
+
+skip:		add	x0, x0, 4
+		subs	w3, w3, 1
+		b.ne	single
+
+done:		ret
+
+
+		.balign 16
+spread:		.byte	0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3
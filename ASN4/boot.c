@@ -0,0 +1,122 @@
+// The functions in this file keep a timeline of the boot, from the moment
+// core 0 enters _start to the first frame on the screen. Each phase is
+// stamped with the generic timer's counter, which the firmware started
+// long before, so the first stamp also shows how long the firmware took.
+// start.s takes the first three stamps in registers, since .bss is not
+// cleared yet, and hands them over before calling main().
+
+#include "uart.h"
+#include "sysreg.h"
+#include "timebase.h"
+#include "boot.h"
+
+// A phase of the boot and the counter when it ended
+struct BootMark
+{
+    char *phase;
+    unsigned long ticks;
+};
+
+// Width of the phase column printed by boot_report()
+#define BOOT_PHASE_WIDTH    16
+
+static struct BootMark marks[BOOT_MAX_MARKS];
+static int markCount;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       boot_start
+//
+//  Arguments:      reset:     The counter when core 0 entered _start
+//                  el1:       The counter once it was running at EL1
+//                  bss:       The counter once .bss was cleared
+//
+//  Returns:        void
+//
+//  Description:    This function starts the timeline with the stamps that
+//                  start.s took. It is called from start.s, right before
+//                  main().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void boot_start(unsigned long reset, unsigned long el1, unsigned long bss)
+{
+    marks[0].phase = "reset";
+    marks[0].ticks = reset;
+    marks[1].phase = "EL1";
+    marks[1].ticks = el1;
+    marks[2].phase = ".bss cleared";
+    marks[2].ticks = bss;
+    markCount = 3;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       boot_mark
+//
+//  Arguments:      phase:     Name of the phase that has just ended
+//
+//  Returns:        void
+//
+//  Description:    This function adds a stamp to the timeline. Stamps past
+//                  BOOT_MAX_MARKS are dropped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void boot_mark(char *phase)
+{
+    if (markCount == BOOT_MAX_MARKS)
+        return;
+
+    marks[markCount].phase = phase;
+    marks[markCount].ticks = getCNTPCT();
+    markCount++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       boot_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function prints the timeline to the UART terminal:
+//                  when each phase ended after the reset, and how long it
+//                  took, in microseconds.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void boot_report()
+{
+    unsigned long reset = marks[0].ticks, previous = reset;
+    int i, column;
+
+    if (markCount == 0)
+        return;
+
+    uart_puts("\nBoot timeline in microseconds (the firmware ran for ");
+    uart_putdec(ticks_to_us(reset));
+    uart_puts("):\n");
+    uart_puts("    phase                  at     took\n");
+
+    for (i = 0; i < markCount; i++) {
+        uart_puts("    ");
+        uart_puts(marks[i].phase);
+        for (column = 0; marks[i].phase[column] != '\0'; column++)
+            ;
+        while (column++ < BOOT_PHASE_WIDTH)
+            uart_putc(' ');
+
+        uart_putdec_padded(ticks_to_us(marks[i].ticks - reset), 9);
+        uart_putdec_padded(ticks_to_us(marks[i].ticks - previous), 9);
+        uart_puts("\n");
+        previous = marks[i].ticks;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+// Most phases the boot timeline records, the three taken in start.s
+// included
+#define BOOT_MAX_MARKS      16
+
+// Puts a buffer in the lazily zeroed region (see link.ld), which start.s
+// does not clear. Only buffers that are always written before they are
+// read, such as rings with their indices kept elsewhere, may go there.
+#define BOOT_LAZY           __attribute__((section(".bss.lazy")))
+
+// Function prototypes
+void boot_start(unsigned long reset, unsigned long el1, unsigned long bss);
+void boot_mark(char *phase);
+void boot_report();
+
+#endif
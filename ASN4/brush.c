@@ -0,0 +1,188 @@
+// The functions in this file draw with round, anti-aliased brushes. The
+// coverage of each pixel by the brush (0 to 255) is worked out once for
+// every size when the program starts, along with the first and last
+// covered pixel of each row. Stamping a brush then only blends the
+// covered part of each row into the screen, using the NEON kernel in
+// blend.s on 32-bit surfaces.
+//
+// The canvas model is 1 bit per pixel, so it cannot hold the soft edges.
+// It records the pixels the brush covers at least half of, which is also
+// what is shown wherever the screen is redrawn from the canvas.
+
+#include "canvas.h"
+#include "brush.h"
+
+// A covered run of pixels in one row of a mask: [start, end)
+struct BrushSpan
+{
+    unsigned char start;
+    unsigned char end;
+};
+
+// Coverage masks and their row spans, indexed by size - 1
+static unsigned char masks[BRUSH_MAX_SIZE][BRUSH_MAX_SIZE][BRUSH_STRIDE];
+static struct BrushSpan spans[BRUSH_MAX_SIZE][BRUSH_MAX_SIZE];
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       brush_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function computes the coverage masks of all brush
+//                  sizes. Each pixel is sampled on a BRUSH_SAMPLES x
+//                  BRUSH_SAMPLES grid, and its coverage is the fraction of
+//                  samples inside a circle touching the edges of the mask.
+//                  The 1 pixel brush is a solid pixel, like the old pen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void brush_init()
+{
+    int size, row, col, i, j, u, v, centre, inside;
+
+    for (size = 1; size <= BRUSH_MAX_SIZE; size++) {
+        // Work in units of 1 / (2 * BRUSH_SAMPLES) pixel, so that the
+        // centres of the samples and of the circle are whole numbers
+        centre = size * BRUSH_SAMPLES;
+
+        for (row = 0; row < size; row++) {
+            spans[size - 1][row].start = size;
+            spans[size - 1][row].end = 0;
+
+            for (col = 0; col < size; col++) {
+                inside = 0;
+                for (i = 0; i < BRUSH_SAMPLES; i++) {
+                    for (j = 0; j < BRUSH_SAMPLES; j++) {
+                        u = (col * BRUSH_SAMPLES + j) * 2 + 1 - centre;
+                        v = (row * BRUSH_SAMPLES + i) * 2 + 1 - centre;
+                        if (u * u + v * v <= centre * centre)
+                            inside++;
+                    }
+                }
+
+                if (size == 1)
+                    inside = BRUSH_SAMPLES * BRUSH_SAMPLES;
+
+                masks[size - 1][row][col] =
+                    (inside * 255 + BRUSH_SAMPLES * BRUSH_SAMPLES / 2) /
+                    (BRUSH_SAMPLES * BRUSH_SAMPLES);
+
+                if (masks[size - 1][row][col] != 0) {
+                    if (col < spans[size - 1][row].start)
+                        spans[size - 1][row].start = col;
+                    spans[size - 1][row].end = col + 1;
+                }
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       brush_stamp
+//
+//  Arguments:      s:         The surface to draw on
+//                  x, y:      Centre of the brush on the surface
+//                  size:      Diameter of the brush, 1 to BRUSH_MAX_SIZE
+//                  colour:    A 0x00RRGGBB color code
+//
+//  Returns:        void
+//
+//  Description:    This function stamps a brush onto a surface, clipped to
+//                  its edges. On 32-bit surfaces the edge of the brush is
+//                  blended with the pixels underneath. Other formats have
+//                  no blending kernel, so the pixels that are at least half
+//                  covered are set instead.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void brush_stamp(struct Surface *s, int x, int y, int size, unsigned int colour)
+{
+    int row, start, end, left = x - size / 2, top = y - size / 2;
+    unsigned int pixel = surface_map_color(s, colour);
+    unsigned char *mask;
+
+    for (row = 0; row < size; row++) {
+        if (top + row < 0 || top + row >= (int)s->height)
+            continue;
+
+        // Clip the covered part of the row to the surface
+        start = spans[size - 1][row].start;
+        end = spans[size - 1][row].end;
+        if (left + start < 0)
+            start = -left;
+        if (left + end > (int)s->width)
+            end = s->width - left;
+        if (start >= end)
+            continue;
+
+        mask = masks[size - 1][row];
+
+        if (s->format == SURFACE_XRGB8888) {
+            blend_span_xrgb8888((unsigned int *)((unsigned char *)s->base +
+                                                 (top + row) * s->pitch) + left + start,
+                                mask + start, pixel, end - start);
+        } else {
+            for (; start < end; start++) {
+                if (mask[start] >= 128)
+                    s->put(s, left + start, top + row, pixel);
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       brush_mark
+//
+//  Arguments:      x, y:      Centre of the brush on the canvas
+//                  size:      Diameter of the brush, 1 to BRUSH_MAX_SIZE
+//
+//  Returns:        void
+//
+//  Description:    This function inks the canvas pixels that the brush
+//                  covers at least half of.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void brush_mark(int x, int y, int size)
+{
+    int row, col, left = x - size / 2, top = y - size / 2;
+
+    for (row = 0; row < size; row++) {
+        if (top + row < 0 || top + row >= CANVAS_HEIGHT)
+            continue;
+
+        for (col = spans[size - 1][row].start; col < spans[size - 1][row].end; col++) {
+            if (left + col >= 0 && left + col < CANVAS_WIDTH &&
+                masks[size - 1][row][col] >= 128)
+                canvas_set(left + col, top + row);
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       brush_next_size
+//
+//  Arguments:      size:      The current brush size
+//
+//  Returns:        The next size in the cycle 1, 2, 4, 8, 16, 1, ...
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int brush_next_size(int size)
+{
+    return size * 2 > BRUSH_MAX_SIZE ? 1 : size * 2;
+}
@@ -0,0 +1,26 @@
+#ifndef BRUSH_H
+#define BRUSH_H
+
+#include "surface.h"
+
+// Brushes are round, with diameters from 1 to BRUSH_MAX_SIZE pixels
+#define BRUSH_MAX_SIZE      16
+
+// Bytes per row of a coverage mask. The blend kernel reads up to 4 bytes
+// past the end of a span, so rows are padded.
+#define BRUSH_STRIDE        (BRUSH_MAX_SIZE + 4)
+
+// Each side of a pixel is sampled this many times to work out coverage
+#define BRUSH_SAMPLES       8
+
+// Function prototypes
+void brush_init();
+void brush_stamp(struct Surface *s, int x, int y, int size, unsigned int colour);
+void brush_mark(int x, int y, int size);
+int brush_next_size(int size);
+
+// Alpha blending kernel in blend.s
+void blend_span_xrgb8888(unsigned int *dst, unsigned char *alpha,
+                         unsigned int colour, int count);
+
+#endif
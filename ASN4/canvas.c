@@ -0,0 +1,180 @@
+// The functions in this file maintain a compact model of the drawing. The
+// canvas stores one bit per pixel, so the whole 4096 x 4096 drawing takes
+// 2 MB, less than a single 1024 x 768 screen at 32 bits per pixel, and it
+// can be scanned a 64-bit word at a time when it has to be saved, sent, or
+// redrawn.
+
+#include "framebuffer.h"
+#include "canvas.h"
+#include "undo.h"
+
+unsigned long canvas[CANVAS_HEIGHT][CANVAS_ROW_WORDS];
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       canvas_clear
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function erases the whole canvas to paper. Tiles
+//                  that are already blank are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void canvas_clear()
+{
+    int row, i, top;
+    unsigned long any;
+
+    // Work a tile column at a time, so that the undo history only has to
+    // copy the tiles that had ink on them
+    for (top = 0; top < CANVAS_HEIGHT; top += UNDO_TILE_SIZE) {
+        for (i = 0; i < CANVAS_ROW_WORDS; i++) {
+            any = 0;
+            for (row = top; row < top + UNDO_TILE_SIZE && row < CANVAS_HEIGHT; row++)
+                any |= canvas[row][i];
+
+            if (any == 0)
+                continue;
+
+            undo_touch(i << 6, top);
+            for (row = top; row < top + UNDO_TILE_SIZE && row < CANVAS_HEIGHT; row++)
+                canvas[row][i] = 0;
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       canvas_set
+//
+//  Arguments:      x, y:      Pixel coordinates
+//
+//  Returns:        void
+//
+//  Description:    This function puts ink on one pixel, ignoring
+//                  coordinates outside the canvas. The undo history is
+//                  told about the change first, unless the pixel already
+//                  had ink.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void canvas_set(int x, int y)
+{
+    unsigned long bit = 1UL << (x & 63);
+
+    if (x < 0 || y < 0 || x >= CANVAS_WIDTH || y >= CANVAS_HEIGHT)
+        return;
+
+    if (canvas[y][x >> 6] & bit)
+        return;
+
+    undo_touch(x, y);
+    canvas[y][x >> 6] |= bit;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       canvas_get
+//
+//  Arguments:      x, y:      Pixel coordinates
+//
+//  Returns:        1 if the pixel has ink, 0 if it is paper or outside the
+//                  canvas
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int canvas_get(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= CANVAS_WIDTH || y >= CANVAS_HEIGHT)
+        return 0;
+
+    return (canvas[y][x >> 6] >> (x & 63)) & 0x1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       canvas_run_end
+//
+//  Arguments:      x, y:      Start of the run
+//                  ink:       The value (0 or 1) of the pixels in the run
+//
+//  Returns:        The x coordinate of the first pixel at or after x on row
+//                  y that does not have the given value, or CANVAS_WIDTH if
+//                  the run reaches the end of the row
+//
+//  Description:    This function finds the end of a run of equal pixels.
+//                  Whole words are skipped when they hold no change, and
+//                  the change inside a word is found with a count trailing
+//                  zeros instruction, so long runs cost one step per 64
+//                  pixels.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int canvas_run_end(int x, int y, int ink)
+{
+    unsigned long flip = ink ? ~0UL : 0UL, word;
+    int i = x >> 6;
+
+    // Bits that differ from the run value, ignoring those left of x
+    word = (canvas[y][i] ^ flip) & (~0UL << (x & 63));
+
+    while (word == 0) {
+        if (++i == CANVAS_ROW_WORDS)
+            return CANVAS_WIDTH;
+        word = canvas[y][i] ^ flip;
+    }
+
+    return (i << 6) + __builtin_ctzl(word);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       canvas_present
+//
+//  Arguments:      s:         Surface to draw on (the screen)
+//                  originX:   Canvas position of the surface's left edge
+//                  originY:   Canvas position of the surface's top edge
+//                  x, y:      Top left corner of the region to draw
+//                  w, h:      Size of the region in pixels
+//
+//  Returns:        void
+//
+//  Description:    This function copies a region of the canvas to a surface,
+//                  filling each run of ink or paper with one call. Canvas
+//                  pixel (x, y) lands at (x - originX, y - originY).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void canvas_present(struct Surface *s, int originX, int originY, int x, int y, int w, int h)
+{
+    unsigned int pixel[2];
+    int row, start, end, limit, ink;
+
+    pixel[0] = surface_map_color(s, CANVAS_PAPER);
+    pixel[1] = surface_map_color(s, CANVAS_INK);
+
+    limit = x + w > CANVAS_WIDTH ? CANVAS_WIDTH : x + w;
+
+    for (row = y; row < y + h && row < CANVAS_HEIGHT; row++) {
+        for (start = x; start < limit; start = end) {
+            ink = canvas_get(start, row);
+            end = canvas_run_end(start, row, ink);
+            if (end > limit)
+                end = limit;
+
+            surface_fill_rect(s, start - originX, row - originY, end - start, 1, pixel[ink]);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include "surface.h"
+
+// Size of the drawing in pixels, which can be bigger than the screen (see
+// view.c). The width must be a multiple of 64.
+#define CANVAS_WIDTH        4096
+#define CANVAS_HEIGHT       4096
+#define CANVAS_ROW_WORDS    (CANVAS_WIDTH / 64)
+
+// Colors used to show the canvas on the screen
+#define CANVAS_INK          BLACK
+#define CANVAS_PAPER        WHITE
+
+// The drawing, one bit per pixel (1 means ink). Pixel x of a row is bit
+// (x % 64) of word (x / 64), so the leftmost pixel is the lowest bit.
+extern unsigned long canvas[CANVAS_HEIGHT][CANVAS_ROW_WORDS];
+
+// Function prototypes
+void canvas_clear();
+void canvas_set(int x, int y);
+int canvas_get(int x, int y);
+int canvas_run_end(int x, int y, int ink);
+void canvas_present(struct Surface *s, int originX, int originY, int x, int y, int w, int h);
+
+#endif
@@ -0,0 +1,62 @@
+// This file computes CRC-32 checksums for data sent to the host. It uses a
+// 16 entry table and processes one 4-bit nibble per step, which is a good
+// trade-off between speed and table size for the amounts of data we send.
+
+#include "crc.h"
+
+// CRC-32 remainders of the 16 possible nibbles (reflected polynomial
+// 0xEDB88320)
+static const unsigned int crcTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       crc32_update
+//
+//  Arguments:      crc:       The CRC of the data so far (0 to start)
+//                  data:      Pointer to the next block of data
+//                  length:    Number of bytes in the block
+//
+//  Returns:        The CRC of all the data including this block
+//
+//  Description:    This function extends a CRC-32 with more data, so that
+//                  a checksum can be computed while data is being streamed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int crc32_update(unsigned int crc, const unsigned char *data, unsigned int length)
+{
+    crc = ~crc;
+
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crcTable[crc & 0xF];
+        crc = (crc >> 4) ^ crcTable[crc & 0xF];
+    }
+
+    return ~crc;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       crc32
+//
+//  Arguments:      data:      Pointer to the data
+//                  length:    Number of bytes
+//
+//  Returns:        The CRC-32 of the data
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int crc32(const unsigned char *data, unsigned int length)
+{
+    return crc32_update(0, data, length);
+}
@@ -0,0 +1,5 @@
+// Function prototypes for the CRC-32 checksum (the same one used by zlib,
+// PNG and Ethernet, so host tools can check data with standard libraries)
+
+unsigned int crc32_update(unsigned int crc, const unsigned char *data, unsigned int length);
+unsigned int crc32(const unsigned char *data, unsigned int length);
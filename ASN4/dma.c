@@ -0,0 +1,130 @@
+// The functions in this file hand out DMA channels and start transfers
+// described by control blocks. Channels are taken from the set that the
+// VideoCore firmware reports as free, so that they do not collide with
+// the channels used by the GPU.
+
+#include "dma.h"
+#include "mailbox.h"
+
+// Channels already handed out, and those the firmware left for the ARM
+static unsigned int claimed, available;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       dma_claim
+//
+//  Arguments:      none
+//
+//  Returns:        A free DMA channel number, or -1 if there is none
+//
+//  Description:    This function asks the firmware which DMA channels may
+//                  be used by the ARM (on the first call only), reserves
+//                  the highest-numbered free one, and resets it. Lite
+//                  channels are preferred, since the full channels are
+//                  better saved for memory-to-memory copies.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int dma_claim()
+{
+    int channel;
+
+    if (available == 0) {
+        mailbox_buffer[0] = 7 * 4;
+        mailbox_buffer[1] = MAILBOX_REQUEST;
+        mailbox_buffer[2] = TAG_GET_DMA_CHANNELS;
+        mailbox_buffer[3] = 4;
+        mailbox_buffer[4] = 0;
+        mailbox_buffer[5] = 0;    // Response: channel mask
+        mailbox_buffer[6] = TAG_LAST;
+
+        // Fall back to the channels the firmware normally leaves free
+        if (mailbox_query(CHANNEL_PROPERTY_TAGS_ARMTOVC) && mailbox_buffer[5] != 0)
+            available = mailbox_buffer[5];
+        else
+            available = 0x7F35;
+    }
+
+    for (channel = DMA_CHANNELS - 1; channel >= 0; channel--) {
+        if ((available & ~claimed) & (0x1 << channel)) {
+            claimed |= 0x1 << channel;
+
+            *DMA_ENABLE |= 0x1 << channel;
+            *DMA_CS(channel) = DMA_CS_RESET;
+            return channel;
+        }
+    }
+
+    return -1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       dma_start
+//
+//  Arguments:      channel:   Channel returned by dma_claim()
+//                  block:     First control block of the transfer
+//
+//  Returns:        void
+//
+//  Description:    This function starts a transfer on an idle channel. The
+//                  control block (and any blocks chained to it) must stay
+//                  in place until the transfer is finished.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void dma_start(int channel, struct DMAControlBlock *block)
+{
+    // Make sure the control block and data are in memory before the
+    // DMA engine reads them
+    asm volatile("dsb sy" ::: "memory");
+
+    // Clear the end flag and any error left from the last transfer
+    *DMA_CS(channel) = DMA_CS_END | DMA_CS_INT;
+    *DMA_DEBUG(channel) = 0x7;
+
+    *DMA_CONBLK_AD(channel) = DMA_BUS_ADDRESS(block);
+    *DMA_CS(channel) = DMA_CS_ACTIVE | DMA_CS_PRIORITY(8) |
+                       DMA_CS_PANIC_PRIORITY(15) | DMA_CS_WAIT_WRITES;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       dma_busy
+//
+//  Arguments:      channel:   Channel returned by dma_claim()
+//
+//  Returns:        TRUE (non-zero) while a transfer is running
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int dma_busy(int channel)
+{
+    return *DMA_CS(channel) & DMA_CS_ACTIVE;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       dma_wait
+//
+//  Arguments:      channel:   Channel returned by dma_claim()
+//
+//  Returns:        void
+//
+//  Description:    This function waits until the channel is idle.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void dma_wait(int channel)
+{
+    while (dma_busy(channel))
+        asm volatile("nop");
+}
@@ -0,0 +1,69 @@
+// The addresses of the DMA controller registers, and prototypes for the
+// functions in dma.c
+//
+// These are defined on pages 39 - 53 of the Broadcom BCM2837 ARM
+// Peripherals Manual. Each of the 15 channels has its own register block,
+// 0x100 bytes apart. Channels 0 - 6 are full channels and 7 - 14 are
+// "lite" channels, which are slower but fine for peripheral transfers.
+
+#ifndef DMA_H
+#define DMA_H
+
+#include "gpio.h"
+
+#define DMA_CHANNELS            15
+
+#define DMA_CS(ch)              ((volatile unsigned int *)(MMIO_BASE + 0x00007000 + (unsigned long)(ch) * 0x100))
+#define DMA_CONBLK_AD(ch)       ((volatile unsigned int *)(MMIO_BASE + 0x00007004 + (unsigned long)(ch) * 0x100))
+#define DMA_DEBUG(ch)           ((volatile unsigned int *)(MMIO_BASE + 0x00007020 + (unsigned long)(ch) * 0x100))
+#define DMA_INT_STATUS          ((volatile unsigned int *)(MMIO_BASE + 0x00007FE0))
+#define DMA_ENABLE              ((volatile unsigned int *)(MMIO_BASE + 0x00007FF0))
+
+// Control and Status register fields
+#define DMA_CS_ACTIVE           (0x1 << 0)
+#define DMA_CS_END              (0x1 << 1)
+#define DMA_CS_INT              (0x1 << 2)
+#define DMA_CS_ERROR            (0x1 << 8)
+#define DMA_CS_PRIORITY(p)      ((p) << 16)
+#define DMA_CS_PANIC_PRIORITY(p) ((p) << 20)
+#define DMA_CS_WAIT_WRITES      (0x1 << 28)
+#define DMA_CS_ABORT            (0x1 << 30)
+#define DMA_CS_RESET            (0x1u << 31)
+
+// Transfer Information fields (control block word 0)
+#define DMA_TI_INTEN            (0x1 << 0)
+#define DMA_TI_WAIT_RESP        (0x1 << 3)
+#define DMA_TI_DEST_INC         (0x1 << 4)
+#define DMA_TI_DEST_DREQ        (0x1 << 6)
+#define DMA_TI_SRC_INC          (0x1 << 8)
+#define DMA_TI_SRC_DREQ         (0x1 << 10)
+#define DMA_TI_PERMAP(p)        ((p) << 16)
+
+// Peripheral numbers for DMA_TI_PERMAP (DREQ sources)
+#define DMA_PERMAP_UART_TX      12
+#define DMA_PERMAP_UART_RX      14
+
+// The DMA engine sees memory through the VideoCore bus. With the ARM caches
+// off, the uncached 0xC0000000 alias is the right view of SDRAM, and
+// peripherals live at 0x7E000000.
+#define DMA_BUS_ADDRESS(p)      (0xC0000000 | (unsigned int)(unsigned long)(p))
+#define DMA_BUS_PERIPHERAL(p)   (((unsigned int)(unsigned long)(p) - MMIO_BASE) | 0x7E000000)
+
+// A DMA control block. The controller requires 32-byte alignment.
+struct DMAControlBlock {
+    unsigned int transferInfo;
+    unsigned int source;
+    unsigned int destination;
+    unsigned int length;
+    unsigned int stride;
+    unsigned int next;
+    unsigned int reserved[2];
+} __attribute__((aligned(32)));
+
+// Function prototypes
+int dma_claim();
+void dma_start(int channel, struct DMAControlBlock *block);
+int dma_busy(int channel);
+void dma_wait(int channel);
+
+#endif
@@ -0,0 +1,359 @@
+// The functions in this file flood-fill an area of paper on the canvas with
+// ink. The fill works on spans: a seed pixel is grown left and right to the
+// ink on either side, the whole span is inked a word at a time, and the
+// rows above and below the span are scanned for runs of paper, each of
+// which gives one new seed. Runs of ink and paper are skipped a word at a
+// time too (see canvas_run_end() in canvas.c), so the cost follows the
+// number of spans rather than the number of pixels.
+//
+// The seeds are kept on a fixed-size stack, taken from the scratch arena
+// for the length of the fill. If it fills up, further seeds
+// are dropped, and once the stack is empty the rows next to the filled
+// pixels are swept for paper that was missed, which seeds the fill again.
+// The filled pixels are tracked in a mask of their own for that sweep,
+// since they cannot be told apart from the ink that was already there.
+
+#include "canvas.h"
+#include "undo.h"
+#include "memory.h"
+#include "trace.h"
+#include "fill.h"
+
+// A pixel to fill from
+struct FillSeed
+{
+    unsigned short x;
+    unsigned short y;
+};
+
+static struct FillSeed *stack;
+static int depth, dropped;
+
+// Pixels inked by the current fill, and for each row the range of words
+// [rowLow, rowHigh] that has any (rowLow > rowHigh when there are none)
+static unsigned long (*filled)[CANVAS_ROW_WORDS];
+static unsigned short rowLow[CANVAS_HEIGHT], rowHigh[CANVAS_HEIGHT];
+static int topRow, bottomRow;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       push
+//
+//  Arguments:      x, y:      A paper pixel
+//
+//  Returns:        void
+//
+//  Description:    This function adds a seed to the stack, or notes that it
+//                  was dropped if the stack is full.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void push(int x, int y)
+{
+    if (depth == FILL_STACK_SIZE) {
+        dropped = 1;
+        return;
+    }
+
+    stack[depth].x = x;
+    stack[depth].y = y;
+    depth++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       paper_start
+//
+//  Arguments:      x, y:      A paper pixel
+//
+//  Returns:        The x coordinate of the leftmost pixel of the run of
+//                  paper that holds (x, y)
+//
+//  Description:    This function is the leftward version of
+//                  canvas_run_end(), and finds the nearest ink to the left
+//                  with a count leading zeros instruction.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int paper_start(int x, int y)
+{
+    int i = x >> 6;
+    unsigned long word = canvas[y][i] & (~0UL >> (63 - (x & 63)));
+
+    while (word == 0) {
+        if (i-- == 0)
+            return 0;
+        word = canvas[y][i];
+    }
+
+    return (i << 6) + 64 - __builtin_clzl(word);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       ink_span
+//
+//  Arguments:      y:         Row
+//                  start:     First pixel of the span
+//                  end:       Pixel after the span
+//
+//  Returns:        void
+//
+//  Description:    This function inks a span of paper a word at a time,
+//                  telling the undo history about each word first, and
+//                  records it in the mask of filled pixels.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void ink_span(int y, int start, int end)
+{
+    int i, last = (end - 1) >> 6;
+    unsigned long bits;
+
+    for (i = start >> 6; i <= last; i++) {
+        bits = ~0UL;
+        if (i == start >> 6)
+            bits &= ~0UL << (start & 63);
+        if (i == last)
+            bits &= ~0UL >> (63 - ((end - 1) & 63));
+
+        undo_touch(i << 6, y);
+        canvas[y][i] |= bits;
+        filled[y][i] |= bits;
+    }
+
+    if (start >> 6 < rowLow[y])
+        rowLow[y] = start >> 6;
+    if (last > rowHigh[y])
+        rowHigh[y] = last;
+    if (y < topRow)
+        topRow = y;
+    if (y > bottomRow)
+        bottomRow = y;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       seed_row
+//
+//  Arguments:      y:         Row to scan
+//                  start:     First pixel to scan
+//                  end:       Pixel after the last one to scan
+//
+//  Returns:        void
+//
+//  Description:    This function pushes one seed for each run of paper in
+//                  part of a row, which is next to a span just filled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void seed_row(int y, int start, int end)
+{
+    int x = start;
+
+    if (y < 0 || y >= CANVAS_HEIGHT)
+        return;
+
+    while (x < end) {
+        if (canvas_get(x, y)) {
+            x = canvas_run_end(x, y, 1);
+        } else {
+            push(x, y);
+            x = canvas_run_end(x, y, 0);
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drain
+//
+//  Arguments:      none
+//
+//  Returns:        The number of pixels filled
+//
+//  Description:    This function fills from the seeds on the stack until it
+//                  is empty. Seeds that were filled from another seed in the
+//                  meantime are skipped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int drain()
+{
+    int x, y, start, end, count = 0;
+
+    while (depth > 0) {
+        depth--;
+        x = stack[depth].x;
+        y = stack[depth].y;
+
+        if (canvas_get(x, y))
+            continue;
+
+        start = paper_start(x, y);
+        end = canvas_run_end(x, y, 0);
+        ink_span(y, start, end);
+        count += end - start;
+
+        seed_row(y - 1, start, end);
+        seed_row(y + 1, start, end);
+    }
+
+    return count;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       sweep
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function looks for paper directly above or below
+//                  filled pixels, which is left over when seeds were
+//                  dropped, and pushes a seed for each run of it.
+//                  Spans always reach the ink on both sides, so there is
+//                  never paper left or right of a filled pixel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void sweep()
+{
+    int y, i, low, high;
+    unsigned long next, paper;
+
+    for (y = topRow > 0 ? topRow - 1 : 0; y <= bottomRow + 1 && y < CANVAS_HEIGHT; y++) {
+        low = CANVAS_ROW_WORDS;
+        high = -1;
+        if (y > 0 && rowLow[y - 1] <= rowHigh[y - 1]) {
+            low = rowLow[y - 1];
+            high = rowHigh[y - 1];
+        }
+        if (y < CANVAS_HEIGHT - 1 && rowLow[y + 1] <= rowHigh[y + 1]) {
+            if (rowLow[y + 1] < low)
+                low = rowLow[y + 1];
+            if (rowHigh[y + 1] > high)
+                high = rowHigh[y + 1];
+        }
+
+        for (i = low; i <= high; i++) {
+            next = 0;
+            if (y > 0)
+                next |= filled[y - 1][i];
+            if (y < CANVAS_HEIGHT - 1)
+                next |= filled[y + 1][i];
+
+            // Seed the start of every run of such paper in the word
+            paper = next & ~canvas[y][i];
+            paper &= ~(paper << 1);
+            while (paper != 0) {
+                push((i << 6) + __builtin_ctzl(paper), y);
+                paper &= paper - 1;
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fill_region
+//
+//  Arguments:      x, y:      A pixel inside the area to fill
+//                  dirty:     Function called with each region of the
+//                             canvas that was changed, so that it can be
+//                             redrawn
+//
+//  Returns:        The number of pixels filled (0 if (x, y) is ink or
+//                  outside the canvas)
+//
+//  Description:    This function inks the area of paper, joined up through
+//                  the 4 neighbours of each pixel, that holds (x, y). The
+//                  changed regions are reported a band of UNDO_TILE_SIZE
+//                  rows at a time, each as wide as the fill is in that band.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int fill_region(int x, int y, void (*dirty)(int x, int y, int w, int h))
+{
+    int count, row, band, low, high;
+    unsigned long mark;
+
+    if (canvas_get(x, y) || x < 0 || y < 0 || x >= CANVAS_WIDTH || y >= CANVAS_HEIGHT)
+        return 0;
+
+    // The mask is taken from the heap the first time, and is left clear
+    // after each fill
+    if (filled == 0) {
+        filled = mem_alloc(sizeof(canvas), MEM_CACHE_LINE);
+        if (filled == 0)
+            return 0;
+        for (row = 0; row < CANVAS_HEIGHT; row++) {
+            for (low = 0; low < CANVAS_ROW_WORDS; low++)
+                filled[row][low] = 0;
+            rowLow[row] = CANVAS_ROW_WORDS;
+            rowHigh[row] = 0;
+        }
+    }
+
+    mark = arena_mark(&mem_scratch);
+    stack = arena_alloc(&mem_scratch, FILL_STACK_SIZE * sizeof(struct FillSeed), 0);
+    if (stack == 0)
+        return 0;
+
+    trace_begin(TRACE_FILL, 0);
+
+    topRow = CANVAS_HEIGHT;
+    bottomRow = -1;
+    depth = dropped = 0;
+
+    push(x, y);
+    count = drain();
+    while (dropped) {
+        dropped = 0;
+        sweep();
+        count += drain();
+    }
+
+    // Report the changes, and clear the mask of filled pixels
+    for (band = topRow / UNDO_TILE_SIZE * UNDO_TILE_SIZE; band <= bottomRow; band += UNDO_TILE_SIZE) {
+        low = CANVAS_ROW_WORDS;
+        high = -1;
+
+        for (row = band; row < band + UNDO_TILE_SIZE && row < CANVAS_HEIGHT; row++) {
+            if (rowLow[row] > rowHigh[row])
+                continue;
+            if (rowLow[row] < low)
+                low = rowLow[row];
+            if (rowHigh[row] > high)
+                high = rowHigh[row];
+
+            for (x = rowLow[row]; x <= rowHigh[row]; x++)
+                filled[row][x] = 0;
+            rowLow[row] = CANVAS_ROW_WORDS;
+            rowHigh[row] = 0;
+        }
+
+        if (high >= low)
+            dirty(low << 6, band, (high - low + 1) << 6, UNDO_TILE_SIZE);
+    }
+
+    arena_reset(&mem_scratch, mark);
+
+    trace_end(TRACE_FILL, count);
+    return count;
+}
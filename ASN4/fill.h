@@ -0,0 +1,11 @@
+#ifndef FILL_H
+#define FILL_H
+
+// Number of seeds the fill can hold at once. When there are more, the
+// extra ones are found again by sweeping over the filled rows afterwards.
+#define FILL_STACK_SIZE     4096
+
+// Function prototypes
+int fill_region(int x, int y, void (*dirty)(int x, int y, int w, int h));
+
+#endif
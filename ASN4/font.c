@@ -0,0 +1,254 @@
+// The functions in this file draw text into a surface using an embedded
+// 5 x 7 bitmap font. At initialization every glyph is expanded into a cell
+// of ready-made pixel rows in the surface's format, for one foreground and
+// one background color, so drawing a character is just copying ten short
+// rows with word-sized stores.
+
+#include "font.h"
+
+// Glyph bitmaps for ASCII 32 - 126. Each byte is one row of a glyph, with
+// the leftmost pixel in bit 4.
+static const unsigned char glyphs[FONT_NUM_GLYPHS][FONT_GLYPH_HEIGHT] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   // '!'
+    { 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '"'
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },   // '#'
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },   // '$'
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // '%'
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },   // '&'
+    { 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 },   // "'"
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   // '('
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   // ')'
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },   // '*'
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x08 },   // ','
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   // '.'
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // '/'
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // '0'
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // '1'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // '2'
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // '3'
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // '4'
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // '5'
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // '6'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // '7'
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // '8'
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // '9'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   // ':'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },   // ';'
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },   // '<'
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },   // '='
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },   // '>'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },   // '?'
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },   // '@'
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // 'A'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   // 'B'
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   // 'C'
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   // 'D'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   // 'E'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   // 'F'
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   // 'G'
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // 'H'
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 'I'
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   // 'J'
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // 'K'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   // 'L'
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   // 'M'
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // 'N'
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // 'O'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   // 'P'
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   // 'Q'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   // 'R'
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   // 'S'
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // 'T'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // 'U'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // 'V'
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   // 'W'
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   // 'X'
+    { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 },   // 'Y'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },   // 'Z'
+    { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },   // '['
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },   // '\\'
+    { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },   // ']'
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },   // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },   // '_'
+    { 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '`'
+    { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },   // 'a'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },   // 'b'
+    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },   // 'c'
+    { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },   // 'd'
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },   // 'e'
+    { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },   // 'f'
+    { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // 'g'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },   // 'h'
+    { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },   // 'i'
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },   // 'j'
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },   // 'k'
+    { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 'l'
+    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },   // 'm'
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },   // 'n'
+    { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },   // 'o'
+    { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },   // 'p'
+    { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },   // 'q'
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },   // 'r'
+    { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },   // 's'
+    { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },   // 't'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },   // 'u'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // 'v'
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },   // 'w'
+    { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },   // 'x'
+    { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // 'y'
+    { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },   // 'z'
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },   // '{'
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // '|'
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },   // '}'
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },   // '~'
+};
+
+// Pre-expanded glyph cells. A cell row is 8 pixels of up to 4 bytes each,
+// stored as 64-bit words so it can be copied without looking at the format.
+#define CELL_ROW_WORDS      (FONT_CELL_WIDTH * 4 / 8)
+
+static unsigned long cache[FONT_NUM_GLYPHS][FONT_CELL_HEIGHT][CELL_ROW_WORDS];
+static unsigned int cacheFormat;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       font_init
+//
+//  Arguments:      s:            Surface that text will be drawn on
+//                  foreground:   0x00RRGGBB color of the glyph pixels
+//                  background:   0x00RRGGBB color of the rest of the cell
+//
+//  Returns:        void
+//
+//  Description:    This function expands every glyph into its cell in the
+//                  glyph cache, using the pixel format of the surface. The
+//                  glyph is placed one pixel in from the top left corner of
+//                  the cell, so that adjacent characters do not touch. It
+//                  must be called again if the colors or the format change.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void font_init(struct Surface *s, unsigned int foreground, unsigned int background)
+{
+    unsigned int fg, bg, pixel, glyph, row, column, bits;
+    unsigned char *cell;
+
+    fg = surface_map_color(s, foreground);
+    bg = surface_map_color(s, background);
+    cacheFormat = s->format;
+
+    for (glyph = 0; glyph < FONT_NUM_GLYPHS; glyph++) {
+        for (row = 0; row < FONT_CELL_HEIGHT; row++) {
+            // Glyph row for this cell row, or an empty row for the border
+            bits = 0;
+            if (row >= 1 && row < 1 + FONT_GLYPH_HEIGHT)
+                bits = glyphs[glyph][row - 1];
+
+            cell = (unsigned char *)cache[glyph][row];
+
+            for (column = 0; column < FONT_CELL_WIDTH; column++) {
+                pixel = bg;
+                if (column >= 1 && column < 1 + FONT_GLYPH_WIDTH &&
+                    (bits & (0x10 >> (column - 1))))
+                    pixel = fg;
+
+                // Store the pixel in the surface's format
+                switch (cacheFormat) {
+                    case SURFACE_PAL8 :
+                    cell[column] = pixel;
+                    break;
+
+                    case SURFACE_RGB565 :
+                    ((unsigned short *)cell)[column] = pixel;
+                    break;
+
+                    default :
+                    ((unsigned int *)cell)[column] = pixel;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fb_draw_char
+//
+//  Arguments:      s:         Surface to draw on
+//                  x, y:      Top left corner of the character cell
+//                  c:         The character to draw
+//
+//  Returns:        void
+//
+//  Description:    This function copies the cached cell of one character
+//                  into the surface. Characters outside the font are drawn
+//                  as '?', and cells that do not fit entirely on the
+//                  surface are not drawn. When the cell starts on a 64-bit
+//                  boundary (x a multiple of 8 and an aligned pitch), each
+//                  row is copied a word at a time.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void fb_draw_char(struct Surface *s, int x, int y, char c)
+{
+    unsigned int glyph, row, i, words, bytes;
+    unsigned char *dst;
+    unsigned long *src;
+
+    if (x < 0 || y < 0 || x + FONT_CELL_WIDTH > (int)s->width ||
+        y + FONT_CELL_HEIGHT > (int)s->height)
+        return;
+
+    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR)
+        c = '?';
+    glyph = c - FONT_FIRST_CHAR;
+
+    bytes = FONT_CELL_WIDTH * cacheFormat / 8;
+    words = bytes / 8;
+    dst = (unsigned char *)s->base + y * s->pitch + x * cacheFormat / 8;
+
+    for (row = 0; row < FONT_CELL_HEIGHT; row++, dst += s->pitch) {
+        src = cache[glyph][row];
+
+        if (((unsigned long)dst & 0x7) == 0) {
+            for (i = 0; i < words; i++)
+                ((unsigned long *)dst)[i] = src[i];
+        } else {
+            for (i = 0; i < bytes; i++)
+                dst[i] = ((unsigned char *)src)[i];
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fb_draw_text
+//
+//  Arguments:      s:         Surface to draw on
+//                  x, y:      Top left corner of the first character cell
+//                  text:      Null terminated string
+//
+//  Returns:        void
+//
+//  Description:    This function draws a string on a single line, one
+//                  character cell after another.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void fb_draw_text(struct Surface *s, int x, int y, char *text)
+{
+    while (*text) {
+        fb_draw_char(s, x, y, *text++);
+        x += FONT_CELL_WIDTH;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include "surface.h"
+
+// Size of the embedded glyphs, and of the cell each one is drawn in. The
+// cell is 8 pixels wide so that a glyph row is a whole number of 64-bit
+// words in every surface format.
+#define FONT_GLYPH_WIDTH    5
+#define FONT_GLYPH_HEIGHT   7
+#define FONT_CELL_WIDTH     8
+#define FONT_CELL_HEIGHT    10
+
+// Printable ASCII range covered by the font
+#define FONT_FIRST_CHAR     32
+#define FONT_LAST_CHAR      126
+#define FONT_NUM_GLYPHS     (FONT_LAST_CHAR - FONT_FIRST_CHAR + 1)
+
+// Function prototypes
+void font_init(struct Surface *s, unsigned int foreground, unsigned int background);
+void fb_draw_char(struct Surface *s, int x, int y, char c);
+void fb_draw_text(struct Surface *s, int x, int y, char *text);
+
+#endif
@@ -0,0 +1,254 @@
+// The functions in this file implement a fixed-timestep frame scheduler.
+// Deadlines are absolute generic timer counter values spaced one period
+// apart, so the frame rate does not drift with the amount of work done in
+// a frame. A frame that overruns its deadline causes the missed deadlines
+// to be skipped instead of running several short frames back to back.
+// While waiting, the CPU sleeps with wfi and is woken by its own generic
+// timer (see timebase.c).
+
+#include "uart.h"
+#include "sysreg.h"
+#include "timebase.h"
+#include "trace.h"
+#include "frame.h"
+
+// Scheduler state, in generic timer ticks
+static unsigned long framePeriod;
+static unsigned long frameDeadline;
+static unsigned long frameStart;
+
+// Accumulated statistics, in microseconds
+static unsigned int frames, missed;
+static unsigned int minFrame, maxFrame, maxWork;
+static unsigned long totalFrame, totalWork, totalIdle;
+
+// Frame length smoothed over roughly the last 16 frames, in microseconds
+static unsigned int smoothFrame;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_init
+//
+//  Arguments:      rate:     Target number of frames per second
+//
+//  Returns:        void
+//
+//  Description:    This function starts the frame scheduler. The first
+//                  deadline is one period from now. The calling core's
+//                  generic timer is used for the wake-up interrupt, so IRQs
+//                  must be enabled for frame_wait() to sleep.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void frame_init(unsigned int rate)
+{
+    timebase_init();
+
+    framePeriod = timebase_frequency() / rate;
+    frameStart = timebase_ticks();
+    frameDeadline = frameStart + framePeriod;
+
+    frame_reset_stats();
+    trace_begin(TRACE_FRAME, 0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_wait
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function ends the current frame. It accounts the
+//                  time spent working since the frame started, moves the
+//                  deadline forward (skipping any deadlines that have
+//                  already passed), and then sleeps until the deadline is
+//                  reached. The next frame starts when it returns.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void frame_wait()
+{
+    unsigned long now, start, skipped;
+    unsigned int work;
+
+    now = timebase_ticks();
+    trace_end(TRACE_FRAME, frames);
+
+    work = ticks_to_us(now - frameStart);
+    totalWork += work;
+    if (work > maxWork)
+        maxWork = work;
+
+    // If the frame overran, drop the deadlines we can no longer meet
+    if (now >= frameDeadline) {
+        skipped = (now - frameDeadline) / framePeriod + 1;
+        frameDeadline += skipped * framePeriod;
+        missed += skipped;
+    }
+
+    // Wake up from the timer at the deadline. Other interrupts (such as
+    // the SNES sampler) also end the wfi, so keep sleeping until the
+    // deadline has actually been reached. IRQs are masked around the check
+    // so that an interrupt arriving just before wfi still wakes us.
+    timer_set_deadline(frameDeadline);
+    trace_begin(TRACE_IDLE, 0);
+
+    start = now;
+    while (1) {
+        disableIRQ();
+        now = timebase_ticks();
+        if (now >= frameDeadline)
+            break;
+
+        asm volatile("wfi");
+        enableIRQ();
+    }
+    timer_cancel();
+    enableIRQ();
+    trace_end(TRACE_IDLE, 0);
+
+    totalIdle += ticks_to_us(now - start);
+
+    // Start the next frame
+    if (frames > 0) {
+        unsigned int length = ticks_to_us(now - frameStart);
+
+        totalFrame += length;
+        if (length < minFrame)
+            minFrame = length;
+        if (length > maxFrame)
+            maxFrame = length;
+
+        smoothFrame = smoothFrame ? (smoothFrame * 15 + length) / 16 : length;
+    }
+
+    frames++;
+    frameStart = now;
+    frameDeadline += framePeriod;
+    trace_begin(TRACE_FRAME, frames);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_get_stats
+//
+//  Arguments:      stats:     Where to store the statistics
+//
+//  Returns:        void
+//
+//  Description:    This function computes the frame time statistics
+//                  accumulated since the last reset.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void frame_get_stats(struct FrameStats *stats)
+{
+    stats->frames = frames;
+    stats->missed = missed;
+    stats->period = ticks_to_us(framePeriod);
+    stats->minFrame = frames > 1 ? minFrame : 0;
+    stats->avgFrame = frames > 1 ? totalFrame / (frames - 1) : 0;
+    stats->maxFrame = maxFrame;
+    stats->avgWork = frames > 0 ? totalWork / frames : 0;
+    stats->maxWork = maxWork;
+    stats->avgIdle = frames > 0 ? totalIdle / frames : 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_fps
+//
+//  Arguments:      none
+//
+//  Returns:        The current frame rate in frames per second
+//
+//  Description:    This function derives the frame rate from a moving
+//                  average of recent frame lengths, so that it follows
+//                  changes quickly without jumping every frame.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int frame_fps()
+{
+    return smoothFrame ? 1000000 / smoothFrame : 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_reset_stats
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function clears the accumulated statistics.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void frame_reset_stats()
+{
+    frames = missed = 0;
+    minFrame = 0xFFFFFFFF;
+    maxFrame = maxWork = 0;
+    totalFrame = totalWork = totalIdle = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       frame_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function prints the frame time statistics to the
+//                  UART terminal, with all times in microseconds.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void frame_report()
+{
+    struct FrameStats stats;
+
+    frame_get_stats(&stats);
+
+    uart_puts("\nFrames: ");
+    uart_putdec(stats.frames);
+    uart_puts("  missed: ");
+    uart_putdec(stats.missed);
+    uart_puts("  period: ");
+    uart_putdec(stats.period);
+    uart_puts(" us\n");
+
+    uart_puts("    frame time   min ");
+    uart_putdec(stats.minFrame);
+    uart_puts("  avg ");
+    uart_putdec(stats.avgFrame);
+    uart_puts("  max ");
+    uart_putdec(stats.maxFrame);
+    uart_puts("\n");
+
+    uart_puts("    work         avg ");
+    uart_putdec(stats.avgWork);
+    uart_puts("  max ");
+    uart_putdec(stats.maxWork);
+    uart_puts("\n");
+
+    uart_puts("    idle         avg ");
+    uart_putdec(stats.avgIdle);
+    uart_puts("\n");
+}
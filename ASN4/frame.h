@@ -0,0 +1,27 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+// Frame time statistics since the scheduler was started or last reset.
+// All times are in microseconds.
+struct FrameStats
+{
+    unsigned int frames;        // Frames completed
+    unsigned int missed;        // Deadlines skipped because a frame overran
+    unsigned int period;        // Target frame period
+    unsigned int minFrame;      // Shortest time between two frame starts
+    unsigned int avgFrame;
+    unsigned int maxFrame;
+    unsigned int avgWork;       // Time spent between frame start and wait
+    unsigned int maxWork;
+    unsigned int avgIdle;       // Time spent waiting for the deadline
+};
+
+// Function prototypes
+void frame_init(unsigned int rate);
+void frame_wait();
+void frame_get_stats(struct FrameStats *stats);
+unsigned int frame_fps();
+void frame_reset_stats();
+void frame_report();
+
+#endif
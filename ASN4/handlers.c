@@ -0,0 +1,63 @@
+// This file contains C functions to handle particular kinds of exceptions.
+// Only a function to handle IRQ exceptions is currently implemented.
+
+// Header files
+#include "irq.h"
+#include "snes.h"
+#include "timebase.h"
+#include "sysreg.h"
+#include "uart.h"
+#include "profile.h"
+#include "trace.h"
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       IRQ_handler
+//
+//  Arguments:      registers:  The general purpose registers of the
+//                              interrupted code, as saved by the IRQ stub
+//                              in start.s (see IRQ_FRAME_X29 in irq.h)
+//
+//  Returns:        void
+//
+//  Description:    This function determines the source of a pending IRQ
+//                  and calls the code that services it. The sources are
+//                  System Timer channel 1, which drives the background SNES
+//                  controller sampler, the core's generic timer, which
+//                  wakes the frame scheduler, the ARM Timer, which drives the
+//                  sampling profiler, and the PL011 UART when it is used
+//                  as the console.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void IRQ_handler(unsigned long *registers)
+{
+    trace_irq_enter(*IRQ_PENDING_1);
+
+    // Handle the System Timer channel 1 compare match
+    if (*IRQ_PENDING_1 & SYSTEM_TIMER_IRQ_1) {
+        snes_sampler_tick();
+    }
+
+    // Handle this core's generic timer, which wakes the frame scheduler
+    if (*LOCAL_IRQ_SOURCE(getCoreID()) & LOCAL_CNTPNS_IRQ) {
+        timer_irq_handler();
+    }
+
+    // Handle the ARM Timer, which takes a profiler sample
+    if (*IRQ_BASIC_PENDING & ARM_TIMER_IRQ) {
+        profile_tick(registers);
+    }
+
+    // Handle the PL011 UART (only enabled when it is the console)
+    if (*IRQ_PENDING_2 & UART0_IRQ) {
+        uart_irq_handler();
+    }
+
+    trace_irq_exit();
+
+    // Return to the IRQ exception handler stub
+    return;
+}
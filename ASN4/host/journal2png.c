@@ -0,0 +1,493 @@
+// This host tool decodes a stroke journal sent by the Etch-A-Sketch (the
+// 'j' UART command) and renders it to a PNG image. The input is a raw
+// capture of the serial port; any text before the journal is skipped.
+//
+// Undo and redo are played back with a history of their own: each step is
+// kept as the list of pixels it changed, and undoing or redoing it flips
+// them. Like undo.c, a step begins at the first change after a step
+// record, a step that ends up changing nothing is dropped, and a new step
+// drops the steps that could be redone.
+//
+// Usage:  journal2png capture.bin drawing.png
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../crc.h"
+#include "../journal.h"
+#include "../brush.h"
+#include "png.h"
+
+// Step of each direction code, as in journal.c
+static const int stepX[8] = {  0,  1,  1,  1,  0, -1, -1, -1 };
+static const int stepY[8] = { -1, -1,  0,  1,  1,  1,  0, -1 };
+
+static unsigned char *pixels;
+static unsigned int width, height;
+
+// The pixels each brush size inks, indexed by size - 1, and the size in use
+static unsigned char brushes[BRUSH_MAX_SIZE][BRUSH_MAX_SIZE][BRUSH_MAX_SIZE];
+static int brushSize;
+
+// The undo history. The pixels changed by step i are held in
+// changes[stepStart[i]] up to changes[stepStart[i + 1]]; steps before the
+// cursor can be undone and those after it redone. While a step is open,
+// original holds 1 + the old value of each pixel it has changed so far
+// (0 for the others).
+static unsigned int *changes, changeCount, changeSize;
+static unsigned int *stepStart, stepCount, stepSize, cursor;
+static unsigned char *original;
+static int stepOpen;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       grow
+//
+//  Arguments:      array:     Array to make room in
+//                  size:      Number of elements it has room for
+//                  count:     Number of elements it must have room for
+//
+//  Returns:        void
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void grow(unsigned int **array, unsigned int *size, unsigned int count)
+{
+    if (count <= *size)
+        return;
+
+    *size = count * 2;
+    *array = realloc(*array, *size * sizeof(**array));
+    if (*array == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       set_pixel
+//
+//  Arguments:      index:     Pixel to change (y * width + x)
+//                  value:     1 for ink, 0 for paper
+//
+//  Returns:        void
+//
+//  Description:    This function changes a pixel, adding it to the open
+//                  step. The first change opens a step, dropping the steps
+//                  that could be redone.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void set_pixel(unsigned int index, int value)
+{
+    if (pixels[index] == value)
+        return;
+
+    if (!stepOpen) {
+        stepCount = cursor;
+        changeCount = stepStart[cursor];
+        stepOpen = 1;
+    }
+
+    if (original[index] == 0) {
+        original[index] = 1 + pixels[index];
+        grow(&changes, &changeSize, changeCount + 1);
+        changes[changeCount++] = index;
+    }
+
+    pixels[index] = value;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       close_step
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function ends the open step, keeping only the
+//                  pixels that differ from before it. A step that changed
+//                  nothing is dropped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void close_step()
+{
+    unsigned int i, index, kept;
+
+    if (!stepOpen)
+        return;
+    stepOpen = 0;
+
+    kept = stepStart[cursor];
+    for (i = kept; i < changeCount; i++) {
+        index = changes[i];
+        if (pixels[index] + 1 != original[index])
+            changes[kept++] = index;
+        original[index] = 0;
+    }
+    changeCount = kept;
+
+    if (changeCount == stepStart[cursor])
+        return;
+
+    cursor++;
+    stepCount = cursor;
+    grow(&stepStart, &stepSize, stepCount + 1);
+    stepStart[stepCount] = changeCount;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       flip_step
+//
+//  Arguments:      step:      Step to undo or redo
+//
+//  Returns:        void
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void flip_step(unsigned int step)
+{
+    unsigned int i;
+
+    for (i = stepStart[step]; i < stepStart[step + 1]; i++)
+        pixels[changes[i]] ^= 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       make_brushes
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function works out which pixels each brush size
+//                  inks, the same way as brush_init() and brush_mark() in
+//                  brush.c: those that the circle covers at least half of.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void make_brushes()
+{
+    int size, row, col, i, j, u, v, centre, inside;
+
+    for (size = 1; size <= BRUSH_MAX_SIZE; size++) {
+        centre = size * BRUSH_SAMPLES;
+
+        for (row = 0; row < size; row++) {
+            for (col = 0; col < size; col++) {
+                inside = 0;
+                for (i = 0; i < BRUSH_SAMPLES; i++) {
+                    for (j = 0; j < BRUSH_SAMPLES; j++) {
+                        u = (col * BRUSH_SAMPLES + j) * 2 + 1 - centre;
+                        v = (row * BRUSH_SAMPLES + i) * 2 + 1 - centre;
+                        if (u * u + v * v <= centre * centre)
+                            inside++;
+                    }
+                }
+
+                if (size == 1)
+                    inside = BRUSH_SAMPLES * BRUSH_SAMPLES;
+
+                brushes[size - 1][row][col] =
+                    (inside * 255 + BRUSH_SAMPLES * BRUSH_SAMPLES / 2) /
+                    (BRUSH_SAMPLES * BRUSH_SAMPLES) >= 128;
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       plot
+//
+//  Arguments:      x, y:      Centre of the brush
+//
+//  Returns:        void
+//
+//  Description:    This function stamps the brush in use at a pen
+//                  position.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void plot(int x, int y)
+{
+    int row, col, left = x - brushSize / 2, top = y - brushSize / 2;
+
+    for (row = 0; row < brushSize; row++) {
+        for (col = 0; col < brushSize; col++) {
+            if (left + col >= 0 && top + row >= 0 && left + col < (int)width &&
+                top + row < (int)height && brushes[brushSize - 1][row][col])
+                set_pixel((top + row) * width + left + col, 1);
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fill
+//
+//  Arguments:      x, y:      Paper pixel to start from
+//
+//  Returns:        void
+//
+//  Description:    This function inks the paper connected to a pixel
+//                  through its four neighbours, as fill.c does on the
+//                  Etch-A-Sketch. Pixels are inked as they are pushed, so
+//                  each is pushed at most once.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void fill(int x, int y)
+{
+    static const int dx[4] = { 1, -1, 0, 0 };
+    static const int dy[4] = { 0, 0, 1, -1 };
+    unsigned int *stack = NULL, size = 0, depth = 0, index;
+    int i, nx, ny;
+
+    if (x < 0 || y < 0 || x >= (int)width || y >= (int)height ||
+        pixels[y * width + x])
+        return;
+
+    grow(&stack, &size, 1);
+    set_pixel(y * width + x, 1);
+    stack[depth++] = y * width + x;
+
+    while (depth > 0) {
+        index = stack[--depth];
+        for (i = 0; i < 4; i++) {
+            nx = index % width + dx[i];
+            ny = index / width + dy[i];
+            if (nx < 0 || ny < 0 || nx >= (int)width || ny >= (int)height ||
+                pixels[ny * width + nx])
+                continue;
+            set_pixel(ny * width + nx, 1);
+            grow(&stack, &size, depth + 1);
+            stack[depth++] = ny * width + nx;
+        }
+    }
+
+    free(stack);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_varint
+//
+//  Arguments:      p:         Cursor into the records; advanced past the
+//                             number
+//                  end:       End of the records
+//
+//  Returns:        The decoded number
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int get_varint(const unsigned char **p, const unsigned char *end)
+{
+    unsigned int value = 0, shift = 0;
+    unsigned char byte;
+
+    do {
+        if (*p >= end)
+            return value;
+        byte = *(*p)++;
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return value;
+}
+
+
+
+static unsigned int get_le(const unsigned char *p, int bytes)
+{
+    unsigned int value = 0;
+
+    while (bytes--)
+        value = (value << 8) | p[bytes];
+
+    return value;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    FILE *file;
+    unsigned char *data, *start;
+    const unsigned char *p, *end;
+    long size;
+    unsigned int length, crc, opcode, runLength, records = 0, steps = 0, i;
+    unsigned int undos = 0, redos = 0, fills = 0;
+    unsigned int elapsed = 0;
+    int x, y, seedX, seedY, direction;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s capture.bin drawing.png\n", argv[0]);
+        return 2;
+    }
+
+    // Read the whole capture
+    file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size + 1);
+    if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "%s: read error\n", argv[1]);
+        return 1;
+    }
+    fclose(file);
+
+    // Find the journal header
+    start = NULL;
+    for (i = 0; i + 18 <= (unsigned int)size; i++) {
+        if (memcmp(data + i, JOURNAL_MAGIC, 4) == 0) {
+            start = data + i + 4;
+            break;
+        }
+    }
+    if (start == NULL) {
+        fprintf(stderr, "%s: no journal found\n", argv[1]);
+        return 1;
+    }
+
+    width = get_le(start, 2);
+    height = get_le(start + 2, 2);
+    x = get_le(start + 4, 2);
+    y = get_le(start + 6, 2);
+    brushSize = get_le(start + 8, 2);
+    length = get_le(start + 10, 4);
+
+    if (start + 14 + length + 4 > data + size) {
+        fprintf(stderr, "%s: journal is truncated\n", argv[1]);
+        return 1;
+    }
+
+    crc = crc32(start, 14 + length);
+    if (crc != get_le(start + 14 + length, 4)) {
+        fprintf(stderr, "%s: checksum mismatch\n", argv[1]);
+        return 1;
+    }
+
+    pixels = calloc(width * height, 1);
+    original = calloc(width * height, 1);
+    grow(&stepStart, &stepSize, 1);
+    stepStart[0] = 0;
+    if (pixels == NULL || original == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    if (brushSize < 1 || brushSize > BRUSH_MAX_SIZE) {
+        fprintf(stderr, "%s: bad brush size %d\n", argv[1], brushSize);
+        return 1;
+    }
+
+    // Decode the records, drawing the pen path
+    make_brushes();
+    plot(x, y);
+    p = start + 14;
+    end = p + length;
+
+    while (p < end) {
+        opcode = *p++;
+        records++;
+
+        if (opcode < JOURNAL_ERASE) {
+            direction = (opcode >> 4) & 0x7;
+            runLength = (opcode & 0xF) + 1;
+            if (runLength == 16)
+                runLength += get_varint(&p, end);
+
+            elapsed += get_varint(&p, end);
+            get_varint(&p, end);    // Duration is only needed for replay
+
+            for (i = 0; i < runLength; i++) {
+                x += stepX[direction];
+                y += stepY[direction];
+                plot(x, y);
+            }
+            steps += runLength;
+        } else if (opcode == JOURNAL_ERASE) {
+            elapsed += get_varint(&p, end);
+            for (i = 0; i < width * height; i++)
+                set_pixel(i, 0);
+        } else if (opcode == JOURNAL_STEP) {
+            elapsed += get_varint(&p, end);
+            close_step();
+        } else if (opcode == JOURNAL_FILL) {
+            seedX = get_varint(&p, end);
+            seedY = get_varint(&p, end);
+            elapsed += get_varint(&p, end);
+            fill(seedX, seedY);
+            fills++;
+        } else if (opcode == JOURNAL_BRUSH) {
+            brushSize = get_varint(&p, end);
+            elapsed += get_varint(&p, end);
+            if (brushSize < 1 || brushSize > BRUSH_MAX_SIZE) {
+                fprintf(stderr, "bad brush size %d\n", brushSize);
+                return 1;
+            }
+        } else if (opcode == JOURNAL_PEN || opcode == JOURNAL_UNDO ||
+                   opcode == JOURNAL_REDO) {
+            x = get_varint(&p, end);
+            y = get_varint(&p, end);
+            elapsed += get_varint(&p, end);
+
+            // Undo and redo end the open step first, as undo.c does
+            if (opcode == JOURNAL_UNDO) {
+                close_step();
+                if (cursor > 0)
+                    flip_step(--cursor);
+                undos++;
+            } else if (opcode == JOURNAL_REDO) {
+                close_step();
+                if (cursor < stepCount)
+                    flip_step(cursor++);
+                redos++;
+            }
+        } else {
+            fprintf(stderr, "unknown record 0x%02X\n", opcode);
+            return 1;
+        }
+    }
+
+    if (png_write_bitmap(argv[2], pixels, width, height) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    printf("%u bytes, %u records, %u pen steps, %u fills, %u undos, %u redos "
+           "over %u.%03u s -> %s (%ux%u)\n",
+           length, records, steps, fills, undos, redos,
+           elapsed / 1000, elapsed % 1000, argv[2], width, height);
+
+    return 0;
+}
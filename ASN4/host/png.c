@@ -0,0 +1,179 @@
+// This file writes black and white PNG images for the host tools. The
+// image data is stored in uncompressed deflate blocks, which keeps the
+// writer small and free of dependencies; at one bit per pixel a full
+// 1024 x 768 screen is still under 100 KB.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../crc.h"
+#include "png.h"
+
+// Largest payload of a stored deflate block
+#define STORED_BLOCK_MAX    65535
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_be32
+//
+//  Arguments:      p:         Where to write
+//                  value:     Number to write in big-endian order
+//
+//  Returns:        void
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_be32(unsigned char *p, unsigned int value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       write_chunk
+//
+//  Arguments:      file:      Output file
+//                  type:      Four letter chunk type
+//                  data:      Chunk payload
+//                  length:    Number of payload bytes
+//
+//  Returns:        void
+//
+//  Description:    This function writes one PNG chunk with its length and
+//                  CRC. The CRC covers the type and the payload.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void write_chunk(FILE *file, const char *type, const unsigned char *data,
+                        unsigned int length)
+{
+    unsigned char word[4];
+    unsigned int crc;
+
+    put_be32(word, length);
+    fwrite(word, 1, 4, file);
+    fwrite(type, 1, 4, file);
+    fwrite(data, 1, length, file);
+
+    crc = crc32_update(0, (const unsigned char *)type, 4);
+    crc = crc32_update(crc, data, length);
+    put_be32(word, crc);
+    fwrite(word, 1, 4, file);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       png_write_bitmap
+//
+//  Arguments:      path:      Output file name
+//                  pixels:    width * height bytes, non-zero for ink
+//                  width:     Image width in pixels
+//                  height:    Image height in pixels
+//
+//  Returns:        0 on success, -1 on failure
+//
+//  Description:    This function packs the bitmap into 1-bit grayscale rows
+//                  (each preceded by filter type 0), wraps them in a zlib
+//                  stream made of stored blocks, and writes the PNG file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int png_write_bitmap(const char *path, const unsigned char *pixels,
+                     unsigned int width, unsigned int height)
+{
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    unsigned char header[13];
+    unsigned char *raw, *zlib, *out;
+    unsigned int rowBytes, rawLength, blocks, zlibLength, block, i, x, y;
+    unsigned int a = 1, b = 0;
+    FILE *file;
+
+    // Pack the rows: 1 bit per pixel, most significant bit first, 1 = white
+    rowBytes = (width + 7) / 8;
+    rawLength = (rowBytes + 1) * height;
+    raw = calloc(rawLength, 1);
+    if (raw == NULL)
+        return -1;
+
+    for (y = 0; y < height; y++) {
+        unsigned char *row = raw + y * (rowBytes + 1) + 1;
+
+        for (x = 0; x < width; x++)
+            if (!pixels[y * width + x])
+                row[x / 8] |= 0x80 >> (x % 8);
+    }
+
+    // Wrap the rows in a zlib stream of stored deflate blocks
+    blocks = (rawLength + STORED_BLOCK_MAX - 1) / STORED_BLOCK_MAX;
+    if (blocks == 0)
+        blocks = 1;
+    zlibLength = 2 + blocks * 5 + rawLength + 4;
+    zlib = malloc(zlibLength);
+    if (zlib == NULL) {
+        free(raw);
+        return -1;
+    }
+
+    out = zlib;
+    *out++ = 0x78;      // Deflate with a 32 KB window
+    *out++ = 0x01;      // No preset dictionary, fastest compression
+
+    for (i = 0; i < rawLength || i == 0; i += block) {
+        block = rawLength - i;
+        if (block > STORED_BLOCK_MAX)
+            block = STORED_BLOCK_MAX;
+
+        *out++ = (i + block == rawLength) ? 1 : 0;  // Final block flag
+        *out++ = block & 0xFF;
+        *out++ = block >> 8;
+        *out++ = ~block & 0xFF;
+        *out++ = (~block >> 8) & 0xFF;
+
+        for (x = 0; x < block; x++) {
+            *out++ = raw[i + x];
+            a = (a + raw[i + x]) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        if (rawLength == 0)
+            break;
+    }
+
+    put_be32(out, (b << 16) | a);
+    out += 4;
+
+    // Write the file
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        free(raw);
+        free(zlib);
+        return -1;
+    }
+
+    put_be32(header, width);
+    put_be32(header + 4, height);
+    header[8] = 1;      // Bit depth
+    header[9] = 0;      // Grayscale
+    header[10] = 0;     // Deflate compression
+    header[11] = 0;     // Adaptive filtering
+    header[12] = 0;     // No interlace
+
+    fwrite(signature, 1, 8, file);
+    write_chunk(file, "IHDR", header, 13);
+    write_chunk(file, "IDAT", zlib, out - zlib);
+    write_chunk(file, "IEND", NULL, 0);
+
+    free(raw);
+    free(zlib);
+
+    return fclose(file) == 0 ? 0 : -1;
+}
@@ -0,0 +1,6 @@
+// Function prototype for writing a 1-bit black and white PNG image
+
+// The bitmap has one byte per pixel: non-zero for ink (black), zero for
+// paper (white). Returns 0 on success and -1 if the file can't be written.
+int png_write_bitmap(const char *path, const unsigned char *pixels,
+                     unsigned int width, unsigned int height);
@@ -0,0 +1,246 @@
+// This host tool turns a profile sent by the Etch-A-Sketch (the 'X' UART
+// command) into a flat profile of samples per function, using the symbols
+// in the disassembly listing that the Makefile writes to kernel8.dump.
+// With a third argument it also writes the samples as folded stacks, one
+// line per stack of the form "main;drawBrush;brush_stamp 42", which flame
+// graph tools such as flamegraph.pl read. The input is a capture of the
+// serial port; any text around the profile is skipped.
+//
+// Usage:  profsym kernel8.dump capture.txt [folded.txt]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../profile.h"
+
+// A function in the program, and the samples that landed in it
+struct Symbol
+{
+    unsigned long address;
+    char name[64];
+    unsigned long self;
+    unsigned long total;
+    unsigned long seen;     // Last sample line that counted it in total
+};
+
+static struct Symbol *symbols;
+static unsigned int symbolCount;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       by_address, by_self
+//
+//  Description:    Sort orders for the symbol table: by address, and by
+//                  samples in the function itself, most first.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int by_address(const void *a, const void *b)
+{
+    const struct Symbol *x = a, *y = b;
+
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static int by_self(const void *a, const void *b)
+{
+    const struct Symbol *x = a, *y = b;
+
+    if (x->self != y->self)
+        return x->self < y->self ? 1 : -1;
+    return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       read_symbols
+//
+//  Arguments:      path:      The objdump listing
+//
+//  Returns:        0 on success, -1 if the file cannot be read
+//
+//  Description:    This function collects the labels objdump prints before
+//                  each function, such as "0000000000080000 <_start>:".
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int read_symbols(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[512], name[64];
+    unsigned long address;
+    unsigned int capacity = 0;
+
+    if (file == NULL)
+        return -1;
+
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%lx <%63[^>]>:", &address, name) != 2)
+            continue;
+
+        if (symbolCount == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            symbols = realloc(symbols, capacity * sizeof(struct Symbol));
+            if (symbols == NULL) {
+                fclose(file);
+                return -1;
+            }
+        }
+
+        memset(&symbols[symbolCount], 0, sizeof(struct Symbol));
+        symbols[symbolCount].address = address;
+        strcpy(symbols[symbolCount].name, name);
+        symbolCount++;
+    }
+
+    fclose(file);
+    qsort(symbols, symbolCount, sizeof(struct Symbol), by_address);
+    return 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       lookup
+//
+//  Arguments:      address:   A code address
+//
+//  Returns:        The symbol the address falls in, or NULL if it is before
+//                  the first one
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static struct Symbol *lookup(unsigned long address)
+{
+    unsigned int low = 0, high = symbolCount, middle;
+
+    while (low < high) {
+        middle = (low + high) / 2;
+        if (symbols[middle].address <= address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low ? &symbols[low - 1] : NULL;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    FILE *file, *folded = NULL;
+    char line[1024], *p, *next, name[32];
+    unsigned long count, address, stack[PROFILE_MAX_DEPTH], samples = 0, lines = 0;
+    unsigned int rate = 0, depth, i, started = 0, done = 0;
+    struct Symbol *symbol;
+
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "usage: %s kernel8.dump capture.txt [folded.txt]\n", argv[0]);
+        return 2;
+    }
+
+    if (read_symbols(argv[1]) != 0 || symbolCount == 0) {
+        fprintf(stderr, "%s: no symbols found\n", argv[1]);
+        return 1;
+    }
+
+    file = fopen(argv[2], "r");
+    if (file == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    if (argc == 4) {
+        folded = fopen(argv[3], "w");
+        if (folded == NULL) {
+            perror(argv[3]);
+            return 1;
+        }
+    }
+
+    while (!done && fgets(line, sizeof(line), file)) {
+        if (!started) {
+            p = strstr(line, "#PROFILE");
+            if (p != NULL && sscanf(p, "#PROFILE %u", &rate) == 1)
+                started = 1;
+            continue;
+        }
+
+        if (strncmp(line, "#END", 4) == 0) {
+            done = 1;
+            break;
+        }
+
+        // A sample line: count, then addresses innermost first
+        count = strtoul(line, &next, 10);
+        if (next == line || count == 0)
+            continue;
+
+        for (depth = 0, p = next; depth < PROFILE_MAX_DEPTH; depth++, p = next) {
+            address = strtoul(p, &next, 16);
+            if (next == p)
+                break;
+            stack[depth] = address;
+        }
+        if (depth == 0)
+            continue;
+
+        samples += count;
+        lines++;
+
+        for (i = 0; i < depth; i++) {
+            // Return addresses point after the call, which may be the
+            // first instruction of the next function
+            symbol = lookup(i == 0 ? stack[i] : stack[i] - 4);
+            if (symbol == NULL)
+                continue;
+            if (i == 0)
+                symbol->self += count;
+            if (symbol->seen != lines) {
+                symbol->total += count;
+                symbol->seen = lines;
+            }
+        }
+
+        if (folded != NULL) {
+            for (i = depth; i-- > 0;) {
+                symbol = lookup(i == 0 ? stack[i] : stack[i] - 4);
+                if (symbol == NULL)
+                    snprintf(name, sizeof(name), "0x%lx", stack[i]);
+                fprintf(folded, "%s%s", symbol ? symbol->name : name, i ? ";" : "");
+            }
+            fprintf(folded, " %lu\n", count);
+        }
+    }
+
+    fclose(file);
+    if (folded != NULL)
+        fclose(folded);
+
+    if (!started) {
+        fprintf(stderr, "%s: no profile found\n", argv[2]);
+        return 1;
+    }
+    if (!done)
+        fprintf(stderr, "%s: profile is incomplete\n", argv[2]);
+
+    printf("%lu samples at %u per second\n\n", samples, rate);
+    printf("    self      %%    total      %%  function\n");
+
+    qsort(symbols, symbolCount, sizeof(struct Symbol), by_self);
+    for (i = 0; i < symbolCount && symbols[i].total > 0; i++) {
+        printf("%8lu %5.1f%% %8lu %5.1f%%  %s\n",
+               symbols[i].self, 100.0 * symbols[i].self / samples,
+               symbols[i].total, 100.0 * symbols[i].total / samples,
+               symbols[i].name);
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+// This host tool reassembles a framebuffer snapshot sent by the Etch-A-
+// Sketch (the 's' UART command) and writes it as a PNG image. The input is
+// a raw capture of the serial port. Frames are located by their sync byte
+// and accepted only if their CRC matches, so text or noise between frames
+// is skipped. See snapshot.c for the frame and compression formats.
+//
+// Usage:  snap2png capture.bin snapshot.png
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../crc.h"
+#include "../snapshot.h"
+#include "png.h"
+
+// Compressed stream reassembled from the data frames
+static unsigned char *stream;
+static unsigned int streamLength, streamPosition;
+
+
+
+static unsigned int get_le(const unsigned char *p, int bytes)
+{
+    unsigned int value = 0;
+
+    while (bytes--)
+        value = (value << 8) | p[bytes];
+
+    return value;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_varint
+//
+//  Arguments:      value:     Where to store the decoded number
+//
+//  Returns:        1 if a number was decoded, 0 at the end of the stream
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int get_varint(unsigned int *value)
+{
+    unsigned int shift = 0;
+    unsigned char byte;
+
+    *value = 0;
+    do {
+        if (streamPosition >= streamLength)
+            return 0;
+        byte = stream[streamPosition++];
+        *value |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return 1;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    FILE *file;
+    unsigned char *data, *frame, *pixels = NULL;
+    long size, i;
+    unsigned int type, sequence, length, expected = 0, width = 0, height = 0;
+    unsigned int frames = 0, bad = 0, token, run, x, y, r, done = 0;
+    int ink;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s capture.bin snapshot.png\n", argv[0]);
+        return 2;
+    }
+
+    file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size);
+    stream = malloc(size);
+    if (data == NULL || stream == NULL || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "%s: read error\n", argv[1]);
+        return 1;
+    }
+    fclose(file);
+
+    // Collect the frames in order
+    for (i = 0; i + 10 <= size && !done; i++) {
+        if (data[i] != SNAPSHOT_SYNC)
+            continue;
+
+        frame = data + i + 1;
+        type = frame[0];
+        sequence = get_le(frame + 1, 2);
+        length = get_le(frame + 3, 2);
+
+        if (type < SNAPSHOT_HEADER || type > SNAPSHOT_END ||
+            length > SNAPSHOT_CHUNK_SIZE || i + 10 + length > size)
+            continue;
+        if (crc32(frame, 5 + length) != get_le(frame + 5 + length, 4))
+            continue;
+
+        // A valid frame: check that none went missing before it
+        if (type == SNAPSHOT_HEADER) {
+            width = get_le(frame + 5, 2);
+            height = get_le(frame + 7, 2);
+            expected = sequence + 1;
+            streamLength = 0;
+        } else if (sequence != expected) {
+            fprintf(stderr, "frame %u missing\n", expected);
+            bad++;
+            expected = sequence + 1;
+        } else {
+            expected++;
+        }
+
+        if (type == SNAPSHOT_DATA) {
+            memcpy(stream + streamLength, frame + 5, length);
+            streamLength += length;
+        } else if (type == SNAPSHOT_END) {
+            if (get_le(frame + 5, 4) != streamLength) {
+                fprintf(stderr, "compressed length mismatch\n");
+                bad++;
+            }
+            done = 1;
+        }
+
+        frames++;
+        i += 9 + length;
+    }
+
+    if (width == 0 || !done) {
+        fprintf(stderr, "%s: no complete snapshot found\n", argv[1]);
+        return 1;
+    }
+
+    // Decode the rows
+    pixels = calloc(width * height, 1);
+    if (pixels == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    y = 0;
+    while (y < height && get_varint(&token)) {
+        if (token & 0x1) {
+            // Repeat the previous row
+            for (r = token >> 1; r > 0 && y < height && y > 0; r--, y++)
+                memcpy(pixels + y * width, pixels + (y - 1) * width, width);
+            continue;
+        }
+
+        for (x = 0, ink = 0; x < width; ink ^= 1) {
+            if (!get_varint(&run) || x + run > width) {
+                fprintf(stderr, "corrupt row %u\n", y);
+                return 1;
+            }
+            memset(pixels + y * width + x, ink, run);
+            x += run;
+        }
+        y++;
+    }
+
+    if (png_write_bitmap(argv[2], pixels, width, height) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    printf("%u frames (%u errors), %u compressed bytes -> %s (%ux%u)\n",
+           frames, bad, streamLength, argv[2], width, height);
+
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+// This host tool converts an event trace sent by the Etch-A-Sketch (the
+// 't' UART command) into the JSON trace event format, which can be opened
+// in chrome://tracing or ui.perfetto.dev. Each core's normal code and its
+// interrupt handlers are shown as separate threads. The input is a raw
+// capture of the serial port; any text before the trace is skipped.
+//
+// Usage:  trace2json capture.bin trace.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../crc.h"
+#include "../smp.h"
+#include "../trace.h"
+
+static const char *names[TRACE_EVENTS] = TRACE_NAMES;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_le
+//
+//  Arguments:      p:         Bytes to decode
+//                  bytes:     Number of bytes (up to 8)
+//
+//  Returns:        The little-endian number stored at p
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned long get_le(const unsigned char *p, int bytes)
+{
+    unsigned long value = 0;
+
+    while (bytes--)
+        value = (value << 8) | p[bytes];
+
+    return value;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       find_trace
+//
+//  Arguments:      data, size:    The capture
+//                  length:        Set to the length of the trace after the
+//                                 magic bytes, up to and including the CRC
+//
+//  Returns:        A pointer just past the magic bytes of the first trace
+//                  whose rings all fit in the capture, or NULL
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned char *find_trace(unsigned char *data, long size, long *length)
+{
+    long i, position;
+    unsigned int rings, ring;
+
+    for (i = 0; i + 10 <= size; i++) {
+        if (memcmp(data + i, TRACE_MAGIC, 4) != 0)
+            continue;
+
+        position = i + 4 + 6;
+        rings = get_le(data + i + 8, 2);
+        for (ring = 0; ring < rings && position + 6 <= size; ring++)
+            position += 6 + get_le(data + position + 2, 4) * sizeof(struct TraceRecord);
+
+        if (ring == rings && position + 4 <= size) {
+            *length = position + 4 - (i + 4);
+            return data + i + 4;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    FILE *file;
+    unsigned char *data, *trace, *p;
+    long size, length;
+    unsigned long frequency, first = ~0UL, time, info, events = 0, skipped = 0;
+    unsigned int rings, ring, count, i, core, context, event, phase, arg;
+    int depth[SMP_CORES * TRACE_CONTEXTS] = { 0 }, thread, comma = 0;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s capture.bin trace.json\n", argv[0]);
+        return 2;
+    }
+
+    file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size);
+    if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "%s: read error\n", argv[1]);
+        return 1;
+    }
+    fclose(file);
+
+    trace = find_trace(data, size, &length);
+    if (trace == NULL) {
+        fprintf(stderr, "%s: no complete trace found\n", argv[1]);
+        return 1;
+    }
+    if (crc32(trace, length - 4) != get_le(trace + length - 4, 4)) {
+        fprintf(stderr, "%s: checksum mismatch\n", argv[1]);
+        return 1;
+    }
+
+    frequency = get_le(trace, 4);
+    rings = get_le(trace + 4, 2);
+
+    // Find the earliest record, so that the timeline starts at 0
+    for (ring = 0, p = trace + 6; ring < rings; ring++) {
+        count = get_le(p + 2, 4);
+        if (count > 0 && get_le(p + 6, 8) < first)
+            first = get_le(p + 6, 8);
+        p += 6 + count * sizeof(struct TraceRecord);
+    }
+
+    file = fopen(argv[2], "w");
+    if (file == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (ring = 0, p = trace + 6; ring < rings; ring++) {
+        core = p[0];
+        context = p[1];
+        count = get_le(p + 2, 4);
+        p += 6;
+
+        thread = core * TRACE_CONTEXTS + context;
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+                "\"args\":{\"name\":\"core %u%s\"}}",
+                comma ? ",\n" : "", thread, core, context ? " IRQ" : "");
+        comma = 1;
+
+        for (i = 0; i < count; i++, p += sizeof(struct TraceRecord)) {
+            time = get_le(p, 8) - first;
+            info = get_le(p + 8, 8);
+            event = info & 0xFFFF;
+            phase = (info >> 16) & 0xFF;
+            arg = info >> 32;
+
+            if (event >= TRACE_EVENTS || phase > TRACE_INSTANT) {
+                skipped++;
+                continue;
+            }
+
+            // The oldest records of a full ring can end events whose
+            // beginning was overwritten
+            if (phase == TRACE_END && thread < SMP_CORES * TRACE_CONTEXTS) {
+                if (depth[thread] == 0) {
+                    skipped++;
+                    continue;
+                }
+                depth[thread]--;
+            } else if (phase == TRACE_BEGIN && thread < SMP_CORES * TRACE_CONTEXTS) {
+                depth[thread]++;
+            }
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,"
+                    "\"tid\":%d,\"args\":{\"arg\":%u}%s}",
+                    names[event], phase == TRACE_BEGIN ? "B" : phase == TRACE_END ? "E" : "i",
+                    time * 1e6 / frequency, thread, arg,
+                    phase == TRACE_INSTANT ? ",\"s\":\"t\"" : "");
+            events++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("%lu events (%lu skipped) at %lu Hz -> %s\n", events, skipped, frequency, argv[2]);
+    return 0;
+}
@@ -0,0 +1,200 @@
+// The functions in this file draw a small heads-up display over the
+// drawing. Each field remembers the text currently on the screen, and only
+// the characters that differ are redrawn, so updating the HUD every frame
+// costs a few character cells at most.
+
+#include "framebuffer.h"
+#include "font.h"
+#include "hud.h"
+
+// Colors of the HUD text
+#define HUD_FOREGROUND      BLACK
+#define HUD_BACKGROUND      SILVER
+
+// A character that never appears in a field, used to force a redraw
+#define HUD_STALE           0x7F
+
+static struct Surface *hudSurface;
+static char shown[HUD_FIELDS][HUD_FIELD_LENGTH];
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       hud_init
+//
+//  Arguments:      s:     Surface to draw the HUD on
+//
+//  Returns:        void
+//
+//  Description:    This function prepares the glyph cache in the surface's
+//                  format and marks every field as needing a redraw.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void hud_init(struct Surface *s)
+{
+    hudSurface = s;
+    font_init(s, HUD_FOREGROUND, HUD_BACKGROUND);
+    hud_invalidate();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       hud_invalidate
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function forgets what is on the screen, so that the
+//                  next update redraws every field completely. It must be
+//                  called after anything else draws over the HUD, such as
+//                  erasing the screen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void hud_invalidate()
+{
+    int field, i;
+
+    for (field = 0; field < HUD_FIELDS; field++)
+        for (i = 0; i < HUD_FIELD_LENGTH; i++)
+            shown[field][i] = HUD_STALE;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       hud_set
+//
+//  Arguments:      field:     One of the HUD_* field numbers
+//                  text:      New text of the field
+//
+//  Returns:        void
+//
+//  Description:    This function changes the text of a field. The text is
+//                  padded with spaces to the field length, and only the
+//                  character cells that changed are drawn.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void hud_set(int field, char *text)
+{
+    int i, y;
+    char c;
+
+    if (hudSurface == 0 || field < 0 || field >= HUD_FIELDS)
+        return;
+
+    y = HUD_Y + field * FONT_CELL_HEIGHT;
+
+    for (i = 0; i < HUD_FIELD_LENGTH; i++) {
+        c = *text ? *text++ : ' ';
+
+        if (c != shown[field][i]) {
+            fb_draw_char(hudSurface, HUD_X + i * FONT_CELL_WIDTH, y, c);
+            shown[field][i] = c;
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       append_text
+//
+//  Arguments:      p:         Where to write
+//                  text:      String to copy (without its terminator)
+//
+//  Returns:        Pointer just past the copied text
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static char *append_text(char *p, char *text)
+{
+    while (*text)
+        *p++ = *text++;
+
+    return p;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       append_number
+//
+//  Arguments:      p:         Where to write
+//                  value:     Number to format in decimal
+//                  width:     Minimum width, padded with spaces on the left
+//
+//  Returns:        Pointer just past the formatted number
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static char *append_number(char *p, unsigned int value, int width)
+{
+    char digits[10];
+    int count = 0;
+
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (width-- > count)
+        *p++ = ' ';
+
+    while (count > 0)
+        *p++ = digits[--count];
+
+    return p;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       hud_update
+//
+//  Arguments:      x, y:      Pen position
+//                  fps:       Frames per second
+//                  latency:   Most recent input-to-framebuffer latency in
+//                             microseconds
+//
+//  Returns:        void
+//
+//  Description:    This function formats the standard HUD fields and
+//                  redraws whatever changed since the last update. Numbers
+//                  are right aligned in fixed widths so that the digits
+//                  that did not change stay in place.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void hud_update(int x, int y, unsigned int fps, unsigned int latency)
+{
+    char text[HUD_FIELD_LENGTH + 1], *p;
+
+    p = append_text(text, "X");
+    p = append_number(p, x, 5);
+    p = append_text(p, "  Y");
+    p = append_number(p, y, 5);
+    *p = '\0';
+    hud_set(HUD_POSITION, text);
+
+    p = append_text(text, "FPS");
+    p = append_number(p, fps, 6);
+    *p = '\0';
+    hud_set(HUD_FPS, text);
+
+    p = append_text(text, "LAT");
+    p = append_number(p, latency, 6);
+    p = append_text(p, " us");
+    *p = '\0';
+    hud_set(HUD_LATENCY, text);
+}
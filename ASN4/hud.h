@@ -0,0 +1,28 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "surface.h"
+#include "font.h"
+
+// HUD fields, one per text line in the top left corner of the screen
+#define HUD_POSITION        0
+#define HUD_FPS             1
+#define HUD_LATENCY         2
+#define HUD_FIELDS          3
+
+// Maximum number of characters in a field
+#define HUD_FIELD_LENGTH    16
+
+// Position of the first HUD line on its surface, and the area covered
+#define HUD_X               8
+#define HUD_Y               8
+#define HUD_WIDTH           (HUD_FIELD_LENGTH * FONT_CELL_WIDTH)
+#define HUD_HEIGHT          (HUD_FIELDS * FONT_CELL_HEIGHT)
+
+// Function prototypes
+void hud_init(struct Surface *s);
+void hud_set(int field, char *text);
+void hud_invalidate();
+void hud_update(int x, int y, unsigned int fps, unsigned int latency);
+
+#endif
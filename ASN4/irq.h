@@ -0,0 +1,47 @@
+// The addresses of the Broadcom interrupt controller registers.
+//
+// These are defined on page 112 of the Broadcom BCM2837 ARM Peripherals
+// Manual. Note that we specify the ARM physical addresses of the
+// peripherals, which have the address range 0x3F000000 to 0x3FFFFFFF.
+// These addresses are mapped by the VideoCore Memory Management Unit (MMU)
+// onto the bus addresses in the range 0x7E000000 to 0x7EFFFFFF.
+#define MMIO_BASE       		0x3F000000
+
+#define IRQ_BASIC_PENDING       ((volatile unsigned int *)(MMIO_BASE + 0x0000B200))
+#define IRQ_PENDING_1           ((volatile unsigned int *)(MMIO_BASE + 0x0000B204))
+#define IRQ_PENDING_2           ((volatile unsigned int *)(MMIO_BASE + 0x0000B208))
+#define IRQ_FIQ_CONTROL         ((volatile unsigned int *)(MMIO_BASE + 0x0000B20C))
+#define IRQ_ENABLE_IRQS_1       ((volatile unsigned int *)(MMIO_BASE + 0x0000B210))
+#define IRQ_ENABLE_IRQS_2       ((volatile unsigned int *)(MMIO_BASE + 0x0000B214))
+#define IRQ_ENABLE_BASIC_IRQS   ((volatile unsigned int *)(MMIO_BASE + 0x0000B218))
+#define IRQ_DISABLE_IRQS_1      ((volatile unsigned int *)(MMIO_BASE + 0x0000B21C))
+#define IRQ_DISABLE_IRQS_2      ((volatile unsigned int *)(MMIO_BASE + 0x0000B220))
+#define IRQ_DISABLE_BASIC_IRQS	((volatile unsigned int *)(MMIO_BASE + 0x0000B224))
+
+// Interrupt number (bit position) in the basic IRQ pending/enable registers
+// for the ARM Timer
+#define ARM_TIMER_IRQ           (0x1 << 0)
+
+// Interrupt numbers (bit positions) in IRQ pending/enable register 1 for
+// the System Timer compare channels that are free for ARM use
+#define SYSTEM_TIMER_IRQ_1      (0x1 << 1)
+#define SYSTEM_TIMER_IRQ_3      (0x1 << 3)
+
+// Interrupt number (bit position) in IRQ pending/enable register 2 for the
+// PL011 UART (IRQ 57)
+#define UART0_IRQ               (0x1 << 25)
+
+// The per-core interrupt controller of the BCM2837 (the "ARM local
+// peripherals", described in the BCM2836 ARM-local peripherals document).
+// Each core has a register that routes its generic timer interrupts to
+// it, and a register showing which of its interrupt sources are pending.
+#define LOCAL_TIMER_CONTROL(core)   ((volatile unsigned int *)(0x40000040 + 4 * (unsigned long)(core)))
+#define LOCAL_IRQ_SOURCE(core)      ((volatile unsigned int *)(0x40000060 + 4 * (unsigned long)(core)))
+
+// The non-secure physical timer (CNTP) bit in both registers above
+#define LOCAL_CNTPNS_IRQ            (0x1 << 1)
+
+// Positions (in 64-bit words) of saved registers in the frame that the IRQ
+// stub in start.s pushes and passes to IRQ_handler()
+#define IRQ_FRAME_X30           0
+#define IRQ_FRAME_X29           3
@@ -0,0 +1,709 @@
+// The functions in this file keep a compact journal of the pen strokes.
+// Instead of pixels, the journal stores runs of pen steps in one of eight
+// directions, so a straight line of any length takes a few bytes. The
+// journal can be replayed onto a clean canvas at any speed, or sent to
+// the host over the UART, where host/journal2png turns it into an image.
+//
+// Undo and redo are journaled too, together with the start of every undo
+// step and every fill, so that a replay rebuilds the same history and ends
+// with the same drawing as the canvas.
+//
+// The records are kept in a ring. When it is full the oldest record is
+// decoded and applied to a base pen position, so the remaining records
+// can still be replayed from a known starting point.
+
+#include "uart.h"
+#include "systimer.h"
+#include "canvas.h"
+#include "crc.h"
+#include "boot.h"
+#include "journal.h"
+
+// Step of each direction code: up, up-right, right, down-right, down,
+// down-left, left, up-left
+static const int stepX[8] = {  0,  1,  1,  1,  0, -1, -1, -1 };
+static const int stepY[8] = { -1, -1,  0,  1,  1,  1,  0, -1 };
+
+// Longest record: opcode, two 5-byte varints, and a 5-byte varint duration
+#define RECORD_MAX          16
+
+// Ring of encoded records. Head and tail count bytes ever written and
+// dropped, and are masked when used as indices. Only bytes between them
+// are read, so the ring is not cleared at boot.
+static unsigned char ring[JOURNAL_SIZE] BOOT_LAZY;
+static unsigned int head, tail;
+
+// Pen position and brush size at the oldest record in the ring
+static int baseX, baseY, baseBrush;
+
+// Time in milliseconds of the last record written
+static unsigned int lastTime;
+
+// The run currently being extended (openLength is 0 if there is none)
+static int openDirection;
+static unsigned int openLength;
+static unsigned long openStart, openLast;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_varint
+//
+//  Arguments:      p:         Where to write
+//                  value:     Number to encode
+//
+//  Returns:        Pointer just past the encoded number
+//
+//  Description:    This function writes a number 7 bits at a time, least
+//                  significant group first, with the top bit of each byte
+//                  set when more bytes follow.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned char *put_varint(unsigned char *p, unsigned int value)
+{
+    while (value >= 0x80) {
+        *p++ = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    *p++ = value;
+
+    return p;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_varint
+//
+//  Arguments:      position:  Ring position of the number; advanced past it
+//
+//  Returns:        The decoded number
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int get_varint(unsigned int *position)
+{
+    unsigned int value = 0, shift = 0;
+    unsigned char byte;
+
+    do {
+        byte = ring[(*position)++ & (JOURNAL_SIZE - 1)];
+        value |= (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return value;
+}
+
+
+
+// A decoded record
+struct Record
+{
+    unsigned int opcode;
+    unsigned int delta;     // Milliseconds since the previous record
+    unsigned int length;    // Steps in a move run
+    unsigned int duration;  // Milliseconds from first to last step
+    int direction;
+    int x, y;               // Position of a JOURNAL_PEN, JOURNAL_UNDO,
+                            // JOURNAL_REDO or JOURNAL_FILL record (x is
+                            // the size of a JOURNAL_BRUSH record)
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       decode_record
+//
+//  Arguments:      position:  Ring position of the record; advanced past it
+//                  record:    Where to store the decoded record
+//
+//  Returns:        void
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void decode_record(unsigned int *position, struct Record *record)
+{
+    record->opcode = ring[(*position)++ & (JOURNAL_SIZE - 1)];
+
+    if (record->opcode < JOURNAL_ERASE) {
+        record->direction = (record->opcode >> 4) & 0x7;
+        record->length = (record->opcode & 0xF) + 1;
+        if (record->length == 16)
+            record->length += get_varint(position);
+    } else if (record->opcode == JOURNAL_BRUSH) {
+        record->x = get_varint(position);
+    } else if (record->opcode != JOURNAL_ERASE && record->opcode != JOURNAL_STEP) {
+        record->x = get_varint(position);
+        record->y = get_varint(position);
+    }
+
+    record->delta = get_varint(position);
+
+    if (record->opcode < JOURNAL_ERASE)
+        record->duration = get_varint(position);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drop_oldest
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function removes the oldest record from the ring,
+//                  applying it to the base pen position.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void drop_oldest()
+{
+    struct Record record;
+
+    decode_record(&tail, &record);
+
+    if (record.opcode < JOURNAL_ERASE) {
+        baseX += stepX[record.direction] * (int)record.length;
+        baseY += stepY[record.direction] * (int)record.length;
+    } else if (record.opcode == JOURNAL_PEN || record.opcode == JOURNAL_UNDO ||
+               record.opcode == JOURNAL_REDO) {
+        baseX = record.x;
+        baseY = record.y;
+    } else if (record.opcode == JOURNAL_BRUSH) {
+        baseBrush = record.x;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       append_record
+//
+//  Arguments:      record:    Encoded record
+//                  length:    Number of bytes in the record
+//
+//  Returns:        void
+//
+//  Description:    This function copies a record into the ring, dropping
+//                  the oldest records first if there is not enough room.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void append_record(unsigned char *record, unsigned int length)
+{
+    unsigned int i;
+
+    while (JOURNAL_SIZE - (head - tail) < length)
+        drop_oldest();
+
+    for (i = 0; i < length; i++)
+        ring[head++ & (JOURNAL_SIZE - 1)] = record[i];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       time_delta
+//
+//  Arguments:      timestamp:   get_timer_counter() time of a new record
+//
+//  Returns:        Milliseconds since the previous record
+//
+//  Description:    This function converts a timestamp to milliseconds and
+//                  returns the delta from the previous record. Working in
+//                  whole milliseconds on both sides keeps rounding errors
+//                  from adding up over a long journal. Button presses are
+//                  stamped when they were sampled, which can be a little
+//                  before the record written last, so time never runs
+//                  backwards here.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int time_delta(unsigned long timestamp)
+{
+    unsigned int now = timestamp / 1000, delta;
+
+    if (now < lastTime)
+        return 0;
+
+    delta = now - lastTime;
+    lastTime = now;
+
+    return delta;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       flush_run
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function writes out the run being extended, if any.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void flush_run()
+{
+    unsigned char record[RECORD_MAX], *p = record;
+
+    if (openLength == 0)
+        return;
+
+    if (openLength < 16) {
+        *p++ = (openDirection << 4) | (openLength - 1);
+    } else {
+        *p++ = (openDirection << 4) | 0xF;
+        p = put_varint(p, openLength - 16);
+    }
+
+    p = put_varint(p, time_delta(openStart));
+    p = put_varint(p, (openLast - openStart) / 1000);
+
+    append_record(record, p - record);
+    openLength = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_event
+//
+//  Arguments:      opcode:      Record opcode (not a move run)
+//                  x, y:        Position stored in the record, if its
+//                               opcode has one (x alone for a brush size)
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function ends the run being extended and writes
+//                  one record that is not a move.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_event(unsigned int opcode, int x, int y, unsigned long timestamp)
+{
+    unsigned char record[RECORD_MAX], *p = record;
+
+    flush_run();
+
+    *p++ = opcode;
+    if (opcode == JOURNAL_BRUSH) {
+        p = put_varint(p, x);
+    } else if (opcode != JOURNAL_ERASE && opcode != JOURNAL_STEP) {
+        p = put_varint(p, x);
+        p = put_varint(p, y);
+    }
+    p = put_varint(p, time_delta(timestamp));
+
+    append_record(record, p - record);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_start
+//
+//  Arguments:      x, y:        Starting pen position
+//                  brush:       Starting brush size
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function empties the journal and starts a new one
+//                  with the pen at the given position.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_start(int x, int y, int brush, unsigned long timestamp)
+{
+    head = tail = 0;
+    openLength = 0;
+
+    baseX = x;
+    baseY = y;
+    baseBrush = brush;
+    lastTime = timestamp / 1000;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_move
+//
+//  Arguments:      dx, dy:      Pen step, each -1, 0 or 1
+//                  timestamp:   get_timer_counter() time of the step
+//
+//  Returns:        void
+//
+//  Description:    This function records one pen step. A step in the same
+//                  direction as the previous one, soon enough after it,
+//                  just makes the current run longer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_move(int dx, int dy, unsigned long timestamp)
+{
+    int direction;
+
+    if (dx == 0 && dy == 0)
+        return;
+
+    // Find the direction code of the step
+    for (direction = 0; direction < 8; direction++)
+        if (stepX[direction] == dx && stepY[direction] == dy)
+            break;
+
+    if (openLength != 0 && direction == openDirection &&
+        timestamp - openLast <= JOURNAL_RUN_GAP) {
+        openLength++;
+        openLast = timestamp;
+        return;
+    }
+
+    flush_run();
+
+    openDirection = direction;
+    openLength = 1;
+    openStart = openLast = timestamp;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_erase
+//
+//  Arguments:      timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records that the screen was erased.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_erase(unsigned long timestamp)
+{
+    put_event(JOURNAL_ERASE, 0, 0, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_pen
+//
+//  Arguments:      x, y:        New pen position
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records a jump of the pen to a new
+//                  position without drawing.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_pen(int x, int y, unsigned long timestamp)
+{
+    put_event(JOURNAL_PEN, x, y, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_step
+//
+//  Arguments:      timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records that a new undo step begins, so
+//                  that a replay divides the drawing into the same steps.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_step(unsigned long timestamp)
+{
+    put_event(JOURNAL_STEP, 0, 0, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_undo
+//
+//  Arguments:      x, y:        Pen position after the undo
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records that the last step was undone.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_undo(int x, int y, unsigned long timestamp)
+{
+    put_event(JOURNAL_UNDO, x, y, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_redo
+//
+//  Arguments:      x, y:        Pen position after the redo
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records that the step last undone was
+//                  redone.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_redo(int x, int y, unsigned long timestamp)
+{
+    put_event(JOURNAL_REDO, x, y, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_fill
+//
+//  Arguments:      x, y:        Paper pixel the fill started from
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records a flood fill of the paper around
+//                  a pixel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_fill(int x, int y, unsigned long timestamp)
+{
+    put_event(JOURNAL_FILL, x, y, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_brush
+//
+//  Arguments:      size:        New brush size
+//                  timestamp:   get_timer_counter() time
+//
+//  Returns:        void
+//
+//  Description:    This function records a change of brush size, so that
+//                  a replay stamps the strokes that follow with it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_brush(int size, unsigned long timestamp)
+{
+    put_event(JOURNAL_BRUSH, size, 0, timestamp);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_length
+//
+//  Arguments:      none
+//
+//  Returns:        The number of bytes of records in the journal
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int journal_length()
+{
+    flush_run();
+
+    return head - tail;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_replay
+//
+//  Arguments:      speed:     Replay speed in percent of real time (100 is
+//                             the original speed, 0 draws instantly)
+//                  player:    Functions that draw, erase, fill, and keep
+//                             the undo history
+//
+//  Returns:        void
+//
+//  Description:    This function erases the screen, then redraws the
+//                  journal from its oldest record, waiting between steps
+//                  so that the drawing appears at the requested speed.
+//                  Undo steps, undos and redos are played back too, so the
+//                  history ends up the same as when the journal was made.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_replay(unsigned int speed, const struct JournalPlayer *player)
+{
+    struct Record record;
+    unsigned int position, i, interval;
+    int x, y;
+
+    flush_run();
+
+    player->erase();
+    player->brush(baseBrush);
+    x = baseX;
+    y = baseY;
+    player->plot(x, y);
+
+    for (position = tail; position != head; ) {
+        decode_record(&position, &record);
+
+        if (speed != 0)
+            microsecond_delay((unsigned long)record.delta * 100000 / speed);
+
+        if (record.opcode == JOURNAL_ERASE) {
+            player->erase();
+        } else if (record.opcode == JOURNAL_PEN) {
+            x = record.x;
+            y = record.y;
+        } else if (record.opcode == JOURNAL_STEP) {
+            player->step(x, y);
+        } else if (record.opcode == JOURNAL_UNDO) {
+            player->undo(&x, &y);
+            x = record.x;
+            y = record.y;
+        } else if (record.opcode == JOURNAL_REDO) {
+            player->redo(&x, &y);
+            x = record.x;
+            y = record.y;
+        } else if (record.opcode == JOURNAL_FILL) {
+            player->fill(record.x, record.y);
+        } else if (record.opcode == JOURNAL_BRUSH) {
+            player->brush(record.x);
+        } else {
+            // Spread the steps of the run evenly over its duration
+            interval = 0;
+            if (speed != 0 && record.length > 1)
+                interval = (unsigned long)record.duration * 100000 /
+                           ((unsigned long)(record.length - 1) * speed);
+
+            for (i = 0; i < record.length; i++) {
+                if (i > 0 && interval != 0)
+                    microsecond_delay(interval);
+
+                x += stepX[record.direction];
+                y += stepY[record.direction];
+                player->plot(x, y);
+            }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_word
+//
+//  Arguments:      value:     Number to send
+//                  bytes:     Number of bytes to send (2 or 4)
+//                  crc:       Running checksum, updated with the bytes sent
+//
+//  Returns:        void
+//
+//  Description:    This function sends a number in little-endian order.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_word(unsigned int value, int bytes, unsigned int *crc)
+{
+    unsigned char byte;
+
+    while (bytes--) {
+        byte = value & 0xFF;
+        uart_putc(byte);
+        if (crc)
+            *crc = crc32_update(*crc, &byte, 1);
+        value >>= 8;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       journal_export
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sends the journal to the host over the
+//                  UART in binary form. The layout (all numbers little-
+//                  endian) is:
+//
+//                      "SKJ2"              magic
+//                      u16 width, height   canvas size
+//                      u16 x, y            pen position at the first record
+//                      u16 brush           brush size at the first record
+//                      u32 length          number of record bytes
+//                      length bytes        the records, oldest first
+//                      u32 crc             CRC-32 of everything after magic
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void journal_export()
+{
+    unsigned int crc = 0, length, position, start, count;
+    char *magic = JOURNAL_MAGIC;
+
+    length = journal_length();
+
+    while (*magic)
+        uart_putc(*magic++);
+
+    put_word(CANVAS_WIDTH, 2, &crc);
+    put_word(CANVAS_HEIGHT, 2, &crc);
+    put_word(baseX, 2, &crc);
+    put_word(baseY, 2, &crc);
+    put_word(baseBrush, 2, &crc);
+    put_word(length, 4, &crc);
+
+    // Send the records as at most two blocks, split where the ring wraps
+    for (position = tail; position != head; position += count) {
+        start = position & (JOURNAL_SIZE - 1);
+        count = head - position;
+        if (count > JOURNAL_SIZE - start)
+            count = JOURNAL_SIZE - start;
+
+        uart_write(ring + start, count);
+        crc = crc32_update(crc, ring + start, count);
+    }
+
+    put_word(crc, 4, 0);
+}
@@ -0,0 +1,58 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// Size of the journal ring in bytes (must be a power of 2). When it fills
+// up, the oldest records are dropped.
+#define JOURNAL_SIZE        65536
+
+// Consecutive steps in the same direction are merged into one run unless
+// they are further apart than this many microseconds
+#define JOURNAL_RUN_GAP     250000
+
+// Record opcodes. Bytes below JOURNAL_ERASE start a move run: bits 6-4
+// give the direction (see journal.c) and bits 3-0 the run length minus 1,
+// where 15 means the length continues in a varint. Every record is
+// followed by a varint time delta in milliseconds from the start of the
+// previous record, and a run also by a varint duration in milliseconds.
+#define JOURNAL_ERASE       0x80    // Screen was erased
+#define JOURNAL_PEN         0x81    // Pen jumped to (varint x, varint y)
+#define JOURNAL_STEP        0x82    // A new undo step begins
+#define JOURNAL_UNDO        0x83    // Last step undone, pen now at (varint x,
+                                    // varint y)
+#define JOURNAL_REDO        0x84    // Step redone, pen now at (varint x,
+                                    // varint y)
+#define JOURNAL_FILL        0x85    // Paper at (varint x, varint y) filled
+#define JOURNAL_BRUSH       0x86    // Brush size changed to (varint size)
+
+// The functions a replay draws with. The undo functions are given the pen
+// position, which they may move; the journal then puts the pen where it
+// was when the record was written.
+struct JournalPlayer
+{
+    void (*plot)(int x, int y);     // Draw the pen at a position
+    void (*erase)();                // Erase the screen
+    void (*step)(int x, int y);     // Begin a new undo step
+    void (*undo)(int *x, int *y);   // Undo the last step
+    void (*redo)(int *x, int *y);   // Redo the step last undone
+    void (*fill)(int x, int y);     // Fill the paper around a pixel
+    void (*brush)(int size);        // Change the brush size
+};
+
+// Magic bytes starting a journal sent to the host
+#define JOURNAL_MAGIC       "SKJ2"
+
+// Function prototypes
+void journal_start(int x, int y, int brush, unsigned long timestamp);
+void journal_move(int dx, int dy, unsigned long timestamp);
+void journal_erase(unsigned long timestamp);
+void journal_pen(int x, int y, unsigned long timestamp);
+void journal_step(unsigned long timestamp);
+void journal_undo(int x, int y, unsigned long timestamp);
+void journal_redo(int x, int y, unsigned long timestamp);
+void journal_fill(int x, int y, unsigned long timestamp);
+void journal_brush(int size, unsigned long timestamp);
+unsigned int journal_length();
+void journal_replay(unsigned int speed, const struct JournalPlayer *player);
+void journal_export();
+
+#endif
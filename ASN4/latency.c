@@ -0,0 +1,178 @@
+// The functions in this file measure how long a button press takes to reach
+// the framebuffer. The main loop fills in a FrameTimes record for every
+// frame that reacts to input, and each stage of the pipeline is kept in a
+// rolling window of the last LATENCY_WINDOW frames. Statistics are only
+// computed when they are asked for, so recording a frame is cheap.
+
+#include "uart.h"
+#include "latency.h"
+
+// Names printed by latency_report(), indexed by stage
+static char *stageNames[LATENCY_STAGES] = {
+    "input   ",
+    "raster  ",
+    "present ",
+    "total   "
+};
+
+// Rolling windows of stage durations in microseconds
+static unsigned int samples[LATENCY_STAGES][LATENCY_WINDOW];
+static unsigned int frameCount;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       latency_record
+//
+//  Arguments:      frame:     Timestamps taken while producing one frame
+//
+//  Returns:        void
+//
+//  Description:    This function converts the frame timestamps into stage
+//                  durations and stores them in the rolling windows,
+//                  overwriting the oldest frame once a window is full.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void latency_record(struct FrameTimes *frame)
+{
+    unsigned int slot = frameCount & (LATENCY_WINDOW - 1);
+
+    samples[LATENCY_INPUT][slot] = frame->update - frame->sample;
+    samples[LATENCY_RASTER][slot] = frame->raster - frame->update;
+    samples[LATENCY_PRESENT][slot] = frame->present - frame->raster;
+    samples[LATENCY_TOTAL][slot] = frame->present - frame->sample;
+
+    frameCount++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       latency_get_stats
+//
+//  Arguments:      stage:     One of the LATENCY_* stage numbers
+//                  stats:     Where to store the statistics
+//
+//  Returns:        void
+//
+//  Description:    This function computes the minimum, average, 99th
+//                  percentile and maximum of one stage over the frames
+//                  currently in its window. The percentile is found by
+//                  sorting a copy of the window, which is fine since this
+//                  is only done when a report is requested.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void latency_get_stats(int stage, struct LatencyStats *stats)
+{
+    unsigned int sorted[LATENCY_WINDOW];
+    unsigned int count, i, j, value;
+    unsigned long sum = 0;
+
+    count = frameCount < LATENCY_WINDOW ? frameCount : LATENCY_WINDOW;
+    stats->count = count;
+
+    if (count == 0) {
+        stats->min = stats->avg = stats->p99 = stats->max = 0;
+        return;
+    }
+
+    // Insertion sort a copy of the window, summing as we go
+    for (i = 0; i < count; i++) {
+        value = samples[stage][i];
+        sum += value;
+
+        for (j = i; j > 0 && sorted[j - 1] > value; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = value;
+    }
+
+    stats->min = sorted[0];
+    stats->max = sorted[count - 1];
+    stats->avg = sum / count;
+    stats->p99 = sorted[(count * 99) / 100];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       latency_last
+//
+//  Arguments:      stage:     One of the LATENCY_* stage numbers
+//
+//  Returns:        The duration of the stage in the most recently recorded
+//                  frame, in microseconds (0 if none has been recorded)
+//
+//  Description:    This function is cheap enough to be called every frame,
+//                  for example to show the latency on the screen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int latency_last(int stage)
+{
+    if (frameCount == 0)
+        return 0;
+
+    return samples[stage][(frameCount - 1) & (LATENCY_WINDOW - 1)];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       latency_reset
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function empties all the rolling windows.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void latency_reset()
+{
+    frameCount = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       latency_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function prints the statistics of every stage to
+//                  the UART terminal, with all times in microseconds.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void latency_report()
+{
+    struct LatencyStats stats;
+    int stage;
+
+    uart_puts("\nLatency (us) over last ");
+    uart_putdec(frameCount < LATENCY_WINDOW ? frameCount : LATENCY_WINDOW);
+    uart_puts(" frames:\n");
+    uart_puts("    stage        min      avg      p99      max\n");
+
+    for (stage = 0; stage < LATENCY_STAGES; stage++) {
+        latency_get_stats(stage, &stats);
+
+        uart_puts("    ");
+        uart_puts(stageNames[stage]);
+        uart_putdec_padded(stats.min, 9);
+        uart_putdec_padded(stats.avg, 9);
+        uart_putdec_padded(stats.p99, 9);
+        uart_putdec_padded(stats.max, 9);
+        uart_puts("\n");
+    }
+}
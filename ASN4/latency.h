@@ -0,0 +1,43 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Number of frames kept in each rolling window (must be a power of 2)
+#define LATENCY_WINDOW      256
+
+// Pipeline stages measured for each frame. The first three cover the
+// path from one timestamp to the next, and the last one covers the whole
+// path from the SNES sample to the framebuffer write being complete.
+#define LATENCY_INPUT       0   // SNES sample -> state updated
+#define LATENCY_RASTER      1   // State updated -> pixels rasterized
+#define LATENCY_PRESENT     2   // Pixels rasterized -> framebuffer written
+#define LATENCY_TOTAL       3   // SNES sample -> framebuffer written
+#define LATENCY_STAGES      4
+
+// Timestamps taken for one frame, in microseconds of the ARM generic
+// timer's counter (CNTPCT), as returned by get_timer_counter()
+struct FrameTimes
+{
+    unsigned long sample;
+    unsigned long update;
+    unsigned long raster;
+    unsigned long present;
+};
+
+// Statistics over the current window of one stage, in microseconds
+struct LatencyStats
+{
+    unsigned int count;
+    unsigned int min;
+    unsigned int avg;
+    unsigned int p99;
+    unsigned int max;
+};
+
+// Function prototypes
+void latency_record(struct FrameTimes *frame);
+void latency_get_stats(int stage, struct LatencyStats *stats);
+unsigned int latency_last(int stage);
+void latency_reset();
+void latency_report();
+
+#endif
@@ -0,0 +1,954 @@
+// Minh Hang Chu 30074056
+// CPSC 359 Fall 2019 - University of Calgary
+// Assignment 4
+
+// This assignment is completed using references to TA's files on D2L
+
+// This program demonstrates how to initialize a frame buffer for a
+// 1024 x 768 display, and how to draw on it using SNES on screen
+
+// Included header files
+#include "uart.h"
+#include "framebuffer.h"
+
+#include "snes.h"
+#include "sysreg.h"
+#include "latency.h"
+#include "frame.h"
+#include "hud.h"
+#include "canvas.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "undo.h"
+#include "view.h"
+#include "smp.h"
+#include "memory.h"
+#include "brush.h"
+#include "fill.h"
+#include "profile.h"
+#include "trace.h"
+#include "boot.h"
+
+#define MAZESIZEY 768
+#define MAZESIZEX 1024
+#define SQUARESIZE 1
+
+#define NUMBUTTONS 6
+
+// Target frame rate of the drawing loop
+#define FRAME_RATE 300
+
+// A struct to represent a button
+struct Button
+{
+    int number;
+    char* name;
+};
+
+// A struct to represent a position
+struct Point
+{
+    int x;
+    int y;
+};
+
+// (0,0) is top left corner. The maze lives on the heap rather than in
+// .bss, so its 3 MB are not cleared at boot only to be filled in again.
+int (*masterMaze)[MAZESIZEY];
+
+// Diameter of the pen's brush in pixels (Select changes it)
+int brushSize = 1;
+
+// Direction of the pen's last step, which X fills towards
+int stepX = 1, stepY = 0;
+
+void initializeMasterMaze();
+
+void drawSquare(int x, int y, unsigned int colour);
+void drawBrush(int x, int y);
+void drawMazeAt(int x, int y);
+unsigned int mazeColour(int x, int y);
+void drawMaze();
+void drawMazeBand(void *arg, int y, int h);
+void handleCommand(char command, struct Point *character);
+void drawHud(int x, int y);
+void eraseScreen();
+void replayPlot(int x, int y);
+void replayStep(int x, int y);
+void replayUndo(int *x, int *y);
+void replayRedo(int *x, int *y);
+void replayFill(int x, int y);
+void replayBrush(int size);
+void redrawRegion(int x, int y, int w, int h);
+void followPen(int x, int y);
+void fillAhead(int x, int y, unsigned long timestamp);
+void handleButtonPress(int button, struct Point *character, unsigned long timestamp);
+
+// pseudo constructors for the structs that we have created above
+struct Button createButton(int number, char* name);
+struct Point createPoint(int x, int y);
+
+// The functions a journal replay draws with and keeps the history with
+const struct JournalPlayer replayer = {
+    replayPlot, eraseScreen, replayStep, replayUndo, replayRedo, replayFill,
+    replayBrush
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       main
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function initializes the UART terminal and initializes
+//                  a frame buffer for a 1024 x 768 display. Each pixel in the
+//                  frame buffer is 32 bits in size, which encodes an RGB value
+//                  (plus an 8-bit alpha channel that is not used). The program
+//                  then draws and displays.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void main()
+{
+    unsigned short data, currentState = 0xFFFF;
+    struct SNESState controller;
+    struct SNESEvent event;
+    struct FrameTimes frame;
+    int oldX, oldY;
+    unsigned int lastSequence = 0;
+    int erase;
+
+    // Initialize the UART terminal
+    uart_init();
+    boot_mark("UART");
+
+    uart_puts("Hello World!");
+
+    // Start recording the event trace
+    trace_init();
+    boot_mark("trace");
+
+    initializeSNES();
+
+    // Sample the controller in the background from timer interrupts, so
+    // the loop below never waits on controller I/O
+    snes_sampler_start(SNES_SAMPLE_RATE);
+    enableIRQ();
+    boot_mark("SNES");
+
+    // Initialize the frame buffer
+    initFrameBuffer();
+    boot_mark("frame buffer");
+
+    // Wake up cores 1 - 3 to help with full-screen drawing
+    smp_init();
+    boot_mark("cores");
+
+
+    initializeMasterMaze();
+    boot_mark("maze");
+
+    // Work out the coverage masks of the anti-aliased brushes
+    brush_init();
+    boot_mark("brushes");
+
+    // Create an array of size NUMBUTTONS to hold all the buttons that we are using on the SNES controller
+    struct Button buttons[NUMBUTTONS];
+    buttons[0] = createButton(3, "Start");
+    buttons[1] = createButton(4, "Up");
+    buttons[2] = createButton(5, "Down");
+    buttons[3] = createButton(6, "Left");
+    buttons[4] = createButton(7, "Right");
+    buttons[5] = createButton(9, "X");
+
+    // Create a character represented by an x, y position
+    struct Point character = createPoint(CANVAS_WIDTH/2, CANVAS_HEIGHT/2);
+
+    // Show the part of the canvas around the character
+    view_init(character.x, character.y);
+
+    drawMaze();
+
+    // Draw the character
+    drawSquare(character.x, character.y, RED);
+
+    // Start recording the pen strokes from the initial pen position
+    journal_start(character.x, character.y, brushSize, get_timer_counter());
+
+    // Set up the on-screen display of the pen position and timing
+    hud_init(view_surface());
+    boot_mark("first frame");
+
+    // Show how long each phase of the boot took, up to the first frame
+    boot_report();
+
+    // Start the frame scheduler, which paces the loop below
+    frame_init(FRAME_RATE);
+
+    //
+    while (1) {
+    	// Read the latest data published by the SNES sampler
+    	snes_get_state(&controller);
+    	data = controller.buttons;
+
+            // Handle any command typed on the UART terminal
+            if (uart_rx_ready())
+                handleCommand(uart_getc(), &character);
+
+            // Handle new button presses (undo, redo, and stroke starts)
+            while (snes_get_event(&event)) {
+                if (event.pad == 0 && event.pressed)
+                    handleButtonPress(event.button, &character, event.timestamp);
+            }
+
+            // Record the state of the controller
+            currentState = data;
+
+            // If no buttons have been pressed
+            if (data == 0) {
+                drawHud(character.x, character.y);
+                frame_wait();
+                continue;
+            }
+
+            erase = 0;
+            oldX = character.x;
+            oldY = character.y;
+
+            for (int i = 0; i < NUMBUTTONS; ++i) {
+                if (((1 << buttons[i].number) & data) != 0) {
+
+
+                    switch (buttons[i].number) {
+                        // Start will reset the character's position
+                        case 3 :
+                        //character.x = 0;
+                        //character.y = 0;
+                        erase = 1;
+                        break;
+
+                        // Up will move the character up they if will still be within bounds
+                        case 4 :
+                        if (character.y > 0)
+                            character.y -= 1;
+                        break;
+
+                        // Down will move the character down if they will still be within bounds
+                        case 5 :
+                        if (character.y < CANVAS_HEIGHT - 1)
+                            character.y += 1;
+                        break;
+
+                        // Left will move the character left if they will still be within bounds
+                        case 6 :
+                        if (character.x > 0)
+                            character.x -= 1;
+                        break;
+
+                        // Right will move the character right if they will still be within bounds
+                        case 7 :
+                        if (character.x < CANVAS_WIDTH - 1)
+                            character.x += 1;
+                        break;
+
+                        // X fills when it is pressed (see handleButtonPress)
+                        case 9 :
+                        break;
+
+                        default :
+                        break;
+                    }
+                }
+            }
+
+            // Record the pen step (or the erase) in the stroke journal
+            if (erase)
+                journal_erase(controller.timestamp);
+            journal_move(character.x - oldX, character.y - oldY, controller.timestamp);
+
+            frame.sample = controller.timestamp;
+            frame.update = get_timer_counter();
+
+            // Scroll the screen if the character is near its edge
+            followPen(character.x, character.y);
+
+            // Erase the screen if Start was pressed, then draw the character.
+            // Buttons that do not move the pen (such as L and R) leave the
+            // canvas alone, so they do not start a new undo step.
+            if (erase)
+                eraseScreen();
+            if (erase || character.x != oldX || character.y != oldY)
+                drawBrush(character.x, character.y);
+            if (character.x != oldX || character.y != oldY) {
+                stepX = character.x - oldX;
+                stepY = character.y - oldY;
+            }
+            frame.raster = get_timer_counter();
+
+            // Wait until the pixel writes have reached the framebuffer
+            asm volatile("dsb sy" ::: "memory");
+            frame.present = get_timer_counter();
+
+            // Only frames that react to a new controller sample are timed
+            if (controller.sequence != lastSequence) {
+                latency_record(&frame);
+                lastSequence = controller.sequence;
+            }
+
+            drawHud(character.x, character.y);
+
+    	// Sleep until the next frame deadline
+    	frame_wait();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       handleCommand
+//
+//  Arguments:      char command, struct Point *character
+//
+//  Returns:        void
+//
+//  Description:    This function runs a single-character command received
+//                  on the UART terminal:
+//                      l   print the input-to-framebuffer latency report
+//                      r   reset the latency statistics
+//                      f   print the frame time statistics
+//                      j   send the stroke journal to the host (binary)
+//                      p   replay the stroke journal at 4x speed
+//                      P   replay the stroke journal instantly
+//                      s   send a compressed snapshot of the screen (binary)
+//                      c   print per-core timing of the last full redraw
+//                      m   print heap and arena usage
+//                      x   start or stop the sampling profiler
+//                      X   send the profile to the host (text)
+//                      t   send the event trace to the host (binary)
+//                      b   print the boot timeline again
+//
+//                  A replay redraws the canvas from the journal, so the
+//                  undo history is cleared before it starts, and is
+//                  rebuilt from the steps, undos and redos in the journal.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void handleCommand(char command, struct Point *character)
+{
+    switch (command) {
+        case 'l' :
+        latency_report();
+        break;
+
+        case 'r' :
+        latency_reset();
+        frame_reset_stats();
+        uart_puts("\nLatency and frame statistics reset\n");
+        break;
+
+        case 'f' :
+        frame_report();
+        break;
+
+        case 'j' :
+        journal_export();
+        break;
+
+        case 'p' :
+        undo_clear(character->x, character->y);
+        journal_replay(400, &replayer);
+        undo_checkpoint(character->x, character->y);
+        break;
+
+        case 'P' :
+        undo_clear(character->x, character->y);
+        journal_replay(0, &replayer);
+        undo_checkpoint(character->x, character->y);
+        break;
+
+        case 's' :
+        snapshot_send();
+        break;
+
+        case 'c' :
+        smp_report();
+        break;
+
+        case 'b' :
+        boot_report();
+        break;
+
+        case 'm' :
+        mem_report();
+        break;
+
+        case 'x' :
+        if (profile_running())
+            profile_stop();
+        else
+            profile_start(PROFILE_RATE);
+        break;
+
+        case 'X' :
+        profile_dump();
+        break;
+
+        case 't' :
+        trace_dump();
+        break;
+
+        default :
+        break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       handleButtonPress
+//
+//  Arguments:      button:     Button number (bit position) that was pressed
+//                  character:  The pen position
+//                  timestamp:  get_timer_counter() time of the press
+//
+//  Returns:        void
+//
+//  Description:    This function reacts to the moment a button goes down,
+//                  rather than to it being held. L undoes the last stroke
+//                  (or erase) and R redoes it, moving the pen back to where
+//                  the stroke started or ended. Pressing a direction or
+//                  Start begins a new step in the undo history. Select
+//                  changes the brush size, and X fills the area ahead of
+//                  the pen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void handleButtonPress(int button, struct Point *character, unsigned long timestamp)
+{
+    int moved = 0;
+
+    switch (button) {
+        // L undoes the last step
+        case 10 :
+        trace_begin(TRACE_UNDO, 0);
+        moved = undo_undo(&character->x, &character->y, redrawRegion);
+        trace_end(TRACE_UNDO, 0);
+        break;
+
+        // R redoes the step that was last undone
+        case 11 :
+        trace_begin(TRACE_UNDO, 1);
+        moved = undo_redo(&character->x, &character->y, redrawRegion);
+        trace_end(TRACE_UNDO, 1);
+        break;
+
+        // Select cycles through the brush sizes
+        case 2 :
+        brushSize = brush_next_size(brushSize);
+        journal_brush(brushSize, timestamp);
+        uart_puts("\nBrush size ");
+        uart_putdec(brushSize);
+        uart_puts("\n");
+        break;
+
+        // X fills the area ahead of the pen, as a step of its own
+        case 9 :
+        undo_checkpoint(character->x, character->y);
+        journal_step(timestamp);
+        fillAhead(character->x, character->y, timestamp);
+        break;
+
+        // Start and the directions begin a new step
+        case 3 :
+        case 4 :
+        case 5 :
+        case 6 :
+        case 7 :
+        undo_checkpoint(character->x, character->y);
+        journal_step(timestamp);
+        break;
+
+        default :
+        break;
+    }
+
+    // Journal the undo or redo, so that a replay takes the same steps back
+    if (moved) {
+        if (button == 10)
+            journal_undo(character->x, character->y, timestamp);
+        else
+            journal_redo(character->x, character->y, timestamp);
+        followPen(character->x, character->y);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       redrawRegion
+//
+//  Arguments:      x, y:       Top left corner of the region
+//                  w, h:       Size of the region in pixels
+//
+//  Returns:        void
+//
+//  Description:    This function redraws part of the screen from the canvas
+//                  model, after the undo history has changed it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void redrawRegion(int x, int y, int w, int h)
+{
+    view_present(x, y, w, h);
+    hud_invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       followPen
+//
+//  Arguments:      x, y:       The pen position
+//
+//  Returns:        void
+//
+//  Description:    This function scrolls the view to keep the pen on the
+//                  screen. The HUD stays in the corner of the screen, so
+//                  when the view moves, the canvas is put back where the
+//                  HUD was and the HUD is redrawn in its new place.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void followPen(int x, int y)
+{
+    int oldX = view_x(), oldY = view_y();
+
+    if (view_follow(x, y)) {
+        view_present(oldX + HUD_X, oldY + HUD_Y, HUD_WIDTH, HUD_HEIGHT);
+        hud_invalidate();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fillAhead
+//
+//  Arguments:      x, y:       The pen position
+//                  timestamp:  get_timer_counter() time of the press
+//
+//  Returns:        void
+//
+//  Description:    This function flood-fills the area of paper the pen last
+//                  moved towards. The pen always sits on its own ink, so
+//                  the fill starts from the first paper pixel found by
+//                  stepping on in the same direction, past the brush. To
+//                  fill the inside of a closed outline, take one step into
+//                  it and press X.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void fillAhead(int x, int y, unsigned long timestamp)
+{
+    int i;
+
+    for (i = 0; i <= BRUSH_MAX_SIZE; i++) {
+        if (!canvas_get(x + i * stepX, y + i * stepY)) {
+            if (fill_region(x + i * stepX, y + i * stepY, redrawRegion))
+                journal_fill(x + i * stepX, y + i * stepY, timestamp);
+            return;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       eraseScreen
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function erases the drawing, both in the canvas model
+//                  and on the screen, and makes the HUD redraw itself.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void eraseScreen()
+{
+    canvas_clear();
+    drawMaze();
+    hud_invalidate();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayPlot
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function stamps the brush at one pen position
+//                  during a journal replay, in the canvas model and on the
+//                  screen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayPlot(int x, int y)
+{
+    drawBrush(x, y);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayStep
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function begins a new undo step during a journal
+//                  replay, with the pen at the given position.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayStep(int x, int y)
+{
+    undo_checkpoint(x, y);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayUndo
+//
+//  Arguments:      int *x, int *y
+//
+//  Returns:        void
+//
+//  Description:    This function undoes the last step during a journal
+//                  replay, redrawing the parts of the screen it changed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayUndo(int *x, int *y)
+{
+    undo_undo(x, y, redrawRegion);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayRedo
+//
+//  Arguments:      int *x, int *y
+//
+//  Returns:        void
+//
+//  Description:    This function redoes the step last undone during a
+//                  journal replay, redrawing the parts of the screen it
+//                  changed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayRedo(int *x, int *y)
+{
+    undo_redo(x, y, redrawRegion);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayFill
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function repeats a flood fill during a journal
+//                  replay.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayFill(int x, int y)
+{
+    fill_region(x, y, redrawRegion);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       replayBrush
+//
+//  Arguments:      int size
+//
+//  Returns:        void
+//
+//  Description:    This function changes the brush size during a journal
+//                  replay. The journal ends with the size last chosen, so
+//                  the brush is left as it was before the replay.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void replayBrush(int size)
+{
+    brushSize = size;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawHud
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function updates the on-screen display with the pen
+//                  position, the frame rate, and the latest end-to-end input
+//                  latency. Only the characters that changed are redrawn.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void drawHud(int x, int y)
+{
+    hud_update(x, y, frame_fps(), latency_last(LATENCY_TOTAL));
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawSquare
+//
+//  Arguments:      int x, int y, unsigned int colour
+//
+//  Returns:        void
+//
+//  Description:    This function is used to draw on 1024 x 768 display. Each pixel 
+//                  in the frame buffer is 32 bits in size, which encodes an RGB value
+//                  (plus an 8-bit alpha channel that is not used). The program
+//                  then draws and displays squares. Each square has size of 1.
+//                  The position is on the canvas, and squares outside the
+//                  part on the screen are not drawn.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void drawSquare(int x, int y, unsigned int colour)
+{
+    view_fill(x * SQUARESIZE, y * SQUARESIZE, SQUARESIZE, SQUARESIZE, colour);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawBrush
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function stamps the pen's brush at a position on
+//                  the canvas. The canvas model gets the pixels the brush
+//                  mostly covers, and the screen gets the anti-aliased
+//                  brush blended over what is already there.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void drawBrush(int x, int y)
+{
+    brush_mark(x, y, brushSize);
+    brush_stamp(view_surface(), x - view_x(), y - view_y(), brushSize, BLACK);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawMazeAt
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        void
+//
+//  Description:    This function is used to draw at specific position. Each pixel 
+//                  in the frame buffer is 32 bits in size, which encodes an RGB value
+//                  (plus an 8-bit alpha channel that is not used). The program
+//                  then draws and displays at that pixel with color White.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+void drawMazeAt(int x, int y)
+{
+    drawSquare(x, y, mazeColour(x, y));
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mazeColour
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        unsigned int
+//
+//  Description:    This function returns the colour of the maze at a specific
+//                  position. Both kinds of maze cell are drawn White.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int mazeColour(int x, int y)
+{
+    switch (masterMaze[x][y]) {
+        case 0 :
+        return WHITE;
+
+        case 1 :
+        return WHITE;
+
+        default :
+        return WHITE;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawMaze
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function is used to draw maze on 1024 x 768 display. It
+//                  goes through the maze row by row and fills each run of
+//                  same-coloured cells with a single call, so the surface
+//                  fill routine can write whole words instead of one pixel
+//                  at a time.
+//                  The maze covers the visible part of the screen, wherever
+//                  the view is on the canvas. The rows are split between
+//                  the cores.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+void drawMaze()
+{
+    trace_begin(TRACE_MAZE, 0);
+    smp_bands(view_surface(), 0, MAZESIZEY, drawMazeBand, 0);
+    trace_end(TRACE_MAZE, 0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       drawMazeBand
+//
+//  Arguments:      void *arg, int y, int h
+//
+//  Returns:        void
+//
+//  Description:    This function draws rows y to y + h - 1 of the maze. It
+//                  runs on every core at once, each core with its own band
+//                  of rows (see smp_bands() in smp.c).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void drawMazeBand(void *arg, int y, int h)
+{
+    int x, start, end = y + h;
+    unsigned int colour;
+
+    for (; y < end; ++y) {
+        x = 0;
+        while (x < MAZESIZEX) {
+            // Find the end of the run of cells with the same colour
+            colour = mazeColour(x, y);
+            start = x;
+            while (x < MAZESIZEX && mazeColour(x, y) == colour)
+                ++x;
+
+            surface_fill_rect(view_surface(), start * SQUARESIZE, y * SQUARESIZE,
+                              (x - start) * SQUARESIZE, SQUARESIZE,
+                              surface_map_color(view_surface(), colour));
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       initializeMasterMaze
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function is used to initialize maze on 1024 x 768 display. Each pixel 
+//                  in the frame buffer is 32 bits in size, which encodes an RGB value
+//                  (plus an 8-bit alpha channel that is not used). 
+////////////////////////////////////////////////////////////////////////////////
+
+
+void initializeMasterMaze()
+{
+    masterMaze = mem_alloc(sizeof(int) * MAZESIZEX * MAZESIZEY, MEM_CACHE_LINE);
+
+    for (int i = 0; i < MAZESIZEX; ++i) {
+        for (int j = 0; j < MAZESIZEY; ++j) {
+            masterMaze[i][j] = ((i + j) % 2);
+        }
+    }
+} 
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Struct:       createButton
+//
+//  Arguments:      int number, char* name
+//
+//  Returns:        Button
+//
+//  Description:    This struct is used to create button that we are using on the 
+//							SNES controller
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+struct Button createButton(int number, char* name)
+{
+    struct Button b;
+    b.number = number;
+    b.name = name;
+    return b;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Struct:       createPoint
+//
+//  Arguments:      int x, int y
+//
+//  Returns:        Point
+//
+//  Description:    This struct is used to create point represented by x and y position
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Point createPoint(int x, int y)
+{
+    struct Point p;
+    p.x = x;
+    p.y = y;
+    return p;
+}
+
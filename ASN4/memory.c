@@ -0,0 +1,260 @@
+// The functions in this file manage the memory after the end of the
+// program. The size of the ARM's share of RAM is asked for through the
+// mailbox, and everything from _end up to the top of it becomes the heap.
+//
+// The heap itself is only ever allocated from, never freed: it is carved
+// up at start-up into buffers that live for the whole run, and into
+// arenas, which are recycled by resetting them. This keeps every
+// allocation O(1) and makes fragmentation impossible.
+
+#include "uart.h"
+#include "mailbox.h"
+#include "memory.h"
+
+// Provided by the linker script: the first address after .bss
+extern unsigned char _end[];
+
+// The heap, and the allocation high-water mark within it
+static unsigned long heapStart, heapTop, heapNext;
+static unsigned long ramBase, ramSize;
+
+// Arenas, for mem_report()
+static struct Arena *arenas[MEM_MAX_REGIONS];
+static unsigned int arenaCount;
+
+struct Arena mem_scratch;
+
+
+
+static unsigned long align_up(unsigned long value, unsigned long align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mem_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function finds the ARM memory with the get ARM
+//                  memory mailbox tag and sets up the heap between _end and
+//                  the top of it. If the query fails, 256 MB is assumed,
+//                  which every Raspberry Pi 3 has. The scratch arena is
+//                  the first thing taken from the heap. It is called by
+//                  the first allocation if it has not been called already.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void mem_init()
+{
+    if (heapTop != 0)
+        return;
+
+    mailbox_buffer[0] = 8 * 4;
+    mailbox_buffer[1] = MAILBOX_REQUEST;
+    mailbox_buffer[2] = TAG_GET_ARM_MEMORY;
+    mailbox_buffer[3] = 8;
+    mailbox_buffer[4] = 0;
+    mailbox_buffer[5] = 0;    // Response: base address
+    mailbox_buffer[6] = 0;    // Response: size in bytes
+    mailbox_buffer[7] = TAG_LAST;
+
+    if (mailbox_query(CHANNEL_PROPERTY_TAGS_ARMTOVC) && mailbox_buffer[6] != 0) {
+        ramBase = mailbox_buffer[5];
+        ramSize = mailbox_buffer[6];
+    } else {
+        ramBase = 0;
+        ramSize = 0x10000000;
+    }
+
+    heapStart = heapNext = align_up((unsigned long)_end, MEM_CACHE_LINE);
+    heapTop = ramBase + ramSize;
+
+    arena_init(&mem_scratch, "scratch", MEM_SCRATCH_SIZE);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mem_alloc
+//
+//  Arguments:      size:      Number of bytes
+//                  align:     Alignment in bytes (a power of 2, or 0 for
+//                             the default of 16)
+//
+//  Returns:        A pointer to the memory, or 0 if the heap is exhausted
+//
+//  Description:    This function takes memory from the heap for good. The
+//                  memory is not cleared.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void *mem_alloc(unsigned long size, unsigned long align)
+{
+    unsigned long address;
+
+    mem_init();
+
+    address = align_up(heapNext, align ? align : 16);
+    if (address + size > heapTop || address + size < address)
+        return 0;
+
+    heapNext = address + size;
+    return (void *)address;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mem_free_bytes
+//
+//  Arguments:      none
+//
+//  Returns:        The number of heap bytes not yet allocated
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long mem_free_bytes()
+{
+    mem_init();
+
+    return heapTop - heapNext;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arena_init
+//
+//  Arguments:      a:         The arena to set up
+//                  name:      Name shown by mem_report()
+//                  size:      Number of bytes to reserve
+//
+//  Returns:        TRUE (non-zero) on success, FALSE (zero) if the heap is
+//                  exhausted
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int arena_init(struct Arena *a, char *name, unsigned long size)
+{
+    a->name = name;
+    a->base = mem_alloc(size, MEM_CACHE_LINE);
+    a->size = a->base ? size : 0;
+    a->used = a->peak = 0;
+
+    if (arenaCount < MEM_MAX_REGIONS)
+        arenas[arenaCount++] = a;
+
+    return a->base != 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arena_alloc
+//
+//  Arguments:      a:         The arena
+//                  size:      Number of bytes
+//                  align:     Alignment in bytes (a power of 2, or 0 for
+//                             the default of 16); MEM_CACHE_LINE keeps the
+//                             memory on cache lines of its own
+//
+//  Returns:        A pointer to the memory, or 0 if the arena is full
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void *arena_alloc(struct Arena *a, unsigned long size, unsigned long align)
+{
+    unsigned long offset = align_up(a->used, align ? align : 16);
+
+    if (offset + size > a->size || offset + size < offset)
+        return 0;
+
+    a->used = offset + size;
+    if (a->used > a->peak)
+        a->peak = a->used;
+
+    return a->base + offset;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arena_mark, arena_reset
+//
+//  Arguments:      a:         The arena
+//                  mark:      A value returned by arena_mark()
+//
+//  Description:    arena_mark() records how much of the arena is in use,
+//                  and arena_reset() frees everything allocated after that
+//                  in one step. Resetting to 0 empties the arena.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long arena_mark(struct Arena *a)
+{
+    return a->used;
+}
+
+void arena_reset(struct Arena *a, unsigned long mark)
+{
+    if (mark < a->used)
+        a->used = mark;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mem_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function prints the RAM size, how much of the heap
+//                  has been handed out, and the current and peak use of
+//                  every arena. Sizes are in bytes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void mem_report()
+{
+    unsigned int i;
+
+    mem_init();
+
+    uart_puts("\nMemory: ARM RAM 0x");
+    uart_puthex((unsigned int)ramBase);
+    uart_puts(" - 0x");
+    uart_puthex((unsigned int)(ramBase + ramSize));
+    uart_puts(", heap from 0x");
+    uart_puthex((unsigned int)heapStart);
+    uart_puts("\n    heap used ");
+    uart_putdec(heapNext - heapStart);
+    uart_puts(", free ");
+    uart_putdec(heapTop - heapNext);
+    uart_puts("\n");
+
+    for (i = 0; i < arenaCount; i++) {
+        uart_puts("    arena ");
+        uart_puts(arenas[i]->name);
+        uart_puts(": used ");
+        uart_putdec(arenas[i]->used);
+        uart_puts(" peak ");
+        uart_putdec(arenas[i]->peak);
+        uart_puts(" of ");
+        uart_putdec(arenas[i]->size);
+        uart_puts("\n");
+    }
+}
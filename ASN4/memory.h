@@ -0,0 +1,43 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// Alignment that keeps an allocation on cache lines of its own, which is
+// also what DMA control blocks need
+#define MEM_CACHE_LINE      64
+
+// Number of arenas that mem_report() can list
+#define MEM_MAX_REGIONS     8
+
+// Size of the shared scratch arena in bytes
+#define MEM_SCRATCH_SIZE    65536
+
+// A bump allocator over a fixed block. Allocation is a pointer increment;
+// memory is given back all at once by resetting to an earlier mark, which
+// suits scratch memory that only lives for a frame or an operation.
+struct Arena
+{
+    char *name;
+    unsigned char *base;
+    unsigned long size;
+    unsigned long used;
+    unsigned long peak;
+};
+
+// Scratch memory shared by operations that need a buffer only while they
+// run, such as a fill or a snapshot. Each one takes a mark first and
+// resets to it when it is done.
+extern struct Arena mem_scratch;
+
+// Function prototypes
+void mem_init();
+void *mem_alloc(unsigned long size, unsigned long align);
+unsigned long mem_free_bytes();
+
+int arena_init(struct Arena *a, char *name, unsigned long size);
+void *arena_alloc(struct Arena *a, unsigned long size, unsigned long align);
+unsigned long arena_mark(struct Arena *a);
+void arena_reset(struct Arena *a, unsigned long mark);
+
+void mem_report();
+
+#endif
@@ -0,0 +1,511 @@
+// The functions in this file drive the PL011 UART (UART0) instead of the
+// Mini UART. They are compiled in place of the Mini UART functions in
+// uart.c when UART_PL011 is defined (type 'make UART=pl011'), so callers
+// of uart_puts(), uart_puthex() and the rest do not change.
+//
+// Compared with the Mini UART, the PL011 has its own 48 MHz reference
+// clock with a fractional baud divisor (so 921600 baud and above are
+// exact to within 1%), and 16-entry transmit and receive FIFOs that raise
+// an interrupt when they cross a threshold. Transmitted characters go into
+// a software ring that the interrupt handler moves into the FIFO, so
+// uart_putc() only waits when the ring is full. Received characters are
+// collected by the interrupt handler in a second ring. Bulk data (such as
+// snapshots) can be sent with uart_write(), which hands the bytes to a DMA
+// channel paced by the UART's transmit DMA request.
+//
+// Both rings have one producer and one consumer. While IRQs are masked on
+// the CPU (before enableIRQ() is called, for example) the thread side does
+// the interrupt handler's work itself, so the driver works either way.
+
+#ifdef UART_PL011
+
+#include "gpio.h"
+#include "irq.h"
+#include "mailbox.h"
+#include "dma.h"
+#include "uart.h"
+#include "memory.h"
+#include "trace.h"
+#include "boot.h"
+
+// The addresses of the PL011 UART registers.
+//
+// These are defined on pages 175 - 191 of the Broadcom BCM2837 ARM
+// Peripherals Manual.
+#define UART0_DR        ((volatile unsigned int *)(MMIO_BASE + 0x00201000))
+#define UART0_FR        ((volatile unsigned int *)(MMIO_BASE + 0x00201018))
+#define UART0_IBRD      ((volatile unsigned int *)(MMIO_BASE + 0x00201024))
+#define UART0_FBRD      ((volatile unsigned int *)(MMIO_BASE + 0x00201028))
+#define UART0_LCRH      ((volatile unsigned int *)(MMIO_BASE + 0x0020102C))
+#define UART0_CR        ((volatile unsigned int *)(MMIO_BASE + 0x00201030))
+#define UART0_IFLS      ((volatile unsigned int *)(MMIO_BASE + 0x00201034))
+#define UART0_IMSC      ((volatile unsigned int *)(MMIO_BASE + 0x00201038))
+#define UART0_MIS       ((volatile unsigned int *)(MMIO_BASE + 0x00201040))
+#define UART0_ICR       ((volatile unsigned int *)(MMIO_BASE + 0x00201044))
+#define UART0_DMACR     ((volatile unsigned int *)(MMIO_BASE + 0x00201048))
+
+// Flag register bits
+#define UART0_FR_RXFE   (0x1 << 4)
+#define UART0_FR_TXFF   (0x1 << 5)
+#define UART0_FR_TXFE   (0x1 << 7)
+#define UART0_FR_BUSY   (0x1 << 3)
+
+// Interrupt bits (IMSC, MIS and ICR)
+#define UART0_INT_RX    (0x1 << 4)
+#define UART0_INT_TX    (0x1 << 5)
+#define UART0_INT_RT    (0x1 << 6)
+#define UART0_INT_ALL   0x7FF
+
+// The reference clock we ask the firmware for, in Hz
+#define UART0_CLOCK     48000000
+
+// Sizes of the software rings (powers of 2)
+#define TX_RING_SIZE    4096
+#define RX_RING_SIZE    256
+
+// Largest block sent in one DMA transfer
+#define DMA_BLOCK_SIZE  4096
+
+// Transmit and receive rings. The head is written only by the producer and
+// the tail only by the consumer.
+static unsigned char txRing[TX_RING_SIZE] BOOT_LAZY, rxRing[RX_RING_SIZE] BOOT_LAZY;
+static volatile unsigned int txHead, txTail, rxHead, rxTail;
+static volatile unsigned int rxOverruns;
+
+// Two bounce buffers for DMA, so the next block can be copied while the
+// previous one is being sent. They and their control blocks come from the
+// heap on cache lines of their own.
+static unsigned char (*dmaBuffer)[DMA_BLOCK_SIZE];
+static struct DMAControlBlock *dmaBlock;
+static int dmaChannel = -1, dmaNext;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irq_save, irq_restore
+//
+//  Description:    These functions mask IRQs on the CPU and later put the
+//                  mask back the way it was, so a critical section can be
+//                  entered both with and without interrupts enabled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned long irq_save()
+{
+    unsigned long daif;
+
+    asm volatile("mrs %0, daif" : "=r" (daif));
+    asm volatile("msr daifset, #2" ::: "memory");
+
+    return daif;
+}
+
+static void irq_restore(unsigned long daif)
+{
+    asm volatile("msr daif, %0" :: "r" (daif) : "memory");
+}
+
+static int irq_masked()
+{
+    unsigned long daif;
+
+    asm volatile("mrs %0, daif" : "=r" (daif));
+
+    return (daif >> 7) & 0x1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       tx_pump
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function moves characters from the transmit ring
+//                  into the FIFO until one of them is full or empty, and
+//                  turns the transmit interrupt on only while characters
+//                  are left waiting. It runs in the interrupt handler, or
+//                  in thread code with IRQs masked.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void tx_pump()
+{
+    unsigned int tail = txTail;
+
+    while (tail != txHead && !(*UART0_FR & UART0_FR_TXFF)) {
+        *UART0_DR = txRing[tail & (TX_RING_SIZE - 1)];
+        tail++;
+    }
+    txTail = tail;
+
+    if (tail != txHead)
+        *UART0_IMSC |= UART0_INT_TX;
+    else
+        *UART0_IMSC &= ~UART0_INT_TX;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       rx_drain
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function moves received characters from the FIFO
+//                  into the receive ring. Characters that do not fit are
+//                  counted and dropped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void rx_drain()
+{
+    unsigned int head = rxHead, c;
+
+    while (!(*UART0_FR & UART0_FR_RXFE)) {
+        c = *UART0_DR & 0xFF;
+
+        if (head - rxTail < RX_RING_SIZE)
+            rxRing[head++ & (RX_RING_SIZE - 1)] = c;
+        else
+            rxOverruns++;
+    }
+
+    asm volatile("dmb ish" ::: "memory");
+    rxHead = head;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function initializes the PL011 UART (UART0). The
+//                  reference clock is set to 48 MHz through the mailbox,
+//                  GPIO pins 14 and 15 are mapped to UART0, and the UART is
+//                  set up for 8 data bits, no parity, 1 stop bit at
+//                  UART_BAUD, with the FIFOs and interrupts enabled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void uart_init()
+{
+    register unsigned int r;
+    unsigned int divisor;
+
+    // Turn the UART off while it is being set up
+    *UART0_CR = 0;
+
+    // Ask the firmware for a fixed reference clock, so that the baud rate
+    // does not depend on the core clock
+    mailbox_buffer[0] = 9 * 4;
+    mailbox_buffer[1] = MAILBOX_REQUEST;
+    mailbox_buffer[2] = TAG_SET_CLOCK_RATE;
+    mailbox_buffer[3] = 12;
+    mailbox_buffer[4] = 0;
+    mailbox_buffer[5] = CLOCK_UART;
+    mailbox_buffer[6] = UART0_CLOCK;
+    mailbox_buffer[7] = 0;    // Do not skip turbo setting
+    mailbox_buffer[8] = TAG_LAST;
+    mailbox_query(CHANNEL_PROPERTY_TAGS_ARMTOVC);
+
+    // Map UART0 to GPIO pins 14 and 15 (alternate function 0, which is
+    // the bit pattern 100 in fields FSEL14 and FSEL15)
+    r = *GPFSEL1;
+    r &= ~( (0x7 << 12) | (0x7 << 15) );
+    r |= (0x4 << 12) | (0x4 << 15);
+    *GPFSEL1 = r;
+
+    // Disable the pull-up/pull-down control line for pins 14 and 15, as
+    // in the Mini UART version
+    *GPPUD = 0x0;
+    r = 150;
+    while (r--) {
+      asm volatile("nop");
+    }
+    *GPPUDCLK0 = (0x1 << 14) | (0x1 << 15);
+    r = 150;
+    while (r--) {
+      asm volatile("nop");
+    }
+    *GPPUDCLK0 = 0;
+
+    // Clear any pending interrupts
+    *UART0_ICR = UART0_INT_ALL;
+
+    // The divisor is clock / (16 * baud), with 6 fractional bits. Work it
+    // out in 64ths, rounded to nearest: 48 MHz and 921600 baud gives 3 +
+    // 16/64, which is 0.2% fast.
+    divisor = (4 * UART0_CLOCK + UART_BAUD / 2) / UART_BAUD;
+    *UART0_IBRD = divisor >> 6;
+    *UART0_FBRD = divisor & 0x3F;
+
+    // 8 bits, no parity, 1 stop bit, FIFOs enabled. Writing LCRH also
+    // latches the divisor.
+    *UART0_LCRH = (0x3 << 5) | (0x1 << 4);
+
+    // Interrupt when the transmit FIFO drains to 1/4 full (so there is
+    // still time to refill it) and when the receive FIFO reaches 1/2 full.
+    // The receive timeout interrupt picks up anything below that.
+    *UART0_IFLS = (0x2 << 3) | (0x1 << 0);
+
+    // Receive interrupts are always on. The transmit interrupt is turned on
+    // by tx_pump() when the ring has characters left.
+    txHead = txTail = rxHead = rxTail = 0;
+    *UART0_IMSC = UART0_INT_RX | UART0_INT_RT;
+    *IRQ_ENABLE_IRQS_2 = UART0_IRQ;
+
+    // Claim a DMA channel for bulk transmit. The UART asks for data when
+    // its transmit FIFO is at or below the threshold.
+    if (dmaBlock == 0) {
+        dmaBuffer = mem_alloc(2 * DMA_BLOCK_SIZE, MEM_CACHE_LINE);
+        dmaBlock = mem_alloc(2 * sizeof(struct DMAControlBlock), MEM_CACHE_LINE);
+    }
+    if (dmaBuffer != 0 && dmaBlock != 0)
+        dmaChannel = dma_claim();
+    if (dmaChannel >= 0)
+        *UART0_DMACR = 0x1 << 1;
+
+    // Enable the UART, its transmitter and its receiver
+    *UART0_CR = (0x1 << 0) | (0x1 << 8) | (0x1 << 9);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_irq_handler
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function services the UART0 interrupt. It is
+//                  called by IRQ_handler().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void uart_irq_handler()
+{
+    unsigned int status = *UART0_MIS;
+
+    trace_begin(TRACE_UART, status);
+
+    if (status & (UART0_INT_RX | UART0_INT_RT))
+        rx_drain();
+
+    if (status & UART0_INT_TX)
+        tx_pump();
+
+    *UART0_ICR = status;
+
+    trace_end(TRACE_UART, status);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_putc
+//
+//  Arguments:      c:     The character to write to the terminal
+//
+//  Returns:        void
+//
+//  Description:    This function adds the character c to the transmit ring
+//                  and starts it on its way. It only waits when the ring is
+//                  full, or when a DMA transfer is still using the FIFO.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void uart_putc(unsigned int c)
+{
+    unsigned long daif;
+
+    // DMA and the ring must not interleave in the FIFO
+    if (dmaChannel >= 0)
+        dma_wait(dmaChannel);
+
+    // Wait for room, doing the interrupt handler's work meanwhile
+    while (txHead - txTail >= TX_RING_SIZE) {
+        daif = irq_save();
+        tx_pump();
+        irq_restore(daif);
+    }
+
+    txRing[txHead & (TX_RING_SIZE - 1)] = c;
+    asm volatile("dmb ish" ::: "memory");
+    txHead++;
+
+    // Prime the FIFO. The transmit interrupt only fires when the FIFO
+    // level falls through the threshold, so it has to be fed to start.
+    daif = irq_save();
+    tx_pump();
+    irq_restore(daif);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_rx_ready
+//
+//  Arguments:      none
+//
+//  Returns:        TRUE (non-zero) if a character has been received,
+//                  FALSE (zero) otherwise.
+//
+//  Description:    This function checks the receive ring without waiting.
+//                  If IRQs are masked, the FIFO is drained here instead of
+//                  in the interrupt handler.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int uart_rx_ready()
+{
+    if (irq_masked())
+        rx_drain();
+
+    return rxHead != rxTail;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_getc
+//
+//  Arguments:      none
+//
+//  Returns:        The character last received from the terminal
+//
+//  Description:    This function waits for a character to be received. If
+//                  the character is a carriage return, it is converted to a
+//                  newline character.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+char uart_getc()
+{
+    char r;
+
+    while (!uart_rx_ready())
+        asm volatile("nop");
+
+    asm volatile("dmb ish" ::: "memory");
+    r = (char)rxRing[rxTail & (RX_RING_SIZE - 1)];
+    rxTail++;
+
+    return r == '\r' ? '\n' : r;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_write
+//
+//  Arguments:      data:      Bytes to send
+//                  length:    Number of bytes
+//
+//  Returns:        void
+//
+//  Description:    This function sends a block of bytes unchanged (no
+//                  newline conversion). The bytes are copied into a DMA
+//                  bounce buffer and sent while the caller gets on with
+//                  preparing the next block; the function only waits for
+//                  the previous block when both buffers are in use. If no
+//                  DMA channel is available, it falls back to uart_putc().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void uart_write(const void *data, unsigned int length)
+{
+    const unsigned char *p = data;
+    struct DMAControlBlock *block;
+    unsigned int count, i;
+    unsigned long daif;
+
+    if (dmaChannel < 0) {
+        while (length--)
+            uart_putc(*p++);
+        return;
+    }
+
+    // Send whatever is still in the ring first, to keep the bytes in order
+    while (txTail != txHead) {
+        daif = irq_save();
+        tx_pump();
+        irq_restore(daif);
+    }
+
+    while (length > 0) {
+        count = length < DMA_BLOCK_SIZE ? length : DMA_BLOCK_SIZE;
+
+        // The other buffer may still be in flight, but this one is free
+        for (i = 0; i < count; i++)
+            dmaBuffer[dmaNext][i] = p[i];
+
+        block = &dmaBlock[dmaNext];
+        block->transferInfo = DMA_TI_SRC_INC | DMA_TI_DEST_DREQ |
+                              DMA_TI_PERMAP(DMA_PERMAP_UART_TX) | DMA_TI_WAIT_RESP;
+        block->source = DMA_BUS_ADDRESS(dmaBuffer[dmaNext]);
+        block->destination = DMA_BUS_PERIPHERAL(UART0_DR);
+        block->length = count;
+        block->stride = 0;
+        block->next = 0;
+
+        dma_wait(dmaChannel);
+        dma_start(dmaChannel, block);
+
+        dmaNext ^= 1;
+        p += count;
+        length -= count;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       uart_flush
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function waits until every queued character has
+//                  left the UART.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void uart_flush()
+{
+    unsigned long daif;
+
+    if (dmaChannel >= 0)
+        dma_wait(dmaChannel);
+
+    while (txTail != txHead) {
+        daif = irq_save();
+        tx_pump();
+        irq_restore(daif);
+    }
+
+    while (*UART0_FR & UART0_FR_BUSY)
+        asm volatile("nop");
+}
+
+#endif
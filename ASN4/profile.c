@@ -0,0 +1,329 @@
+// The functions in this file implement a statistical sampling profiler.
+// The ARM Timer interrupts core 0 at a fixed rate, and each interrupt
+// records where the core was: the PC it will return to (ELR_EL1) and,
+// when the program is built with frame pointers, the return addresses
+// found by walking the chain of frame records from the interrupted x29.
+// Identical samples are counted in a hash table, so the memory used
+// depends on how many different places are sampled, not for how long.
+//
+// The 'X' UART command sends the table as text, one line per distinct
+// stack, which the host tool host/profsym turns into a flat profile and
+// folded stacks using the symbols in kernel8.dump. Code that runs with
+// IRQs masked (the interrupt handlers themselves, for instance) is never
+// sampled, and the other cores are not sampled at all.
+
+#include "armtimer.h"
+#include "irq.h"
+#include "mailbox.h"
+#include "memory.h"
+#include "smp.h"
+#include "sysreg.h"
+#include "timebase.h"
+#include "uart.h"
+#include "profile.h"
+
+// A distinct stack and the number of samples that hit it. pc[0] is the
+// sampled PC, and pc[1] onwards the return addresses of its callers.
+struct ProfileEntry
+{
+    unsigned int count;
+    unsigned int depth;
+    unsigned long pc[PROFILE_MAX_DEPTH];
+};
+
+// Provided by the linker script; the stacks lie just below it (see start.s)
+extern unsigned char _start[];
+
+static struct ProfileEntry *table;
+static volatile int running;
+static unsigned int sampleRate, samples, lost;
+
+// Time spent taking samples, and the time the profiler ran, in generic
+// timer ticks
+static unsigned long busy, startTime, runTime;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       core_clock
+//
+//  Arguments:      none
+//
+//  Returns:        The core clock rate in Hz, which the ARM Timer counts
+//                  from. If the firmware does not answer, 250 MHz is
+//                  assumed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int core_clock()
+{
+    mailbox_buffer[0] = 8 * 4;
+    mailbox_buffer[1] = MAILBOX_REQUEST;
+    mailbox_buffer[2] = TAG_GET_CLOCK_RATE;
+    mailbox_buffer[3] = 8;
+    mailbox_buffer[4] = 0;
+    mailbox_buffer[5] = CLOCK_CORE;
+    mailbox_buffer[6] = 0;    // Response: rate in Hz
+    mailbox_buffer[7] = TAG_LAST;
+
+    if (mailbox_query(CHANNEL_PROPERTY_TAGS_ARMTOVC) && mailbox_buffer[6] != 0)
+        return mailbox_buffer[6];
+
+    return 250000000;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_start
+//
+//  Arguments:      rate:      Samples per second (0 for PROFILE_RATE)
+//
+//  Returns:        void
+//
+//  Description:    This function clears the histogram and starts sampling.
+//                  The ARM Timer is divided down to 1 MHz, so rates up to
+//                  a few tens of kHz can be asked for; the cost of a
+//                  sample is reported by profile_stop(), and at the default
+//                  rate it is well under 1% of the CPU. The table is taken
+//                  from the heap the first time.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_start(unsigned int rate)
+{
+    unsigned int i;
+
+    if (running)
+        profile_stop();
+
+    if (table == 0) {
+        table = mem_alloc(PROFILE_BUCKETS * sizeof(struct ProfileEntry), MEM_CACHE_LINE);
+        if (table == 0) {
+            uart_puts("\nProfiler: not enough memory\n");
+            return;
+        }
+    }
+
+    for (i = 0; i < PROFILE_BUCKETS; i++)
+        table[i].count = 0;
+
+    sampleRate = rate ? rate : PROFILE_RATE;
+    samples = lost = 0;
+    busy = runTime = 0;
+
+    // Count down at 1 MHz, and interrupt once per sample
+    *ARM_TIMER_CONTROL = 0;
+    *ARM_TIMER_PREDIVIDER = core_clock() / 1000000 - 1;
+    *ARM_TIMER_LOAD = 1000000 / sampleRate - 1;
+    *ARM_TIMER_RELOAD = 1000000 / sampleRate - 1;
+    *ARM_TIMER_IRQ_CLEAR = 1;
+
+    startTime = timebase_ticks();
+    running = 1;
+
+    *ARM_TIMER_CONTROL = ARM_TIMER_CTRL_32BIT | ARM_TIMER_CTRL_IRQ | ARM_TIMER_CTRL_ENABLE;
+    *IRQ_ENABLE_BASIC_IRQS = ARM_TIMER_IRQ;
+
+    uart_puts("\nProfiling at ");
+    uart_putdec(sampleRate);
+    uart_puts(" samples per second\n");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_stop
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function stops sampling and prints the number of
+//                  samples and the share of the CPU that taking them cost.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_stop()
+{
+    unsigned long hundredths;
+
+    if (!running)
+        return;
+
+    *IRQ_DISABLE_BASIC_IRQS = ARM_TIMER_IRQ;
+    *ARM_TIMER_CONTROL = 0;
+    *ARM_TIMER_IRQ_CLEAR = 1;
+    running = 0;
+    runTime = timebase_ticks() - startTime;
+
+    // Overhead in hundredths of a percent
+    hundredths = runTime ? busy * 10000 / runTime : 0;
+
+    uart_puts("\nProfiler stopped: ");
+    uart_putdec(samples);
+    uart_puts(" samples (");
+    uart_putdec(lost);
+    uart_puts(" not recorded), overhead ");
+    uart_putdec(hundredths / 100);
+    uart_puts(".");
+    uart_putdec_padded(hundredths % 100, 2);
+    uart_puts("%\n");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_running
+//
+//  Arguments:      none
+//
+//  Returns:        TRUE (non-zero) while samples are being taken
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int profile_running()
+{
+    return running;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_tick
+//
+//  Arguments:      registers:  The registers saved by the IRQ stub
+//
+//  Returns:        void
+//
+//  Description:    This function is called by the IRQ handler when the ARM
+//                  Timer interrupts, and records one sample. Frame records
+//                  are only followed while they lie inside core 0's stack,
+//                  in order, so a corrupt chain cannot cause a fault.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_tick(unsigned long *registers)
+{
+    unsigned long start = timebase_ticks();
+    unsigned long pc[PROFILE_MAX_DEPTH], hash;
+    unsigned int depth = 1, i, j, probe;
+    struct ProfileEntry *entry;
+#ifdef PROFILE_STACKS
+    unsigned long fp = registers[IRQ_FRAME_X29];
+    unsigned long low = (unsigned long)_start - SMP_STACK_SIZE;
+    unsigned long high = (unsigned long)_start;
+#endif
+
+    *ARM_TIMER_IRQ_CLEAR = 1;
+    if (!running)
+        return;
+
+    pc[0] = getELR();
+
+#ifdef PROFILE_STACKS
+    // Each frame record holds the caller's x29, then the return address
+    while (depth < PROFILE_MAX_DEPTH && fp >= low && fp + 16 <= high && (fp & 0x7) == 0) {
+        if (((unsigned long *)fp)[1] == 0)
+            break;
+        pc[depth++] = ((unsigned long *)fp)[1];
+        if (((unsigned long *)fp)[0] <= fp)
+            break;
+        fp = ((unsigned long *)fp)[0];
+    }
+#endif
+
+    // FNV-1a over the addresses
+    hash = 0xCBF29CE484222325UL;
+    for (i = 0; i < depth; i++)
+        hash = (hash ^ pc[i]) * 0x100000001B3UL;
+
+    samples++;
+    for (probe = 0; probe < PROFILE_PROBES; probe++) {
+        entry = &table[(hash + probe) & (PROFILE_BUCKETS - 1)];
+
+        if (entry->count == 0) {
+            entry->depth = depth;
+            for (i = 0; i < depth; i++)
+                entry->pc[i] = pc[i];
+        } else {
+            if (entry->depth != depth)
+                continue;
+            for (j = 0; j < depth && entry->pc[j] == pc[j]; j++)
+                ;
+            if (j != depth)
+                continue;
+        }
+
+        entry->count++;
+        break;
+    }
+
+    if (probe == PROFILE_PROBES)
+        lost++;
+
+    busy += timebase_ticks() - start;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_dump
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function stops the profiler and sends the histogram
+//                  over the UART as text:
+//
+//                      #PROFILE <rate> <samples> <not recorded> <run time us>
+//                      <count> <pc> [<return address> ...]
+//                      ...
+//                      #END
+//
+//                  Addresses are in hexadecimal, innermost first.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_dump()
+{
+    unsigned int i, j;
+
+    profile_stop();
+
+    if (table == 0) {
+        uart_puts("\nProfiler: no samples\n");
+        return;
+    }
+
+    uart_puts("\n#PROFILE ");
+    uart_putdec(sampleRate);
+    uart_puts(" ");
+    uart_putdec(samples);
+    uart_puts(" ");
+    uart_putdec(lost);
+    uart_puts(" ");
+    uart_putdec(ticks_to_us(runTime));
+    uart_puts("\n");
+
+    for (i = 0; i < PROFILE_BUCKETS; i++) {
+        if (table[i].count == 0)
+            continue;
+
+        uart_putdec(table[i].count);
+        for (j = 0; j < table[i].depth; j++) {
+            uart_puts(" ");
+            uart_puthex((unsigned int)table[i].pc[j]);
+        }
+        uart_puts("\n");
+    }
+
+    uart_puts("#END\n");
+}
@@ -0,0 +1,27 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Default number of samples per second. It is prime so that the samples
+// do not fall into step with the 1 kHz controller sampler or the frame
+// rate, which would make some code look busier than it is.
+#ifndef PROFILE_RATE
+#define PROFILE_RATE        997
+#endif
+
+// Most return addresses kept per sample when walking the frame pointers
+// (only with 'make FRAME_POINTERS=yes', which defines PROFILE_STACKS)
+#define PROFILE_MAX_DEPTH   16
+
+// Number of distinct stacks (or PCs) the histogram can hold (must be a
+// power of 2), and how far a lookup probes before giving up on a sample
+#define PROFILE_BUCKETS     4096
+#define PROFILE_PROBES      32
+
+// Function prototypes
+void profile_start(unsigned int rate);
+void profile_stop();
+int profile_running();
+void profile_tick(unsigned long *registers);
+void profile_dump();
+
+#endif
@@ -0,0 +1,302 @@
+// The functions in this file put all four cores to work on drawing. Cores
+// 1 - 3 are woken up once by smp_init(), and from then on wait in a wfe
+// loop for a job. smp_bands() splits a region of a surface into one band of
+// rows per core, hands a band to each of cores 1 - 3, draws the first band
+// itself, and waits until every core has finished.
+//
+// The cores share no locks and need no atomic instructions (which do not
+// work on memory while the MMU is off). Each word below has exactly one
+// writer: core 0 writes a core's job and then bumps its sequence number,
+// and the core writes back the sequence number when it is done. Each
+// core's slot fills its own cache lines, so the cores never write to the
+// same line.
+
+#include "uart.h"
+#include "systimer.h"
+#include "timebase.h"
+#include "trace.h"
+#include "smp.h"
+
+// Addresses the firmware's boot stub polls for the entry point of cores
+// 1 - 3 (the "spin table")
+#define SPIN_TABLE          0xD8
+
+// How long smp_init() waits for a core to start, in microseconds
+#define START_TIMEOUT       100000
+
+// Work handed to one core, and the timing of its last band
+struct CoreSlot
+{
+    void (*band)(void *arg, int y, int h);
+    void *arg;
+    int y;
+    int h;
+    volatile unsigned int sequence;    // Written by core 0
+    volatile unsigned int done;        // Written by the core
+    volatile unsigned int online;      // Written by the core
+    unsigned long start;
+    unsigned long end;
+} __attribute__((aligned(SMP_CACHE_LINE)));
+
+static struct CoreSlot slots[SMP_CORES];
+static unsigned int coresOnline = 1;
+
+// Timing of the last call to smp_bands()
+static unsigned long lastStart, lastEnd;
+static unsigned int lastRows;
+
+// Set by core 0 once the .bss section is cleared, and start.s holds cores
+// 1 - 3 back until it is set. A zero variable would go in .bss and read
+// whatever RAM held before the clear, so it is put in .data, which is
+// loaded with the image and reads 0 from the start.
+volatile unsigned int smp_release __attribute__((section(".data"))) = 0;
+
+extern char _start[];
+
+
+
+static void send_event()
+{
+    asm volatile("dsb sy" ::: "memory");
+    asm volatile("sev");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       smp_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function starts cores 1 - 3. Depending on how the
+//                  firmware booted, they are either waiting in start.s
+//                  already, or still polling the spin table, so both are
+//                  covered: the release flag is set, and the spin table
+//                  entries are pointed at _start. The function waits until
+//                  each core reports in.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void smp_init()
+{
+    unsigned int core;
+    unsigned long deadline;
+
+    smp_release = 1;
+
+    for (core = 1; core < SMP_CORES; core++)
+        *(volatile unsigned long *)(SPIN_TABLE + core * 8UL) = (unsigned long)_start;
+
+    send_event();
+
+    for (core = 1; core < SMP_CORES; core++) {
+        deadline = get_timer_counter() + START_TIMEOUT;
+        while (!slots[core].online && get_timer_counter() < deadline)
+            asm volatile("nop");
+
+        if (!slots[core].online)
+            break;
+        coresOnline++;
+    }
+
+    uart_puts("\nCores online: ");
+    uart_putdec(coresOnline);
+    uart_puts("\n");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       smp_cores_online
+//
+//  Arguments:      none
+//
+//  Returns:        The number of cores taking part in drawing
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int smp_cores_online()
+{
+    return coresOnline;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       smp_secondary
+//
+//  Arguments:      core:      The core number (1 - 3)
+//
+//  Returns:        never
+//
+//  Description:    This function is the main loop of cores 1 - 3, called
+//                  from start.s. It sleeps until core 0 posts a new job,
+//                  runs it, and reports back.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void smp_secondary(unsigned int core)
+{
+    struct CoreSlot *slot = &slots[core];
+    unsigned int seen = slot->sequence;
+
+    // Set up this core's own generic timer
+    timebase_init();
+
+    slot->online = 1;
+    send_event();
+
+    while (1) {
+        while (slot->sequence == seen)
+            asm volatile("wfe");
+
+        seen = slot->sequence;
+        asm volatile("dmb sy" ::: "memory");
+
+        trace_begin(TRACE_BAND, slot->y);
+        slot->start = get_timer_counter();
+        slot->band(slot->arg, slot->y, slot->h);
+        slot->end = get_timer_counter();
+        trace_end(TRACE_BAND, slot->y);
+
+        // Make the drawing and the timing visible before saying so
+        asm volatile("dsb sy" ::: "memory");
+        slot->done = seen;
+        send_event();
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       smp_bands
+//
+//  Arguments:      s:         Surface the bands are drawn on
+//                  y, h:      First row and number of rows to split up
+//                  band:      Function that draws rows y to y + h - 1
+//                  arg:       Passed on to band
+//
+//  Returns:        void
+//
+//  Description:    This function splits the rows into one band per core and
+//                  draws them in parallel, returning when all are done. The
+//                  band function must only draw inside its rows, and must
+//                  not change shared state. Band edges are moved to rows
+//                  whose start is the same distance from a cache line as
+//                  row y, so that if the first row starts on a cache line,
+//                  so does every band and no two cores share a line.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void smp_bands(struct Surface *s, int y, int h, void (*band)(void *arg, int y, int h), void *arg)
+{
+    unsigned int cores = coresOnline, core, step, sequence;
+    int start, rows, share;
+
+    // Rows per step so that a step covers whole cache lines
+    step = 1;
+    while (step < SMP_CACHE_LINE && (step * s->pitch) % SMP_CACHE_LINE != 0)
+        step *= 2;
+
+    share = (h / cores + step - 1) / step * step;
+
+    lastStart = get_timer_counter();
+    lastRows = h;
+
+    // Hand out bands 1 - 3, then draw band 0 here
+    start = y + share;
+    for (core = 1; core < cores; core++) {
+        rows = y + h - start;
+        if (rows > share)
+            rows = share;
+        if (rows < 0)
+            rows = 0;
+
+        slots[core].band = band;
+        slots[core].arg = arg;
+        slots[core].y = start;
+        slots[core].h = rows;
+        asm volatile("dmb sy" ::: "memory");
+        slots[core].sequence++;
+
+        start += rows;
+    }
+    send_event();
+
+    slots[0].y = y;
+    slots[0].h = share < h ? share : h;
+    trace_begin(TRACE_BAND, y);
+    slots[0].start = get_timer_counter();
+    band(arg, y, slots[0].h);
+    slots[0].end = get_timer_counter();
+    trace_end(TRACE_BAND, y);
+
+    // Join: wait for every core to report its band done
+    for (core = 1; core < cores; core++) {
+        sequence = slots[core].sequence;
+        while (slots[core].done != sequence)
+            asm volatile("wfe");
+    }
+    asm volatile("dmb sy" ::: "memory");
+
+    lastEnd = get_timer_counter();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       smp_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function prints the time each core spent on its
+//                  band in the last parallel drawing, the time the whole
+//                  drawing took, and the speedup over the sum of the band
+//                  times (which is what a single core would have taken).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void smp_report()
+{
+    unsigned int core, time, total = 0, wall = lastEnd - lastStart;
+
+    uart_puts("\nLast parallel draw: ");
+    uart_putdec(lastRows);
+    uart_puts(" rows on ");
+    uart_putdec(coresOnline);
+    uart_puts(" cores\n");
+
+    for (core = 0; core < coresOnline; core++) {
+        time = slots[core].end - slots[core].start;
+        total += time;
+
+        uart_puts("    core ");
+        uart_putdec(core);
+        uart_puts(": ");
+        uart_putdec_padded(slots[core].h, 5);
+        uart_puts(" rows ");
+        uart_putdec_padded(time, 7);
+        uart_puts(" us\n");
+    }
+
+    uart_puts("    total: ");
+    uart_putdec(wall);
+    uart_puts(" us, speedup x");
+    if (wall != 0) {
+        uart_putdec(total / wall);
+        uart_putc('.');
+        uart_putdec_padded(total * 10 / wall % 10, 1);
+    } else {
+        uart_putc('-');
+    }
+    uart_puts("\n");
+}
@@ -0,0 +1,22 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "surface.h"
+
+// Number of CPU cores on the BCM2837
+#define SMP_CORES           4
+
+// Size of a cache line on the Cortex-A53, in bytes
+#define SMP_CACHE_LINE      64
+
+// Each core gets this much stack below the _start address (see start.s)
+#define SMP_STACK_SIZE      0x10000
+
+// Function prototypes
+void smp_init();
+unsigned int smp_cores_online();
+void smp_bands(struct Surface *s, int y, int h, void (*band)(void *arg, int y, int h), void *arg);
+void smp_report();
+void smp_secondary(unsigned int core);
+
+#endif
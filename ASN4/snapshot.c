@@ -0,0 +1,196 @@
+// The functions in this file send a snapshot of the drawing to the host
+// over the UART. The canvas model is compressed row by row with a scheme
+// that suits mostly-white line art, and the compressed stream is cut into
+// small checksummed frames so that the host can detect damaged data.
+//
+// The compressed stream is a sequence of varints (7 bits per byte, least
+// significant group first). Each row starts with a token:
+//
+//     odd token t     the previous row repeats (t >> 1) more times
+//     token 0         a new row follows, as alternating run lengths
+//                     starting with paper, until the runs cover the row
+//
+// A blank screen compresses to 5 bytes, and a typical drawing to a few
+// kilobytes, which takes a few seconds at 115200 baud (or a fraction of a
+// second with the PL011 at 921600 baud).
+
+#include "uart.h"
+#include "canvas.h"
+#include "crc.h"
+#include "memory.h"
+#include "snapshot.h"
+
+// Frame being filled (in the scratch arena while a snapshot is sent), and
+// statistics about the whole snapshot
+static unsigned char *chunk;
+static unsigned int chunkLength, sequence, compressedLength;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       send_frame
+//
+//  Arguments:      type:      One of the SNAPSHOT_* frame types
+//                  payload:   Frame payload
+//                  length:    Number of payload bytes
+//
+//  Returns:        void
+//
+//  Description:    This function builds one frame with its sync byte,
+//                  header, payload and CRC, and sends it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void send_frame(unsigned int type, unsigned char *payload, unsigned int length)
+{
+    unsigned char frame[SNAPSHOT_CHUNK_SIZE + 10];
+    unsigned int crc, i;
+
+    frame[0] = SNAPSHOT_SYNC;
+    frame[1] = type;
+    frame[2] = sequence & 0xFF;
+    frame[3] = sequence >> 8;
+    frame[4] = length & 0xFF;
+    frame[5] = length >> 8;
+
+    for (i = 0; i < length; i++)
+        frame[6 + i] = payload[i];
+
+    crc = crc32(frame + 1, 5 + length);
+    for (i = 0; i < 4; i++)
+        frame[6 + length + i] = (crc >> (i * 8)) & 0xFF;
+
+    // Send the frame as one block, so that with the PL011 it goes out by
+    // DMA while the next one is being compressed
+    uart_write(frame, length + 10);
+
+    sequence++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_varint
+//
+//  Arguments:      value:     Number to add to the compressed stream
+//
+//  Returns:        void
+//
+//  Description:    This function appends a varint to the current data
+//                  frame, sending the frame whenever it fills up.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_varint(unsigned int value)
+{
+    unsigned char byte;
+
+    do {
+        byte = value & 0x7F;
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+
+        chunk[chunkLength++] = byte;
+        compressedLength++;
+
+        if (chunkLength == SNAPSHOT_CHUNK_SIZE) {
+            send_frame(SNAPSHOT_DATA, chunk, chunkLength);
+            chunkLength = 0;
+        }
+    } while (value);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       rows_equal
+//
+//  Arguments:      a, b:      Row numbers
+//
+//  Returns:        TRUE (non-zero) if the two canvas rows are identical
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int rows_equal(int a, int b)
+{
+    int i;
+
+    for (i = 0; i < CANVAS_ROW_WORDS; i++)
+        if (canvas[a][i] != canvas[b][i])
+            return 0;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snapshot_send
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function compresses the canvas and sends it to the
+//                  host as a header frame, a series of data frames, and an
+//                  end frame. Runs are found with canvas_run_end(), which
+//                  skips whole 64-bit words of paper at a time.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snapshot_send()
+{
+    unsigned char payload[8];
+    int row, repeat, x, end, ink;
+    unsigned long mark;
+
+    mark = arena_mark(&mem_scratch);
+    chunk = arena_alloc(&mem_scratch, SNAPSHOT_CHUNK_SIZE, 0);
+    if (chunk == 0)
+        return;
+
+    sequence = 0;
+    chunkLength = 0;
+    compressedLength = 0;
+
+    payload[0] = CANVAS_WIDTH & 0xFF;
+    payload[1] = CANVAS_WIDTH >> 8;
+    payload[2] = CANVAS_HEIGHT & 0xFF;
+    payload[3] = CANVAS_HEIGHT >> 8;
+    send_frame(SNAPSHOT_HEADER, payload, 4);
+
+    for (row = 0; row < CANVAS_HEIGHT; row = repeat) {
+        // Send the row as alternating runs of paper and ink
+        put_varint(0);
+        for (x = 0, ink = 0; x < CANVAS_WIDTH; x = end, ink ^= 1) {
+            end = canvas_run_end(x, row, ink);
+            put_varint(end - x);
+        }
+
+        // Count the identical rows that follow
+        for (repeat = row + 1; repeat < CANVAS_HEIGHT && rows_equal(repeat, row); repeat++)
+            ;
+        if (repeat > row + 1)
+            put_varint(((repeat - row - 1) << 1) | 0x1);
+    }
+
+    if (chunkLength > 0)
+        send_frame(SNAPSHOT_DATA, chunk, chunkLength);
+
+    payload[0] = compressedLength & 0xFF;
+    payload[1] = (compressedLength >> 8) & 0xFF;
+    payload[2] = (compressedLength >> 16) & 0xFF;
+    payload[3] = compressedLength >> 24;
+    payload[4] = (sequence + 1) & 0xFF;
+    payload[5] = ((sequence + 1) >> 8) & 0xFF;
+    payload[6] = ((sequence + 1) >> 16) & 0xFF;
+    payload[7] = (sequence + 1) >> 24;
+    send_frame(SNAPSHOT_END, payload, 8);
+
+    arena_reset(&mem_scratch, mark);
+}
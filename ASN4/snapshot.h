@@ -0,0 +1,21 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Every frame of a snapshot starts with this byte, followed by the frame
+// type, a 16-bit sequence number, a 16-bit payload length, the payload, and
+// a CRC-32 over everything from the type to the end of the payload. All
+// numbers are little-endian.
+#define SNAPSHOT_SYNC           0xA5
+
+// Frame types
+#define SNAPSHOT_HEADER         1   // u16 width, u16 height
+#define SNAPSHOT_DATA           2   // Next part of the compressed image
+#define SNAPSHOT_END            3   // u32 compressed length, u32 frame count
+
+// Largest payload of a data frame
+#define SNAPSHOT_CHUNK_SIZE     256
+
+// Function prototypes
+void snapshot_send();
+
+#endif
@@ -0,0 +1,980 @@
+#include "snes.h"
+#include "irq.h"
+#include "trace.h"
+
+
+// Data pin of each controller. All controllers share the LATCH (GPIO 9)
+// and CLOCK (GPIO 11) lines, and each one drives its own DATA line. Only
+// the first padCount entries are used.
+static unsigned int padPins[SNES_MAX_PADS] = SNES_DEFAULT_PINS;
+static unsigned int padCount = 1;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_set_pads
+//
+//  Arguments:      pins:     The GPIO data pin of each controller, in player
+//                            order. Pins must be in the range 0 - 31, since
+//                            they are all read through GPLEV0.
+//                  count:    Number of controllers (1 - SNES_MAX_PADS)
+//
+//  Returns:        void
+//
+//  Description:    This function configures the pin map used to read
+//                  several controllers at once. It must be called before
+//                  initializeSNES(). Without it, a single controller on
+//                  GPIO 10 is assumed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_set_pads(const unsigned int *pins, unsigned int count)
+{
+    unsigned int i;
+
+    if (count > SNES_MAX_PADS)
+        count = SNES_MAX_PADS;
+
+    for (i = 0; i < count; i++)
+        padPins[i] = pins[i] & 0x1F;
+
+    padCount = count;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_pad_count
+//
+//  Arguments:      none
+//
+//  Returns:        The number of controllers being read
+//
+//  Description:    This function returns the number of controllers that
+//                  were configured with snes_set_pads().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int snes_pad_count()
+{
+    return padCount;
+}
+
+
+
+// Moved all the initialization needed for the snes to this file
+void initializeSNES()
+{
+    unsigned int i;
+
+    // Set up GPIO pin #9 for output (LATCH output)
+    init_GPIO9_to_output();
+    
+    // Set up GPIO pin #11 for output (CLOCK output)
+    init_GPIO11_to_output();
+    
+    // Set up the DATA input of every controller (GPIO 10 for the first one)
+    for (i = 0; i < padCount; i++)
+        init_GPIO_to_input(padPins[i]);
+    
+    // Clear the LATCH line (GPIO 9) to low
+    clear_GPIO9();
+    
+    // Set CLOCK line (GPIO 11) to high
+    set_GPIO11();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_deinterleave
+//
+//  Arguments:      levels:   The 16 raw GPLEV0 values read on each falling
+//                            clock edge
+//                  data:     Array that receives one 16-bit button word
+//                            per controller
+//
+//  Returns:        void
+//
+//  Description:    This function splits the raw pin levels into per
+//                  controller button words. Since all controllers are
+//                  clocked together, bit i of every controller is found in
+//                  levels[i], at the position of that controller's data pin.
+//                  A low level means pressed, so the levels are inverted.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void snes_deinterleave(const unsigned int *levels, unsigned short *data)
+{
+    unsigned int i, pad, pin, word;
+
+    for (pad = 0; pad < padCount; pad++) {
+        pin = padPins[pad];
+        word = 0;
+
+        for (i = 0; i < 16; i++)
+            word |= ((~levels[i] >> pin) & 0x1) << i;
+
+        data[pad] = word;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_SNES_all
+//
+//  Arguments:      data:     Array that receives one 16-bit button word per
+//                            configured controller (see snes_set_pads())
+//
+//  Returns:        void
+//
+//  Description:    This function samples every configured controller in a
+//                  single latch/clock pass, using the same timing as
+//                  get_SNES(). GPLEV0 is read once per falling edge, which
+//                  captures the DATA line of all controllers at the same
+//                  time, so reading four controllers costs no more bus time
+//                  than reading one.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void get_SNES_all(unsigned short *data)
+{
+    int i;
+    unsigned int levels[16];
+
+    // Set LATCH to high for 12 microseconds to latch the button states
+    set_GPIO9();
+    microsecond_delay(12);
+    clear_GPIO9();
+
+    // Output 16 clock pulses, and capture all DATA lines on each one
+    for (i = 0; i < 16; i++) {
+      microsecond_delay(6);
+      clear_GPIO11();
+      levels[i] = *GPLEV0;
+      microsecond_delay(6);
+      set_GPIO11();
+    }
+
+    snes_deinterleave(levels, data);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_SNES
+//
+//  Arguments:      none
+//
+//  Returns:        A short integer with the button presses encoded with 16
+//                  bits. 1 means pressed, and 0 means unpressed. Bit 0 is
+//                  button B, Bit 1 is button Y, etc. up to Bit 11, which is
+//                  button R. Bits 12-15 are always 0.
+//
+//  Description:    This function samples the button presses on the SNES
+//                  controller, and returns an encoding of these in a 16-bit
+//                  integer. We assume that the CLOCK output is already high,
+//                  and set the LATCH output to high for 12 microseconds. This
+//                  causes the controller to latch the values of the button
+//                  presses into its internal register. We then clock this data
+//                  to the CPU over the DATA line in a serial fashion, by
+//                  pulsing the CLOCK line low 16 times. We read the data on
+//                  the falling edge of the clock. The rising edge of the clock
+//                  causes the controller to output the next bit of serial data
+//                  to be place on the DATA line. The clock cycle is 12
+//                  microseconds long, so the clock is low for 6 microseconds,
+//                  and then high for 6 microseconds. When several controllers
+//                  are configured, they are all read in the same pass and the
+//                  first one is returned.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned short get_SNES()
+{
+    unsigned short data[SNES_MAX_PADS];
+
+    trace_begin(TRACE_SNES_POLL, 0);
+    get_SNES_all(data);
+    trace_end(TRACE_SNES_POLL, data[0]);
+
+    // Return the encoded data
+    return data[0];
+}
+
+
+
+// States of the background sampler. Each timer compare interrupt performs
+// one step of the latch/clock protocol and schedules the next step, so the
+// CPU is free between edges instead of spinning in microsecond_delay().
+#define SAMPLER_IDLE        0   // Waiting for the next sample period
+#define SAMPLER_LATCH       1   // LATCH is high for 12 microseconds
+#define SAMPLER_CLOCK_LOW   2   // CLOCK is low, data bits have been read
+#define SAMPLER_CLOCK_HIGH  3   // CLOCK is high, next bit is being shifted out
+
+// Timing of the SNES protocol in microseconds
+#define SNES_LATCH_TIME     12
+#define SNES_HALF_CYCLE     6
+
+// Smallest lead time used when (re)arming the compare register, so that
+// the match is never set in the past
+#define SNES_MIN_LEAD       2
+
+// Sampler state, only touched from the IRQ handler once started
+static unsigned int samplerPhase;
+static unsigned int samplerBit;
+static unsigned int samplerPeriod;
+static unsigned int samplerNext;
+static unsigned int samplerLevels[16];
+
+// Snapshots published by the sampler, one per controller. The sequence
+// counter is odd while they are being written, which lets readers detect
+// a torn copy.
+static volatile unsigned int snapshotSequence;
+static volatile struct SNESState snapshot[SNES_MAX_PADS];
+
+// Single-producer/single-consumer event queue. The head is only written by
+// the sampler and the tail only by the reader, so no locking is needed.
+static volatile struct SNESEvent eventQueue[SNES_EVENT_QUEUE_SIZE];
+static volatile unsigned int eventHead, eventTail, eventsDropped;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_schedule
+//
+//  Arguments:      target:     System timer value (low 32 bits) at which the
+//                              next sampler step should run
+//
+//  Returns:        void
+//
+//  Description:    This function arms System Timer channel 1. If the target
+//                  has already passed by the time the compare register is
+//                  written, the match would not happen until the counter
+//                  wraps (about 71 minutes later), so in that case the
+//                  compare is moved just ahead of the current count.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void snes_schedule(unsigned int target)
+{
+    *SYSTEM_TIMER_C1 = target;
+
+    if ((int)(target - *SYSTEM_TIMER_CLO) <= 0)
+        *SYSTEM_TIMER_C1 = *SYSTEM_TIMER_CLO + SNES_MIN_LEAD;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_publish
+//
+//  Arguments:      data:        One 16-bit button word per controller
+//                  timestamp:   get_timer_counter() time when sampling
+//                               finished
+//
+//  Returns:        void
+//
+//  Description:    This function computes the press and release edges
+//                  against the previous sample, pushes one event per edge
+//                  into the event queue, and then publishes new snapshots
+//                  for all controllers. It runs in interrupt context.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void snes_publish(const unsigned short *data, unsigned long timestamp)
+{
+    unsigned short previous[SNES_MAX_PADS], changed;
+    unsigned int pad, i, head, slot;
+
+    for (pad = 0; pad < padCount; pad++) {
+        previous[pad] = snapshot[pad].buttons;
+        changed = data[pad] ^ previous[pad];
+
+        // Queue an event for every button that changed state
+        for (i = 0; changed != 0; i++, changed >>= 1) {
+            if ((changed & 0x1) == 0)
+                continue;
+
+            head = eventHead;
+            if (head - eventTail == SNES_EVENT_QUEUE_SIZE) {
+                eventsDropped++;
+                continue;
+            }
+
+            slot = head & (SNES_EVENT_QUEUE_SIZE - 1);
+            eventQueue[slot].pad = pad;
+            eventQueue[slot].button = i;
+            eventQueue[slot].pressed = (data[pad] >> i) & 0x1;
+            eventQueue[slot].timestamp = timestamp;
+
+            // Make the event visible before moving the head past it
+            asm volatile("dmb ish" ::: "memory");
+            eventHead = head + 1;
+        }
+    }
+
+    // Publish the snapshots between two increments of the sequence counter
+    snapshotSequence++;
+    asm volatile("dmb ish" ::: "memory");
+
+    for (pad = 0; pad < padCount; pad++) {
+        snapshot[pad].buttons = data[pad];
+        snapshot[pad].pressed = data[pad] & ~previous[pad];
+        snapshot[pad].released = previous[pad] & ~data[pad];
+        snapshot[pad].timestamp = timestamp;
+        snapshot[pad].sequence++;
+    }
+
+    asm volatile("dmb ish" ::: "memory");
+    snapshotSequence++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_sampler_start
+//
+//  Arguments:      rate:     Number of controller samples per second
+//
+//  Returns:        void
+//
+//  Description:    This function starts sampling the SNES controllers in the
+//                  background. It uses compare channel 1 of the System Timer
+//                  to generate an interrupt for every edge of the latch/clock
+//                  protocol, so IRQs must be enabled by the caller (see
+//                  enableIRQ() in sysreg.h). The controllers must already be
+//                  initialized with initializeSNES().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_sampler_start(unsigned int rate)
+{
+    // A full sample takes 12 + 16 * 12 = 204 microseconds, which limits
+    // the sample rate to a little under 5 kHz
+    samplerPeriod = 1000000 / rate;
+    if (samplerPeriod < SNES_LATCH_TIME + 32 * SNES_HALF_CYCLE)
+        samplerPeriod = SNES_LATCH_TIME + 32 * SNES_HALF_CYCLE;
+
+    samplerPhase = SAMPLER_IDLE;
+    samplerNext = *SYSTEM_TIMER_CLO + samplerPeriod;
+
+    // Clear any stale match, then arm channel 1 and unmask its interrupt
+    *SYSTEM_TIMER_CS = SYSTEM_TIMER_M1;
+    snes_schedule(samplerNext);
+    *IRQ_ENABLE_IRQS_1 = SYSTEM_TIMER_IRQ_1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_sampler_stop
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function stops the background sampler and leaves the
+//                  LATCH and CLOCK lines in their idle levels, so get_SNES()
+//                  can be used again.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_sampler_stop()
+{
+    *IRQ_DISABLE_IRQS_1 = SYSTEM_TIMER_IRQ_1;
+    *SYSTEM_TIMER_CS = SYSTEM_TIMER_M1;
+
+    samplerPhase = SAMPLER_IDLE;
+    clear_GPIO9();
+    set_GPIO11();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_sampler_tick
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function is called by the IRQ handler whenever
+//                  System Timer channel 1 matches. It performs one step of
+//                  the same protocol as get_SNES_all(): raise LATCH for 12
+//                  microseconds, then pulse CLOCK low 16 times with a 12
+//                  microsecond cycle, capturing GPLEV0 on each falling edge.
+//                  When all 16 bits have been read the levels are split
+//                  into per controller words and published, and the next
+//                  sample is scheduled one period after the previous one.
+//                  If we fall behind by more than a period, missed samples
+//                  are skipped rather than run back to back.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_sampler_tick()
+{
+    unsigned int now;
+    unsigned short data[SNES_MAX_PADS];
+
+    // Acknowledge the match on channel 1
+    *SYSTEM_TIMER_CS = SYSTEM_TIMER_M1;
+    now = *SYSTEM_TIMER_CLO;
+
+    switch (samplerPhase) {
+        case SAMPLER_IDLE :
+        // Latch the button states into the controllers' shift registers
+        set_GPIO9();
+        samplerPhase = SAMPLER_LATCH;
+        snes_schedule(now + SNES_LATCH_TIME);
+        break;
+
+        case SAMPLER_LATCH :
+        clear_GPIO9();
+        samplerBit = 0;
+        samplerPhase = SAMPLER_CLOCK_LOW;
+        snes_schedule(now + SNES_HALF_CYCLE);
+        break;
+
+        case SAMPLER_CLOCK_LOW :
+        // Falling edge, then capture the DATA lines of all controllers
+        clear_GPIO11();
+        samplerLevels[samplerBit] = *GPLEV0;
+        samplerPhase = SAMPLER_CLOCK_HIGH;
+        snes_schedule(now + SNES_HALF_CYCLE);
+        break;
+
+        case SAMPLER_CLOCK_HIGH :
+        // Rising edge shifts out the next bit
+        set_GPIO11();
+
+        if (++samplerBit < 16) {
+            samplerPhase = SAMPLER_CLOCK_LOW;
+            snes_schedule(now + SNES_HALF_CYCLE);
+            break;
+        }
+
+        snes_deinterleave(samplerLevels, data);
+        snes_publish(data, get_timer_counter());
+        trace_instant(TRACE_SNES_SAMPLE, data[0]);
+
+        // Schedule the next sample on the fixed period grid
+        samplerNext += samplerPeriod;
+        while ((int)(samplerNext - now) <= 0)
+            samplerNext += samplerPeriod;
+
+        samplerPhase = SAMPLER_IDLE;
+        snes_schedule(samplerNext);
+        break;
+
+        default :
+        break;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_get_pad_state
+//
+//  Arguments:      pad:       Controller number (0 for player 1)
+//                  state:     Where to copy the latest controller snapshot
+//
+//  Returns:        void
+//
+//  Description:    This function copies the most recent snapshot of one
+//                  controller published by the background sampler. It never
+//                  waits on controller I/O; if the sampler interrupts the
+//                  copy, the copy is simply retried.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_get_pad_state(unsigned int pad, struct SNESState *state)
+{
+    unsigned int sequence;
+
+    if (pad >= SNES_MAX_PADS)
+        pad = 0;
+
+    do {
+        // Wait out a snapshot that is currently being written
+        while ((sequence = snapshotSequence) & 0x1)
+            ;
+        asm volatile("dmb ish" ::: "memory");
+
+        state->buttons = snapshot[pad].buttons;
+        state->pressed = snapshot[pad].pressed;
+        state->released = snapshot[pad].released;
+        state->timestamp = snapshot[pad].timestamp;
+        state->sequence = snapshot[pad].sequence;
+
+        asm volatile("dmb ish" ::: "memory");
+    } while (sequence != snapshotSequence);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_get_state
+//
+//  Arguments:      state:     Where to copy the latest controller snapshot
+//
+//  Returns:        void
+//
+//  Description:    This function copies the most recent snapshot of the
+//                  first controller (see snes_get_pad_state()).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void snes_get_state(struct SNESState *state)
+{
+    snes_get_pad_state(0, state);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_get_event
+//
+//  Arguments:      event:     Where to copy the oldest queued event
+//
+//  Returns:        TRUE (non-zero) if an event was removed from the queue,
+//                  FALSE (zero) if the queue was empty.
+//
+//  Description:    This function removes the oldest button press or release
+//                  event, from any controller, from the queue filled by the
+//                  background sampler.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int snes_get_event(struct SNESEvent *event)
+{
+    unsigned int tail = eventTail, slot;
+
+    if (tail == eventHead)
+        return 0;
+
+    asm volatile("dmb ish" ::: "memory");
+
+    slot = tail & (SNES_EVENT_QUEUE_SIZE - 1);
+    event->pad = eventQueue[slot].pad;
+    event->button = eventQueue[slot].button;
+    event->pressed = eventQueue[slot].pressed;
+    event->timestamp = eventQueue[slot].timestamp;
+
+    // Release the slot only after it has been copied
+    asm volatile("dmb ish" ::: "memory");
+    eventTail = tail + 1;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       snes_events_dropped
+//
+//  Arguments:      none
+//
+//  Returns:        The number of events lost because the queue was full
+//
+//  Description:    This function reports how many button events could not
+//                  be queued since the sampler was started.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int snes_events_dropped()
+{
+    return eventsDropped;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO9_to_output
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets GPIO pin 9 to an output pin without
+//                  any pull-up or pull-down resistors.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void init_GPIO9_to_output()
+{
+    register unsigned int r;
+    
+    
+    // Get the current contents of the GPIO Function Select Register 0
+    r = *GPFSEL0;
+
+    // Clear bits 27 - 29. This is the field FSEL9, which maps to GPIO pin 9.
+    // We clear the bits by ANDing with a 000 bit pattern in the field.
+    r &= ~(0x7 << 27);
+
+    // Set the field FSEL9 to 001, which sets pin 9 to an output pin.
+    // We do so by ORing the bit pattern 001 into the field.
+    r |= (0x1 << 27);
+
+    // Write the modified bit pattern back to the
+    // GPIO Function Select Register 0
+    *GPFSEL0 = r;
+
+    // Disable the pull-up/pull-down control line for GPIO pin 9. We follow the
+    // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. The
+    // internal pull-up and pull-down resistor isn't needed for an output pin.
+
+    // Disable pull-up/pull-down by setting bits 0:1
+    // to 00 in the GPIO Pull-Up/Down Register 
+    *GPPUD = 0x0;
+
+    // Wait 150 cycles to provide the required set-up time 
+    // for the control signal
+    r = 150;
+    while (r--) {
+	asm volatile("nop");
+    }
+
+    // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 9 to
+    // clock in the control signal for GPIO pin 9. Note that all other pins
+    // will retain their previous state.
+    *GPPUDCLK0 = (0x1 << 9);
+
+    // Wait 150 cycles to provide the required hold time
+    // for the control signal
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
+    // in order to remove the clock
+    *GPPUDCLK0 = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       set_GPIO9
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets the GPIO output pin 9
+//                  to a 1 (high) level.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void set_GPIO9()
+{
+    register unsigned int r;
+	  
+    // Put a 1 into the SET9 field of the GPIO Pin Output Set Register 0
+    r = (0x1 << 9);
+    *GPSET0 = r;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       clear_GPIO9
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function clears the GPIO output pin 9
+//                  to a 0 (low) level.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void clear_GPIO9()
+{
+    register unsigned int r;
+	  
+    // Put a 1 into the CLR9 field of the GPIO Pin Output Clear Register 0
+    r = (0x1 << 9);
+    *GPCLR0 = r;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO11_to_output
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets GPIO pin 11 to an output pin without
+//                  any pull-up or pull-down resistors.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void init_GPIO11_to_output()
+{
+    register unsigned int r;
+    
+    
+    // Get the current contents of the GPIO Function Select Register 1
+    r = *GPFSEL1;
+
+    // Clear bits 3 - 5. This is the field FSEL11, which maps to GPIO pin 11.
+    // We clear the bits by ANDing with a 000 bit pattern in the field.
+    r &= ~(0x7 << 3);
+
+    // Set the field FSEL11 to 001, which sets pin 9 to an output pin.
+    // We do so by ORing the bit pattern 001 into the field.
+    r |= (0x1 << 3);
+
+    // Write the modified bit pattern back to the
+    // GPIO Function Select Register 1
+    *GPFSEL1 = r;
+
+    // Disable the pull-up/pull-down control line for GPIO pin 11. We follow the
+    // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. The
+    // internal pull-up and pull-down resistor isn't needed for an output pin.
+
+    // Disable pull-up/pull-down by setting bits 0:1
+    // to 00 in the GPIO Pull-Up/Down Register 
+    *GPPUD = 0x0;
+
+    // Wait 150 cycles to provide the required set-up time 
+    // for the control signal
+    r = 150;
+    while (r--) {
+	asm volatile("nop");
+    }
+
+    // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 11 to
+    // clock in the control signal for GPIO pin 11. Note that all other pins
+    // will retain their previous state.
+    *GPPUDCLK0 = (0x1 << 11);
+
+    // Wait 150 cycles to provide the required hold time
+    // for the control signal
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
+    // in order to remove the clock
+    *GPPUDCLK0 = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       set_GPIO11
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets the GPIO output pin 11
+//                  to a 1 (high) level.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void set_GPIO11()
+{
+    register unsigned int r;
+	  
+    // Put a 1 into the SET11 field of the GPIO Pin Output Set Register 0
+    r = (0x1 << 11);
+    *GPSET0 = r;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       clear_GPIO11
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function clears the GPIO output pin 11
+//                  to a 0 (low) level.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void clear_GPIO11()
+{
+    register unsigned int r;
+	  
+    // Put a 1 into the CLR11 field of the GPIO Pin Output Clear Register 0
+    r = (0x1 << 11);
+    *GPCLR0 = r;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO10_to_input
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets GPIO pin 10 to an input pin without
+//                  any internal pull-up or pull-down resistors. Note that
+//                  a pull-down (or pull-up) resistor must be used externally
+//                  on the bread board circuit connected to the pin. Be sure
+//                  that the pin high level is 3.3V (definitely NOT 5V).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void init_GPIO10_to_input()
+{
+    register unsigned int r;
+    
+    
+    // Get the current contents of the GPIO Function Select Register 1
+    r = *GPFSEL1;
+
+    // Clear bits 0 - 2. This is the field FSEL10, which maps to GPIO pin 10.
+    // We clear the bits by ANDing with a 000 bit pattern in the field. This
+    // sets the pin to be an input pin.
+    r &= ~(0x7 << 0);
+
+    // Write the modified bit pattern back to the
+    // GPIO Function Select Register 1
+    *GPFSEL1 = r;
+
+    // Disable the pull-up/pull-down control line for GPIO pin 10. We follow the
+    // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. We
+    // will pull down the pin using an external resistor connected to ground.
+
+    // Disable internal pull-up/pull-down by setting bits 0:1
+    // to 00 in the GPIO Pull-Up/Down Register 
+    *GPPUD = 0x0;
+
+    // Wait 150 cycles to provide the required set-up time 
+    // for the control signal
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 10 to
+    // clock in the control signal for GPIO pin 10. Note that all other pins
+    // will retain their previous state.
+    *GPPUDCLK0 = (0x1 << 10);
+
+    // Wait 150 cycles to provide the required hold time
+    // for the control signal
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
+    // in order to remove the clock
+    *GPPUDCLK0 = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_GPIO10
+//
+//  Arguments:      none
+//
+//  Returns:        1 if the pin level is high, and 0 if the pin level is low.
+//
+//  Description:    This function gets the current value of pin 10.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int get_GPIO10()
+{
+    register unsigned int r;
+	  
+	  
+    // Get the current contents of the GPIO Pin Level Register 0
+    r = *GPLEV0;
+	  
+    // Isolate pin 10, and return its value (a 0 if low, or a 1 if high)
+    return ((r >> 10) & 0x1);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO_to_input
+//
+//  Arguments:      pin:     GPIO pin number (0 - 31)
+//
+//  Returns:        void
+//
+//  Description:    This function sets any GPIO pin in bank 0 to an input pin
+//                  without internal pull-up or pull-down resistors. It does
+//                  the same thing as init_GPIO10_to_input(), but works out
+//                  the function select register and field from the pin
+//                  number, so it can be used for the DATA line of any
+//                  controller.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void init_GPIO_to_input(unsigned int pin)
+{
+    register unsigned int r;
+    volatile unsigned int *fsel;
+    unsigned int shift;
+
+
+    // Each function select register holds ten 3-bit fields
+    fsel = GPFSEL0 + (pin / 10);
+    shift = (pin % 10) * 3;
+
+    // Clear the FSELn field, which makes the pin an input pin
+    r = *fsel;
+    r &= ~(0x7 << shift);
+    *fsel = r;
+
+    // Disable the internal pull-up/pull-down for the pin, following the
+    // same procedure as init_GPIO10_to_input()
+    *GPPUD = 0x0;
+
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    *GPPUDCLK0 = (0x1 << pin);
+
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+
+    *GPPUDCLK0 = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef SNES_H
+#define SNES_H
+
+#include "gpio.h"
+#include "systimer.h"
+
+// Maximum number of controllers that can be read in one pass
+#define SNES_MAX_PADS           4
+
+// Default DATA pins of players 1 - 4. Player 1 uses GPIO 10 as before.
+#define SNES_DEFAULT_PINS       { 10, 5, 6, 13 }
+
+// Default rate (in Hz) at which the background sampler reads the controller
+#define SNES_SAMPLE_RATE        1000
+
+// Number of entries in the button event queue (must be a power of 2)
+#define SNES_EVENT_QUEUE_SIZE   64
+
+// A snapshot of the controller published by the background sampler. The
+// button bits use the same encoding as get_SNES(). The pressed and released
+// fields hold the edges detected by the most recent sample only, so a reader
+// that needs every edge should drain the event queue instead.
+struct SNESState
+{
+    unsigned short buttons;
+    unsigned short pressed;
+    unsigned short released;
+    unsigned long timestamp;    // get_timer_counter() time (generic timer
+                                // counter, in us) when the sample ended
+    unsigned int sequence;      // Number of samples taken so far
+};
+
+// A single button press or release
+struct SNESEvent
+{
+    unsigned short pad;         // Controller number (0 for player 1)
+    unsigned short button;      // Button number (bit position) 0 - 15
+    unsigned short pressed;     // 1 for a press, 0 for a release
+    unsigned long timestamp;    // get_timer_counter() time (generic timer
+                                // counter, in us) when it was sampled
+};
+
+// Function prototypes
+void snes_set_pads(const unsigned int *pins, unsigned int count);
+unsigned int snes_pad_count();
+void initializeSNES();
+
+unsigned short get_SNES();
+void get_SNES_all(unsigned short *data);
+
+void snes_sampler_start(unsigned int rate);
+void snes_sampler_stop();
+void snes_sampler_tick();
+void snes_get_state(struct SNESState *state);
+void snes_get_pad_state(unsigned int pad, struct SNESState *state);
+int snes_get_event(struct SNESEvent *event);
+unsigned int snes_events_dropped();
+
+void init_GPIO9_to_output();
+void set_GPIO9();
+void clear_GPIO9();
+void init_GPIO11_to_output();
+void set_GPIO11();
+void clear_GPIO11();
+void init_GPIO10_to_input();
+unsigned int get_GPIO10();
+void init_GPIO_to_input(unsigned int pin);
+
+#endif
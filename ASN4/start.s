@@ -0,0 +1,282 @@
+// This routine is used to establish an environment in which
+// a C program can run. All four CPU cores run it. Core 0
+// clears the .bss section and branches to main(); cores 1 - 3
+// wait until main() releases them (see smp_init() in smp.c)
+// and then branch to smp_secondary(), which waits for work.
+//
+// Each core gets SMP_STACK_SIZE (64 KB) of stack below the
+// _start address: core 0 gets the 64 KB just below _start,
+// core 1 the 64 KB below that, and so on. The top 8 KB of
+// each area is the EL1 stack, which is used while handling
+// exceptions, and the rest is the stack the C code runs on.
+// The stacks grow backwards (toward 0).
+//
+// Core 0 stamps the reset, the change to EL1 and the end of the
+// .bss clear with the generic timer's counter, and hands them to
+// boot_start() (in boot.c), which starts the boot timeline.
+//
+// The main() routine should never return to this code (it
+// should be in an infinite loop), but if it does, we then put
+// the core into an infinite loop.
+//
+// This version of the start routine also changes the exception
+// level from EL2 to EL1 (in the aarch64 execution state).
+// The exception vector table is also set up, and vector
+// stubs are provided. Only the IRQ handler is implemented,
+// and is called from the IRQ stub.
+	
+	
+	// Put the machine code for this routine into the .text.boot section	
+	.section ".text.boot"
+
+	// The _start symbol needs to be visible to the linker
+	// since this is where execution starts for bare metal code
+	.global _start
+_start:
+	// Stamp the reset for the boot timeline. x20 keeps it until
+	// boot_start() is called.
+	mrs	x20, cntpct_el0
+
+	// Copy the contents of the multiprocessor affinity register
+	// into the x19 register. The rightmost 2 bits gives us the
+	// CPU Core number that this code is running on. x19 keeps
+	// the core number until the C code is called.
+	mrs     x19, mpidr_el1	// Read the MP affinity system register
+	and	x19, x19, 0x3	// Keep the rightmost 2 bits
+	
+	// Work out the top of this core's stack area, which is
+	// _start - core * 64 KB. We set the EL1 SP here, and will set
+	// the EL0 SP (8 KB lower) below, once we have changed to EL1.
+	adrp	x1, _start	// Put the _start address into x1
+	add	x1, x1, :lo12:_start
+	lsl	x2, x19, 16	// x2 = core * 0x10000
+	sub	x1, x1, x2
+	msr	sp_el1, x1	// Copy the address into the EL1 SP register
+	sub	x1, x1, 0x2000	// Leave 8 KB for exceptions
+
+	// Enable AArch64 in EL1 by setting bits RW and SWIC to 1 in the
+	// Hypervisor Configuration Register (see p. D10-2492 and D10-2503
+	// in the ARM Architecture Reference Manual). Since all other bits
+	// are 0, most instructions are not trapped, and the Physical SError,
+	// IRQ, and FIQ routings are set so that these exceptions are not
+	// taken to EL2, but are handled at EL1.
+	mov	x0, (1 << 31)		// Enable AArch64
+	orr	x0, x0, (1 << 1)	// SWIO is hardwired on the Pi3
+	msr	hcr_el2, x0
+
+	// Let EL1 use the floating-point and NEON registers, which
+	// the blend kernel in blend.s needs: stop EL2 trapping them
+	// (CPTR_EL2.TFP = 0, with the RES1 bits set), and set
+	// CPACR_EL1.FPEN to 11 so that EL1 and EL0 do not trap them.
+	mov	x0, 0x33FF
+	msr	cptr_el2, x0
+	mov	x0, (3 << 20)
+	msr	cpacr_el1, x0
+
+	// Let EL1 read the physical counter and use the physical
+	// timer (bits EL1PCTEN and EL1PCEN of CNTHCTL_EL2), and make
+	// the virtual counter equal to the physical one
+	mrs	x0, cnthctl_el2
+	orr	x0, x0, 0x3
+	msr	cnthctl_el2, x0
+	msr	cntvoff_el2, xzr
+
+	// Set the Vector Base Address Register (EL1) to the address
+	// of the vectors defined below
+	adrp	x2, _vectors
+	add	x2, x2, :lo12:_vectors
+	msr     vbar_el1, x2
+    
+	// Change execution level to EL1:
+	//
+	// Set the Saved Program Status Register so that when entering
+	// EL1, the DAIF bits are set to 1111 (exceptions are masked) and
+	// the M[3:2] bits are set to 01 (EL1) and the M[0] bit is set
+	// to 0 (SP is always SP0) (see p. C5-386-387 in the ARM
+	// Architecture Reference Manual).
+	mov	x2, 0x3C4
+	msr	spsr_el2, x2
+
+	// Set the Exception Link Register EL2 to the address of
+	// the instruction labelled AtEL1 (a few lines down). We
+	// will jump to this instruction when executing the
+	// exception return instruction.
+	adr	x2, AtEL1
+	msr	elr_el2, x2
+
+	// Executing a return from exception forces the processor to
+	// change to EL1. We then jump to the instruction at the
+	// label below.
+	eret
+
+	
+	// Set the current SP to the address worked out above.
+	// This will be sp_el0.
+AtEL1:	mov	sp, x1
+
+	// Only core 0 sets up the C environment
+	cbz	x19, core_zero
+
+	// If here, the CPU Core number is not 0. Wait (sleeping until
+	// an event) for core 0 to set smp_release, which it does once
+	// the .bss section has been cleared. The flag is kept in .data,
+	// so it already reads 0 here.
+	adrp	x2, smp_release
+	add	x2, x2, :lo12:smp_release
+release:
+	ldr	w3, [x2]
+	cbnz	w3, released
+	wfe
+	b	release
+
+	// Run the secondary core loop in C, passing the core number
+released:
+	mov	x0, x19
+	bl	smp_secondary
+
+	// We should never arrive here, but if we do
+	// we loop forever
+loop:  	wfe			// Wait for event
+	b	loop		// Infinite loop
+
+  	// If here, the CPU Core is 0, and we continue with the rest of the setup.
+core_zero:
+	// Stamp the change to EL1 (x21)
+	mrs	x21, cntpct_el0
+	
+	// Clear the .bss section using a loop. The __bss_start and
+	// __bss_end symbols are provided by the linker, and are the
+	// addresses in RAM where the .bss starts and ends. Both are
+	// aligned to 64 bytes (see link.ld), so each pass writes 64
+	// bytes of zeroes with four paired stores: an eighth of the
+	// passes that storing one doubleword at a time takes. The
+	// lazily zeroed buffers in .lazy are left alone.
+	//
+	// DC ZVA would clear a whole cache line per instruction, but
+	// the MMU is off, so all data accesses are to Device memory,
+	// where DC ZVA raises an alignment fault. Paired stores are
+	// the widest stores that are safe here.
+	adrp	x1, __bss_start		// Put address of .bss into x1
+	add	x1, x1, :lo12:__bss_start
+	adrp	x2, __bss_end		// Put the end of .bss into x2
+	add	x2, x2, :lo12:__bss_end
+	b	test
+
+top:	stp	xzr, xzr, [x1]		// Write 64 bytes of zeroes to RAM
+	stp	xzr, xzr, [x1, 16]
+	stp	xzr, xzr, [x1, 32]
+	stp	xzr, xzr, [x1, 48]
+	add	x1, x1, 64		// x1 += 64
+test:	cmp	x1, x2			// Keep looping while x1 < x2
+	b.lo	top
+
+	// Stamp the end of the clear (x22), once the stores are done,
+	// and start the boot timeline
+	dsb	sy
+	mrs	x22, cntpct_el0
+	mov	x0, x20
+	mov	x1, x21
+	mov	x2, x22
+	bl	boot_start
+
+	// Branch to the main() routine, which should never return
+  	bl      main
+
+	// We should never arrive here, but if we do
+	// we branch to the infinite loop above
+	b       loop
+
+
+
+	// Exception handler stubs: used by the vectors below.
+
+	// A stub that does nothing	
+_synch_handler:	
+	eret
+
+
+_IRQ_handler:
+	// Save state of all general purpose registers.
+	// We do this so that any C code that we call
+	// from here can use any of the general purpose
+	// registers.
+	stp	x0, x1, [sp, -16]!
+	stp	x2, x3, [sp, -16]!
+	stp	x4, x5, [sp, -16]!
+	stp	x6, x7, [sp, -16]!
+	stp	x8, x9, [sp, -16]!
+	stp	x10, x11, [sp, -16]!
+	stp	x12, x13, [sp, -16]!
+	stp	x14, x15, [sp, -16]!
+	stp	x16, x17, [sp, -16]!
+	stp	x18, x19, [sp, -16]!
+	stp	x20, x21, [sp, -16]!
+	stp	x22, x23, [sp, -16]!
+	stp	x24, x25, [sp, -16]!
+	stp	x26, x27, [sp, -16]!
+	stp	x28, x29, [sp, -16]!
+	str	x30, [sp, -16]!
+
+	// Call the IRQ handler written in C, passing it the
+	// address of the saved registers (x30 is at the bottom)
+	mov	x0, sp
+	bl	IRQ_handler
+
+	// Restore state of all general purpose registers
+	ldr	x30, [sp], 16
+	ldp	x28, x29, [sp], 16
+	ldp	x26, x27, [sp], 16
+	ldp	x24, x25, [sp], 16
+	ldp	x22, x23, [sp], 16
+	ldp	x20, x21, [sp], 16
+	ldp	x18, x19, [sp], 16
+	ldp	x16, x17, [sp], 16
+	ldp	x14, x15, [sp], 16
+	ldp	x12, x13, [sp], 16
+	ldp	x10, x11, [sp], 16
+	ldp	x8, x9, [sp], 16
+	ldp	x6, x7, [sp], 16
+	ldp	x4, x5, [sp], 16
+	ldp	x2, x3, [sp], 16
+	ldp	x0, x1, [sp], 16
+
+	// Return from exception
+	eret
+	
+
+	// A stub that does nothing
+_FIQ_handler:	
+	eret
+
+	// A stub that does nothing
+_SError_handler:	
+	eret
+
+
+
+	
+	// Exception Vector Table:
+	//
+	// The start of the table must be aligned to an address
+	// evenly divisible by 2048 (i.e. it must end with 11 zeroes).
+	// Furthermore, each entry must also be aligned to an
+	// address evenly divisible by 128 (i.e. must end with 7 zeroes),
+	// and entries must follow each other consecutively in memory.
+	// Each vector can be as long as 32 instructions.
+	.align 11
+_vectors:
+	// Synchronous
+	.align  7
+	b	_synch_handler	// call handler stub
+	
+	// IRQ
+	.align  7
+	b	_IRQ_handler	// call handler	stub
+
+	// FIQ
+	.align  7
+	b	_FIQ_handler	// call handler stub
+	
+	// SError
+	.align  7
+	b	_SError_handler	// call handler stub
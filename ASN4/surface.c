@@ -0,0 +1,294 @@
+// The functions in this file implement drawing into a Surface. There is
+// one put and one fill routine per pixel format, generated from the same
+// macro so that the pixel size is a compile-time constant in each of them.
+// Fills write whole 64-bit words in the middle of each row, which is what
+// makes the smaller formats cheaper to erase.
+
+#include "framebuffer.h"
+#include "surface.h"
+
+// The 8-bit palette. Indices 0 - 15 hold the colors from framebuffer.h,
+// and surface_map_color() picks the nearest one for other colors.
+static unsigned int palette[SURFACE_PALETTE_SIZE] = {
+    BLACK, WHITE, RED, LIME, BLUE, AQUA, FUCHSIA, YELLOW,
+    GRAY, MAROON, OLIVE, GREEN, TEAL, NAVY, PURPLE, SILVER
+};
+
+// Last color mapped by surface_map_color(), to avoid repeated searches. The
+// format and color (low 32 bits) and the pixel (high 32 bits) are kept in a
+// single word, so that cores drawing at the same time always see a
+// matching pair.
+static unsigned long lastMapping = (unsigned long)SURFACE_XRGB8888 << 24;
+
+
+
+// Generate the put and fill routines for a pixel format. The fill pattern
+// is the pixel replicated across a 64-bit word; every format has a pixel
+// size that divides 8 bytes, and a row always starts on a pixel boundary,
+// so whole pixels are written until the pointer is word aligned.
+#define DEFINE_SURFACE_OPS(bits, type)                                        \
+                                                                              \
+static void put_##bits(struct Surface *s, int x, int y, unsigned int pixel)  \
+{                                                                             \
+    type *row = (type *)((unsigned char *)s->base + y * s->pitch);           \
+                                                                              \
+    row[x] = (type)pixel;                                                     \
+}                                                                             \
+                                                                              \
+static void fill_##bits(struct Surface *s, int x, int y, int w, int h,       \
+                        unsigned int pixel)                                   \
+{                                                                             \
+    unsigned long pattern = (type)pixel;                                      \
+    unsigned int i;                                                           \
+    type *p, *end;                                                            \
+    unsigned long *word;                                                      \
+                                                                              \
+    for (i = bits; i < 64; i *= 2)                                            \
+        pattern |= pattern << i;                                              \
+                                                                              \
+    for (; h > 0; h--, y++) {                                                 \
+        p = (type *)((unsigned char *)s->base + y * s->pitch) + x;           \
+        end = p + w;                                                          \
+                                                                              \
+        while (p < end && ((unsigned long)p & 0x7))                           \
+            *p++ = (type)pixel;                                               \
+                                                                              \
+        for (word = (unsigned long *)p;                                       \
+             word + 1 <= (unsigned long *)end; word++)                        \
+            *word = pattern;                                                  \
+                                                                              \
+        for (p = (type *)word; p < end; p++)                                  \
+            *p = (type)pixel;                                                 \
+    }                                                                         \
+}
+
+DEFINE_SURFACE_OPS(32, unsigned int)
+DEFINE_SURFACE_OPS(16, unsigned short)
+DEFINE_SURFACE_OPS(8, unsigned char)
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_init
+//
+//  Arguments:      s:         The surface to set up
+//                  base:      Address of the first pixel
+//                  width:     Width in pixels
+//                  height:    Height in pixels
+//                  pitch:     Bytes from the start of one row to the next
+//                  format:    One of the SURFACE_* pixel formats
+//
+//  Returns:        void
+//
+//  Description:    This function describes a block of memory as a surface
+//                  and selects the drawing routines for its pixel format.
+//                  Unknown formats fall back to 32 bits per pixel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void surface_init(struct Surface *s, void *base, unsigned int width,
+                  unsigned int height, unsigned int pitch, unsigned int format)
+{
+    s->base = base;
+    s->width = width;
+    s->height = height;
+    s->pitch = pitch;
+
+    switch (format) {
+        case SURFACE_RGB565 :
+        s->format = SURFACE_RGB565;
+        s->put = put_16;
+        s->fill = fill_16;
+        break;
+
+        case SURFACE_PAL8 :
+        s->format = SURFACE_PAL8;
+        s->put = put_8;
+        s->fill = fill_8;
+        break;
+
+        default :
+        s->format = SURFACE_XRGB8888;
+        s->put = put_32;
+        s->fill = fill_32;
+        break;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_window
+//
+//  Arguments:      window:    Surface to set up
+//                  parent:    Surface to take the pixels from
+//                  x, y:      Position of the window in the parent
+//                  width:     Width of the window in pixels
+//                  height:    Height of the window in pixels
+//
+//  Returns:        void
+//
+//  Description:    This function sets up a surface that shares the pixels of
+//                  a rectangle in another surface. Drawing at (0, 0) in the
+//                  window draws at (x, y) in the parent, and is clipped to
+//                  the window. The rectangle must lie inside the parent.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void surface_window(struct Surface *window, struct Surface *parent,
+                    int x, int y, unsigned int width, unsigned int height)
+{
+    surface_init(window, (unsigned char *)parent->base + y * parent->pitch +
+                 x * (parent->format / 8), width, height, parent->pitch,
+                 parent->format);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_map_color
+//
+//  Arguments:      s:         The surface the pixel will be drawn on
+//                  color:     A 0x00RRGGBB color code
+//
+//  Returns:        The pixel value for the color in the surface's format
+//
+//  Description:    This function converts a color code into a pixel value.
+//                  For 8-bit surfaces the nearest palette entry is used.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int surface_map_color(struct Surface *s, unsigned int color)
+{
+    unsigned int r, g, b, i, best, distance, bestDistance, key, pixel;
+    unsigned long mapping = lastMapping;
+    int dr, dg, db;
+
+    key = (s->format << 24) | (color & 0xFFFFFF);
+    if ((mapping & 0xFFFFFFFF) == key)
+        return mapping >> 32;
+
+    r = (color >> 16) & 0xFF;
+    g = (color >> 8) & 0xFF;
+    b = color & 0xFF;
+
+    switch (s->format) {
+        case SURFACE_RGB565 :
+        pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        break;
+
+        case SURFACE_PAL8 :
+        // Find the palette entry with the smallest squared distance
+        best = 0;
+        bestDistance = 0xFFFFFFFF;
+        for (i = 0; i < SURFACE_PALETTE_SIZE; i++) {
+            dr = (int)((palette[i] >> 16) & 0xFF) - (int)r;
+            dg = (int)((palette[i] >> 8) & 0xFF) - (int)g;
+            db = (int)(palette[i] & 0xFF) - (int)b;
+            distance = dr * dr + dg * dg + db * db;
+
+            if (distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        pixel = best;
+        break;
+
+        default :
+        pixel = color;
+        break;
+    }
+
+    lastMapping = ((unsigned long)pixel << 32) | key;
+
+    return pixel;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_palette_color
+//
+//  Arguments:      index:     Palette index
+//
+//  Returns:        The 0x00RRGGBB color of the palette entry
+//
+//  Description:    This function is used to load the 8-bit palette into
+//                  the display hardware.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int surface_palette_color(unsigned int index)
+{
+    return index < SURFACE_PALETTE_SIZE ? palette[index] : BLACK;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_put_pixel
+//
+//  Arguments:      s:         The surface to draw on
+//                  x, y:      Pixel coordinates
+//                  pixel:     Pixel value (see surface_map_color())
+//
+//  Returns:        void
+//
+//  Description:    This function sets a single pixel, ignoring coordinates
+//                  outside the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void surface_put_pixel(struct Surface *s, int x, int y, unsigned int pixel)
+{
+    if (x < 0 || y < 0 || x >= (int)s->width || y >= (int)s->height)
+        return;
+
+    s->put(s, x, y, pixel);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       surface_fill_rect
+//
+//  Arguments:      s:         The surface to draw on
+//                  x, y:      Top left corner of the rectangle
+//                  w, h:      Size of the rectangle in pixels
+//                  pixel:     Pixel value (see surface_map_color())
+//
+//  Returns:        void
+//
+//  Description:    This function fills a rectangle with one pixel value,
+//                  after clipping it to the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void surface_fill_rect(struct Surface *s, int x, int y, int w, int h, unsigned int pixel)
+{
+    // Clip the rectangle to the surface
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > (int)s->width)
+        w = s->width - x;
+    if (y + h > (int)s->height)
+        h = s->height - y;
+
+    if (w <= 0 || h <= 0)
+        return;
+
+    s->fill(s, x, y, w, h, pixel);
+}
@@ -0,0 +1,39 @@
+#ifndef SURFACE_H
+#define SURFACE_H
+
+// Pixel formats, named by their number of bits per pixel
+#define SURFACE_XRGB8888    32  // 0x00RRGGBB, as used by the colors in
+                                // framebuffer.h
+#define SURFACE_RGB565      16  // 5 bits red, 6 bits green, 5 bits blue
+#define SURFACE_PAL8        8   // Index into a 256 entry palette
+
+// Number of palette entries used in 8-bit mode
+#define SURFACE_PALETTE_SIZE  16
+
+// A rectangular array of pixels in memory. Rows are pitch bytes apart,
+// which can be more than width * bytes per pixel. Drawing goes through the
+// put and fill routines, which are selected when the surface is set up so
+// that each one is specialized for the pixel format.
+struct Surface
+{
+    void *base;
+    unsigned int width;
+    unsigned int height;
+    unsigned int pitch;
+    unsigned int format;
+
+    void (*put)(struct Surface *s, int x, int y, unsigned int pixel);
+    void (*fill)(struct Surface *s, int x, int y, int w, int h, unsigned int pixel);
+};
+
+// Function prototypes
+void surface_init(struct Surface *s, void *base, unsigned int width,
+                  unsigned int height, unsigned int pitch, unsigned int format);
+void surface_window(struct Surface *window, struct Surface *parent,
+                    int x, int y, unsigned int width, unsigned int height);
+unsigned int surface_map_color(struct Surface *s, unsigned int color);
+unsigned int surface_palette_color(unsigned int index);
+void surface_put_pixel(struct Surface *s, int x, int y, unsigned int pixel);
+void surface_fill_rect(struct Surface *s, int x, int y, int w, int h, unsigned int pixel);
+
+#endif
@@ -0,0 +1,22 @@
+// C language function prototypes for the functions
+// in sysreg.s, which are written in assembly
+unsigned int getCurrentEL();
+unsigned int getSPSel();
+unsigned int getNZCV();
+unsigned int getDAIF();
+unsigned long getELR();
+
+void enableDAIF();
+void disableDAIF();
+void enableIRQ();
+void disableIRQ();
+void enableFIQ();
+void disableFIQ();
+
+unsigned int getCoreID();
+unsigned long getCNTPCT();
+unsigned long getCNTFRQ();
+void setCNTP_CVAL(unsigned long value);
+void setCNTP_TVAL(unsigned int value);
+unsigned int getCNTP_CTL();
+void setCNTP_CTL(unsigned int value);
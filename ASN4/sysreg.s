@@ -0,0 +1,110 @@
+// This file provides functions to query and set various system registers.
+// It is written in assembly code, since the system registers must be written
+// to or read from using the msr and mrs instructions.
+
+	
+		.text
+		.balign 4
+	
+		.global getCurrentEL
+getCurrentEL:	mrs	x0, CurrentEL
+		lsr	x0, x0, 2
+		and	x0, x0, 0x3
+		ret
+		
+
+		.global getSPSel
+getSPSel:	mrs	x0, SPSel
+		ret
+	
+	
+		.global getNZCV
+getNZCV:	mrs	x0, NZCV
+		lsr	x0, x0, 28
+		and	x0, x0, 0xF
+		ret
+
+
+		.global getDAIF
+getDAIF:	mrs	x0, DAIF
+		lsr	x0, x0, 6
+		and	x0, x0, 0xF
+		ret
+
+
+		// The return address of the exception being handled
+		.global getELR
+getELR:		mrs	x0, ELR_EL1
+		ret
+	
+	
+		.global enableDAIF
+enableDAIF:	msr	DAIFClr, 0b1111
+		ret
+
+	
+		.global disableDAIF
+disableDAIF:	msr	DAIFSet, 0b1111
+		ret
+
+	
+		.global enableIRQ
+enableIRQ:	msr	DAIFClr, 0b0010
+		ret
+
+	
+		.global disableIRQ
+disableIRQ:	msr	DAIFSet, 0b0010
+		ret
+
+	
+		.global enableFIQ
+enableFIQ:	msr	DAIFClr, 0b0001
+		ret
+
+	
+		.global disableFIQ
+disableFIQ:	msr	DAIFSet, 0b0001
+		ret
+
+
+		// The number of the core this code is running on (0 - 3)
+		.global getCoreID
+getCoreID:	mrs	x0, MPIDR_EL1
+		and	x0, x0, 0x3
+		ret
+
+
+		// Generic timer registers. The counter read is preceded by
+		// an isb, so that it is not taken early, out of order with
+		// the code before it.
+		.global getCNTPCT
+getCNTPCT:	isb
+		mrs	x0, CNTPCT_EL0
+		ret
+
+
+		.global getCNTFRQ
+getCNTFRQ:	mrs	x0, CNTFRQ_EL0
+		ret
+
+
+		.global setCNTP_CVAL
+setCNTP_CVAL:	msr	CNTP_CVAL_EL0, x0
+		ret
+
+
+		.global setCNTP_TVAL
+setCNTP_TVAL:	msr	CNTP_TVAL_EL0, x0
+		ret
+
+
+		.global getCNTP_CTL
+getCNTP_CTL:	mrs	x0, CNTP_CTL_EL0
+		ret
+
+
+		.global setCNTP_CTL
+setCNTP_CTL:	msr	CNTP_CTL_EL0, x0
+		isb
+		ret
@@ -0,0 +1,59 @@
+#include "systimer.h"
+#include "sysreg.h"
+#include "timebase.h"
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       get_timer_counter
+//
+//  Arguments:      none
+//
+//  Returns:        The time in microseconds since the system counter
+//                  started
+//
+//  Description:    This function used to read the BCM system timer, which
+//                  takes two or three uncached reads of its CHI and CLO
+//                  registers. It now reads the ARM generic timer's counter
+//                  instead (see timebase.c), with one register read and a
+//                  multiply. Code that needs finer resolution can use
+//                  timebase_ticks() directly.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long get_timer_counter()
+{
+    return ticks_to_us(getCNTPCT());
+}
+
+
+
+ 
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       microsecond_delay
+//
+//  Arguments:      interval:     The time to delay in microseconds
+//
+//  Returns:        void
+//
+//  Description:    This function waits the specified number of microseconds
+//                  by polling the ARM generic timer's counter, which runs
+//                  in Qemu too.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void microsecond_delay(unsigned int interval)
+{
+    unsigned long target_counter;
+
+    // Calculate the target value of the counter. This will be the
+    // specified number of microseconds into the future.
+    target_counter = getCNTPCT() + ns_to_ticks((unsigned long)interval * 1000);
+
+    // Keep polling the counter until we reach the target value
+    while (getCNTPCT() < target_counter)
+        ;
+}
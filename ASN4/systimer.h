@@ -0,0 +1,23 @@
+// The addresses of the BCM System Timer registers.
+//
+// These are defined on page 172 of the Broadcom BCM2837 ARM Peripherals
+// Manual. Channels 0 and 2 are used by the GPU, so only channels 1 and 3
+// are available for our own compare interrupts.
+#include "gpio.h"
+
+#define SYSTEM_TIMER_CS	    ((volatile unsigned int *)(MMIO_BASE + 0x00003000))
+#define SYSTEM_TIMER_CLO    ((volatile unsigned int *)(MMIO_BASE + 0x00003004))
+#define SYSTEM_TIMER_CHI    ((volatile unsigned int *)(MMIO_BASE + 0x00003008))
+#define SYSTEM_TIMER_C0     ((volatile unsigned int *)(MMIO_BASE + 0x0000300C))
+#define SYSTEM_TIMER_C1     ((volatile unsigned int *)(MMIO_BASE + 0x00003010))
+#define SYSTEM_TIMER_C2     ((volatile unsigned int *)(MMIO_BASE + 0x00003014))
+#define SYSTEM_TIMER_C3     ((volatile unsigned int *)(MMIO_BASE + 0x00003018))
+
+// Match flags in the System Timer Control/Status register. Writing a 1
+// to a flag clears the match (and the pending interrupt) for that channel.
+#define SYSTEM_TIMER_M1     (0x1 << 1)
+#define SYSTEM_TIMER_M3     (0x1 << 3)
+
+// Function prototypes
+unsigned long get_timer_counter();
+void microsecond_delay(unsigned int interval);
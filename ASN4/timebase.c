@@ -0,0 +1,248 @@
+// The functions in this file keep time with the ARM generic timer. Every
+// core has its own view of one system counter, which runs at a fixed rate
+// (19.2 MHz on the Raspberry Pi 3) and is read with a single mrs
+// instruction, instead of the two or three uncached reads the BCM System
+// Timer needs. Unlike the System Timer, it is also emulated by Qemu.
+//
+// Every core also has its own physical timer (CNTP), which interrupts the
+// core when the counter reaches a deadline. The interrupt goes through the
+// core's local interrupt controller, so the cores do not compete for the
+// System Timer's two free channels.
+//
+// Ticks are converted with a multiply by a 32.32 fixed point scale and a
+// shift, worked out once from the counter frequency, so no division is
+// needed on the way.
+
+#include "irq.h"
+#include "sysreg.h"
+#include "timebase.h"
+
+// Counter frequency in Hz, and the 32.32 fixed point scales from ticks to
+// nanoseconds and microseconds, and from nanoseconds to ticks
+static unsigned long frequency, nsPerTick, usPerTick, ticksPerNs;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       scale
+//
+//  Arguments:      value:     A number to scale
+//                  factor:    A 32.32 fixed point factor
+//
+//  Returns:        value * factor, rounded down
+//
+//  Description:    This function multiplies with a 128-bit product, so
+//                  that large tick counts do not overflow.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned long scale(unsigned long value, unsigned long factor)
+{
+    return (unsigned long)(((unsigned __int128)value * factor) >> 32);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       set_scales
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function reads the counter frequency, which the
+//                  firmware sets before our code starts, and works out the
+//                  conversion factors. It is called on first use, so the
+//                  conversions work even before timebase_init().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void set_scales()
+{
+    frequency = getCNTFRQ();
+    if (frequency == 0)
+        frequency = 19200000;
+
+    nsPerTick = (1000000000UL << 32) / frequency;
+    usPerTick = (1000000UL << 32) / frequency;
+    ticksPerNs = (frequency << 32) / 1000000000UL;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timebase_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets up the timer of the core that calls
+//                  it: the timer is stopped, and its interrupt is routed to
+//                  the core. Each core that wants deadline interrupts calls
+//                  it once.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void timebase_init()
+{
+    if (frequency == 0)
+        set_scales();
+
+    setCNTP_CTL(0);
+    *LOCAL_TIMER_CONTROL(getCoreID()) |= LOCAL_CNTPNS_IRQ;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timebase_ticks, timebase_frequency
+//
+//  Arguments:      none
+//
+//  Returns:        The system counter, and the number of ticks it counts
+//                  per second
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long timebase_ticks()
+{
+    return getCNTPCT();
+}
+
+unsigned long timebase_frequency()
+{
+    if (frequency == 0)
+        set_scales();
+
+    return frequency;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       ticks_to_ns, ticks_to_us, ns_to_ticks
+//
+//  Arguments:      ticks, ns: The time to convert
+//
+//  Returns:        The time in the other unit, rounded down
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long ticks_to_ns(unsigned long ticks)
+{
+    if (frequency == 0)
+        set_scales();
+
+    return scale(ticks, nsPerTick);
+}
+
+unsigned long ticks_to_us(unsigned long ticks)
+{
+    if (frequency == 0)
+        set_scales();
+
+    return scale(ticks, usPerTick);
+}
+
+unsigned long ns_to_ticks(unsigned long ns)
+{
+    if (frequency == 0)
+        set_scales();
+
+    return scale(ns, ticksPerNs);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timer_set_deadline
+//
+//  Arguments:      ticks:     Counter value at which to interrupt
+//
+//  Returns:        void
+//
+//  Description:    This function arms the calling core's timer. The
+//                  interrupt is raised as soon as the counter reaches the
+//                  deadline, straight away if it already has, and stays
+//                  raised until the timer is cancelled or armed again.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void timer_set_deadline(unsigned long ticks)
+{
+    setCNTP_CVAL(ticks);
+    setCNTP_CTL(CNTP_CTL_ENABLE);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timer_cancel
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function stops the calling core's timer, which also
+//                  clears its interrupt.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void timer_cancel()
+{
+    setCNTP_CTL(0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timer_expired
+//
+//  Arguments:      none
+//
+//  Returns:        TRUE (non-zero) if the calling core's timer is armed and
+//                  its deadline has passed
+//
+//  Description:    This function lets a core with IRQs masked (such as
+//                  cores 1 - 3) poll its timer instead.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int timer_expired()
+{
+    unsigned int control = getCNTP_CTL();
+
+    return (control & CNTP_CTL_ENABLE) && (control & CNTP_CTL_ISTATUS);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       timer_irq_handler
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function is called by the IRQ handler when the
+//                  calling core's timer has reached its deadline. It only
+//                  stops the timer, since the interrupt's purpose is to
+//                  wake the core from wfi; whoever armed the timer checks
+//                  the counter when it wakes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void timer_irq_handler()
+{
+    setCNTP_CTL(0);
+}
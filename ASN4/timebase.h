@@ -0,0 +1,22 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+// Bits in the CNTP_CTL_EL0 register
+#define CNTP_CTL_ENABLE     (0x1 << 0)
+#define CNTP_CTL_IMASK      (0x1 << 1)
+#define CNTP_CTL_ISTATUS    (0x1 << 2)
+
+// Function prototypes
+void timebase_init();
+unsigned long timebase_ticks();
+unsigned long timebase_frequency();
+unsigned long ticks_to_ns(unsigned long ticks);
+unsigned long ticks_to_us(unsigned long ticks);
+unsigned long ns_to_ticks(unsigned long ns);
+
+void timer_set_deadline(unsigned long ticks);
+void timer_cancel();
+int timer_expired();
+void timer_irq_handler();
+
+#endif
@@ -0,0 +1,230 @@
+// The functions in this file record a trace of what each core is doing,
+// so that the way interrupts, frames, controller samples and redraws
+// interleave can be looked at on a timeline afterwards. Each record is a
+// timestamp from the generic timer and one word for the event, written
+// with two stores into a ring.
+//
+// Every ring has exactly one writer, so no locks are needed: each core has
+// its own rings, and its interrupt handlers write to a different ring from
+// the code they interrupt. The rings keep the latest TRACE_RING_SIZE
+// records each, and recording never stops, so the trace always covers the
+// moments just before the 't' UART command sends it. The host tool
+// host/trace2json turns it into the JSON trace format that Chrome
+// (chrome://tracing) and Perfetto (ui.perfetto.dev) read.
+
+#include "uart.h"
+#include "crc.h"
+#include "memory.h"
+#include "smp.h"
+#include "sysreg.h"
+#include "timebase.h"
+#include "trace.h"
+
+// A ring of records, on cache lines of its own
+struct TraceRing
+{
+    struct TraceRecord *records;
+    unsigned long head;                 // Records written so far
+} __attribute__((aligned(SMP_CACHE_LINE)));
+
+static struct TraceRing rings[SMP_CORES][TRACE_CONTEXTS];
+
+// Set while a core is in IRQ_handler(), which selects its second ring
+static volatile unsigned int inIRQ[SMP_CORES];
+
+// Cleared while the trace is being sent
+static volatile int recording;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       trace_init
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function takes the rings from the heap and starts
+//                  recording. Trace points reached before it is called are
+//                  ignored.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void trace_init()
+{
+    unsigned int core, context;
+
+    for (core = 0; core < SMP_CORES; core++) {
+        for (context = 0; context < TRACE_CONTEXTS; context++) {
+            rings[core][context].records =
+                mem_alloc(TRACE_RING_SIZE * sizeof(struct TraceRecord), MEM_CACHE_LINE);
+            rings[core][context].head = 0;
+        }
+    }
+
+    recording = 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       trace_event
+//
+//  Arguments:      event:     Event number (TRACE_IRQ, ...)
+//                  phase:     TRACE_BEGIN, TRACE_END or TRACE_INSTANT
+//                  arg:       A number to keep with the event
+//
+//  Returns:        void
+//
+//  Description:    This function adds a record to the calling core's ring
+//                  for the current context. It is usually called through
+//                  trace_begin(), trace_end() and trace_instant().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void trace_event(unsigned int event, unsigned int phase, unsigned int arg)
+{
+    unsigned int core = getCoreID();
+    struct TraceRing *ring = &rings[core][inIRQ[core]];
+    struct TraceRecord *record;
+
+    if (!recording || ring->records == 0)
+        return;
+
+    record = &ring->records[ring->head & (TRACE_RING_SIZE - 1)];
+    record->time = getCNTPCT();
+    record->data = event | (phase << 16) | ((unsigned long)arg << 32);
+    ring->head++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       trace_irq_enter, trace_irq_exit
+//
+//  Arguments:      sources:   The interrupt sources that are pending
+//
+//  Returns:        void
+//
+//  Description:    These functions are called at the start and the end of
+//                  IRQ_handler(). They switch the core to its interrupt
+//                  ring, and record the time spent in the handler.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void trace_irq_enter(unsigned int sources)
+{
+    inIRQ[getCoreID()] = 1;
+    trace_begin(TRACE_IRQ, sources);
+}
+
+void trace_irq_exit()
+{
+    trace_end(TRACE_IRQ, 0);
+    inIRQ[getCoreID()] = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       put_word
+//
+//  Arguments:      value:     Number to send
+//                  bytes:     Number of bytes to send (1, 2 or 4)
+//                  crc:       Running checksum, updated with the bytes sent
+//
+//  Returns:        void
+//
+//  Description:    This function sends a number in little-endian order.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_word(unsigned int value, int bytes, unsigned int *crc)
+{
+    unsigned char byte;
+
+    while (bytes--) {
+        byte = value & 0xFF;
+        uart_putc(byte);
+        if (crc)
+            *crc = crc32_update(*crc, &byte, 1);
+        value >>= 8;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       trace_dump
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sends the rings over the UART in binary:
+//
+//                      "TRC1", counter frequency (4 bytes), number of rings
+//                      (2 bytes), then for each ring its core (1 byte),
+//                      context (1 byte, 1 for interrupts), number of records
+//                      (4 bytes) and the records oldest first, 16 bytes
+//                      each, and finally a CRC-32 of everything after the
+//                      magic bytes (4 bytes)
+//
+//                  All numbers are little-endian. Recording is paused while
+//                  the trace is sent, and then carries on.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void trace_dump()
+{
+    unsigned int crc = 0, core, context, count, start, length;
+    unsigned long head;
+    char *magic = TRACE_MAGIC;
+    struct TraceRing *ring;
+
+    recording = 0;
+    asm volatile("dsb sy" ::: "memory");
+
+    while (*magic)
+        uart_putc(*magic++);
+
+    put_word(timebase_frequency(), 4, &crc);
+    put_word(SMP_CORES * TRACE_CONTEXTS, 2, &crc);
+
+    for (core = 0; core < SMP_CORES; core++) {
+        for (context = 0; context < TRACE_CONTEXTS; context++) {
+            ring = &rings[core][context];
+            head = ring->records ? ring->head : 0;
+            count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+
+            put_word(core, 1, &crc);
+            put_word(context, 1, &crc);
+            put_word(count, 4, &crc);
+
+            // Send the records as at most two blocks, split where the ring
+            // wraps
+            start = (head - count) & (TRACE_RING_SIZE - 1);
+            while (count > 0) {
+                length = count < TRACE_RING_SIZE - start ? count : TRACE_RING_SIZE - start;
+
+                uart_write((unsigned char *)&ring->records[start],
+                           length * sizeof(struct TraceRecord));
+                crc = crc32_update(crc, (unsigned char *)&ring->records[start],
+                                   length * sizeof(struct TraceRecord));
+
+                count -= length;
+                start = 0;
+            }
+        }
+    }
+
+    put_word(crc, 4, 0);
+    uart_flush();
+
+    recording = 1;
+}
@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Number of records kept per ring (must be a power of 2). When a ring is
+// full, the oldest records are overwritten.
+#define TRACE_RING_SIZE     4096
+
+// Each core has one ring for its normal code and one for its interrupt
+// handlers, so that neither can interrupt the other halfway through a
+// record
+#define TRACE_CONTEXTS      2
+
+// Record phases: the start or end of something that takes time, or a
+// single moment
+#define TRACE_BEGIN         0
+#define TRACE_END           1
+#define TRACE_INSTANT       2
+
+// Events. The names are in TRACE_NAMES, in the same order.
+#define TRACE_IRQ           0   // IRQ_handler() (arg: sources pending)
+#define TRACE_FRAME         1   // A frame of the main loop (arg: frame number)
+#define TRACE_IDLE          2   // Waiting for the frame deadline
+#define TRACE_SNES_POLL     3   // get_SNES()
+#define TRACE_SNES_SAMPLE   4   // Sampler published a sample (arg: buttons)
+#define TRACE_MAZE          5   // drawMaze()
+#define TRACE_BAND          6   // One core's band of a redraw (arg: first row)
+#define TRACE_UART          7   // UART interrupt handler
+#define TRACE_FILL          8   // Flood fill (arg: pixels filled, at the end)
+#define TRACE_UNDO          9   // Undo or redo (arg: 1 for redo)
+#define TRACE_EVENTS        10
+
+#define TRACE_NAMES { "irq", "frame", "idle", "snes_poll", "snes_sample", \
+                      "draw_maze", "band", "uart_irq", "fill", "undo" }
+
+// Magic bytes starting a trace sent to the host
+#define TRACE_MAGIC         "TRC1"
+
+// A record: the generic timer counter, then the event in bits 15-0, the
+// phase in bits 23-16 and the argument in bits 63-32
+struct TraceRecord
+{
+    unsigned long time;
+    unsigned long data;
+};
+
+// Shorthands for the trace points
+#define trace_begin(event, arg)     trace_event(event, TRACE_BEGIN, arg)
+#define trace_end(event, arg)       trace_event(event, TRACE_END, arg)
+#define trace_instant(event, arg)   trace_event(event, TRACE_INSTANT, arg)
+
+// Function prototypes
+void trace_init();
+void trace_event(unsigned int event, unsigned int phase, unsigned int arg);
+void trace_irq_enter(unsigned int sources);
+void trace_irq_exit();
+void trace_dump();
+
+#endif
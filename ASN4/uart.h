@@ -0,0 +1,20 @@
+// These are the function prototypes for reading/writing the UART. The Mini
+// UART (uart.c) is used by default; defining UART_PL011 switches to the
+// PL011 UART0 driver in pl011.c with the same functions.
+
+// Baud rate of the PL011 UART. The Mini UART always runs at 115200.
+#ifndef UART_BAUD
+#define UART_BAUD 921600
+#endif
+
+void uart_init();
+void uart_putc(unsigned int c);
+char uart_getc();
+int uart_rx_ready();
+void uart_write(const void *data, unsigned int length);
+void uart_flush();
+void uart_irq_handler();
+void uart_puts(char *s);
+void uart_puthex(unsigned int value);
+void uart_putdec(unsigned int value);
+void uart_putdec_padded(unsigned int value, int width);
@@ -0,0 +1,575 @@
+// The functions in this file keep an undo/redo history of the canvas under
+// a fixed memory budget. Instead of copying the whole drawing for every
+// step, the canvas is divided into 64 x 64 tiles, and a tile is copied the
+// first time it is about to change during a step (copy-on-write). When the
+// step ends, each copied tile is XORed with its new contents, and the
+// difference is compressed into the history arena.
+//
+// Since a step is stored as the XOR of the tiles before and after it,
+// applying it again flips the canvas either way, so undo and redo use the
+// same data and cost time in proportion to the tiles the step touched.
+//
+// The arena is a ring of steps, oldest first:
+//
+//     u32 length, u16 x0, y0, x1, y1      header (pen before and after)
+//     tile records                        u16 tile, then the compressed XOR
+//     u32 length                          footer, to walk backwards
+//
+// A tile's XOR is compressed as a u64 mask of the rows that changed,
+// then for each of those rows a byte mask of its changed bytes followed by
+// those bytes. A short stroke usually takes a few dozen bytes.
+//
+// Fills change whole rows the same way, so changed rows can also be run
+// length encoded: a byte mask of 0 (never used for a changed row) starts a
+// run, followed by a byte holding the number of rows minus 1 in bits 5-0
+// and in bit 7 whether the changed bytes are all equal, then the byte mask
+// and the changed bytes (just one if they are equal). The run's XOR
+// applies to that many changed rows, so a tile filled with ink takes 14
+// bytes rather than 586.
+//
+// Steps before the cursor can be undone, and steps after it redone. A new
+// step drops those that could be redone, and when the arena fills up the
+// oldest steps are forgotten.
+
+#include "canvas.h"
+#include "boot.h"
+#include "undo.h"
+
+// Sizes of the step header and footer, and the longest tile record
+#define HEADER_SIZE     12
+#define FOOTER_SIZE     4
+#define RECORD_MAX      (2 + 8 + UNDO_TILE_SIZE * 9)
+
+// The history. Positions count bytes and are masked when used as indices.
+// Only the steps between tail and head are read, so it is not cleared at
+// boot.
+static unsigned char arena[UNDO_ARENA_SIZE] BOOT_LAZY;
+static unsigned int tail, cursor, head;
+
+// The step being drawn. If it grows too big for the whole arena it is
+// lost, and the history is cleared.
+static unsigned int stepStart;
+static int stepOpen, stepLost;
+static int startX, startY;
+
+// Original contents of the tiles touched by the open step, and a bitmap
+// of the tiles that have been copied. Only the first scratchCount tiles
+// are read, so the scratch tiles are not cleared at boot.
+static unsigned long scratch[UNDO_SCRATCH_TILES][UNDO_TILE_SIZE] BOOT_LAZY;
+static unsigned short scratchTile[UNDO_SCRATCH_TILES];
+static unsigned int scratchCount;
+static unsigned long copied[(UNDO_TILES + 63) / 64];
+
+
+
+static void put_le(unsigned int position, unsigned int value, int bytes)
+{
+    while (bytes--) {
+        arena[position++ & (UNDO_ARENA_SIZE - 1)] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static unsigned int get_le(unsigned int position, int bytes)
+{
+    unsigned int value = 0;
+
+    while (bytes--)
+        value = (value << 8) | arena[(position + bytes) & (UNDO_ARENA_SIZE - 1)];
+
+    return value;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       tile_rows
+//
+//  Arguments:      tile:      Tile number
+//
+//  Returns:        The number of canvas rows in the tile (less than
+//                  UNDO_TILE_SIZE only for the bottom row of tiles when
+//                  the canvas height is not a multiple of the tile size)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int tile_rows(unsigned int tile)
+{
+    int top = (tile / UNDO_TILES_X) * UNDO_TILE_SIZE;
+
+    return CANVAS_HEIGHT - top < UNDO_TILE_SIZE ? CANVAS_HEIGHT - top : UNDO_TILE_SIZE;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       make_room
+//
+//  Arguments:      length:    Number of bytes about to be appended
+//
+//  Returns:        TRUE (non-zero) if there is room, FALSE (zero) if the
+//                  open step alone would not fit in the arena
+//
+//  Description:    This function forgets the oldest steps until the arena
+//                  has room for length more bytes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static int make_room(unsigned int length)
+{
+    while (head + length - tail > UNDO_ARENA_SIZE) {
+        if (tail == stepStart)
+            return 0;
+        tail += get_le(tail, 4);
+    }
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       lose_history
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function is called when the open step does not fit
+//                  in the arena. Older steps cannot be undone without it,
+//                  so the whole history is cleared, and the rest of the
+//                  step is ignored.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void lose_history()
+{
+    unsigned int i;
+
+    for (i = 0; i < scratchCount; i++)
+        copied[scratchTile[i] >> 6] &= ~(1UL << (scratchTile[i] & 63));
+    scratchCount = 0;
+
+    tail = cursor = head = 0;
+    stepOpen = 0;
+    stepLost = 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       flush_scratch
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function compresses the difference between each
+//                  copied tile and its current contents into the arena,
+//                  and frees the copies. Tiles that ended up unchanged are
+//                  left out.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void flush_scratch()
+{
+    unsigned char record[RECORD_MAX], first;
+    unsigned long delta, rowMask, deltas[UNDO_TILE_SIZE];
+    unsigned int i, tile, length, n, byteMask, bytes, count, run, r;
+    int row, rows, top, column, b, equal;
+
+    for (i = 0; i < scratchCount; i++) {
+        tile = scratchTile[i];
+        copied[tile >> 6] &= ~(1UL << (tile & 63));
+
+        top = (tile / UNDO_TILES_X) * UNDO_TILE_SIZE;
+        column = tile % UNDO_TILES_X;
+        rows = tile_rows(tile);
+
+        // Find the rows that changed
+        rowMask = 0;
+        count = 0;
+        for (row = 0; row < rows; row++) {
+            delta = scratch[i][row] ^ canvas[top + row][column];
+            if (delta != 0) {
+                rowMask |= 1UL << row;
+                deltas[count++] = delta;
+            }
+        }
+
+        if (rowMask == 0)
+            continue;
+
+        // Tile number, then room for the row mask
+        record[0] = tile & 0xFF;
+        record[1] = tile >> 8;
+        length = 10;
+
+        for (r = 0; r < count; r += run) {
+            delta = deltas[r];
+            for (run = 1; r + run < count && deltas[r + run] == delta; run++)
+                ;
+
+            byteMask = bytes = 0;
+            first = 0;
+            equal = 1;
+            for (b = 0; b < 8; b++) {
+                if ((delta >> (b * 8)) & 0xFF) {
+                    byteMask |= 1 << b;
+                    if (bytes++ == 0)
+                        first = (delta >> (b * 8)) & 0xFF;
+                    else if (((delta >> (b * 8)) & 0xFF) != first)
+                        equal = 0;
+                }
+            }
+
+            // Use a run only where it is shorter than the rows written out
+            if (3 + (equal ? 1 : bytes) < run * (1 + bytes)) {
+                record[length++] = 0;
+                record[length++] = (run - 1) | (equal ? 0x80 : 0);
+                record[length++] = byteMask;
+                if (equal)
+                    bytes = 1;
+            } else {
+                run = 1;
+                record[length++] = byteMask;
+            }
+
+            for (b = 0, n = 0; b < 8 && n < bytes; b++) {
+                if (byteMask & (1 << b)) {
+                    record[length++] = (delta >> (b * 8)) & 0xFF;
+                    n++;
+                }
+            }
+        }
+
+        for (b = 0; b < 8; b++)
+            record[2 + b] = (rowMask >> (b * 8)) & 0xFF;
+
+        if (!make_room(length)) {
+            lose_history();
+            return;
+        }
+
+        for (n = 0; n < length; n++)
+            arena[head++ & (UNDO_ARENA_SIZE - 1)] = record[n];
+    }
+
+    scratchCount = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       close_step
+//
+//  Arguments:      x, y:      Pen position at the end of the step
+//
+//  Returns:        void
+//
+//  Description:    This function finishes the open step, if any, and moves
+//                  the cursor past it. A step that changed nothing is
+//                  dropped.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void close_step(int x, int y)
+{
+    unsigned int length;
+
+    startX = x;
+    startY = y;
+
+    if (!stepOpen)
+        return;
+
+    flush_scratch();
+    if (stepLost)
+        return;
+
+    stepOpen = 0;
+
+    if (head == stepStart + HEADER_SIZE || !make_room(FOOTER_SIZE)) {
+        head = cursor = stepStart;
+        return;
+    }
+
+    length = head + FOOTER_SIZE - stepStart;
+    put_le(head, length, 4);
+    head += FOOTER_SIZE;
+
+    put_le(stepStart, length, 4);
+    put_le(stepStart + 8, x, 2);
+    put_le(stepStart + 10, y, 2);
+
+    cursor = head;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_checkpoint
+//
+//  Arguments:      x, y:      Current pen position
+//
+//  Returns:        void
+//
+//  Description:    This function ends the current step, so that the next
+//                  change to the canvas starts a new one. It is called at
+//                  the start of every stroke and before an erase.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void undo_checkpoint(int x, int y)
+{
+    close_step(x, y);
+    stepLost = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_clear
+//
+//  Arguments:      x, y:      Current pen position
+//
+//  Returns:        void
+//
+//  Description:    This function forgets the whole history, including the
+//                  open step, so that the next change to the canvas starts
+//                  a new first step. It is called when the canvas is about
+//                  to be redrawn from somewhere other than the history,
+//                  such as a journal replay.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void undo_clear(int x, int y)
+{
+    lose_history();
+    stepLost = 0;
+    startX = x;
+    startY = y;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_touch
+//
+//  Arguments:      x, y:      A canvas pixel that is about to change
+//
+//  Returns:        void
+//
+//  Description:    This function copies the tile holding the pixel, if it
+//                  has not been copied yet in this step. It is called by
+//                  the canvas functions before they change a pixel, so the
+//                  common case (a tile already copied) is one bit test.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void undo_touch(int x, int y)
+{
+    unsigned int tile = (y / UNDO_TILE_SIZE) * UNDO_TILES_X + x / UNDO_TILE_SIZE;
+    int row, rows, top, column;
+
+    if (stepLost || (copied[tile >> 6] >> (tile & 63)) & 0x1)
+        return;
+
+    // Start a new step, dropping the steps that could have been redone
+    if (!stepOpen) {
+        head = stepStart = cursor;
+        if (!make_room(HEADER_SIZE)) {
+            lose_history();
+            return;
+        }
+        put_le(head, 0, 4);
+        put_le(head + 4, startX, 2);
+        put_le(head + 6, startY, 2);
+        head += HEADER_SIZE;
+        stepOpen = 1;
+    }
+
+    if (scratchCount == UNDO_SCRATCH_TILES) {
+        flush_scratch();
+        if (stepLost)
+            return;
+    }
+
+    top = (tile / UNDO_TILES_X) * UNDO_TILE_SIZE;
+    column = tile % UNDO_TILES_X;
+    rows = tile_rows(tile);
+
+    for (row = 0; row < rows; row++)
+        scratch[scratchCount][row] = canvas[top + row][column];
+
+    scratchTile[scratchCount++] = tile;
+    copied[tile >> 6] |= 1UL << (tile & 63);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       apply_step
+//
+//  Arguments:      start:     Position of the step header in the arena
+//                  redraw:    Function that redraws a region of the canvas
+//
+//  Returns:        The length of the step in bytes
+//
+//  Description:    This function XORs every tile record of a step into the
+//                  canvas, and redraws each tile it changes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static unsigned int apply_step(unsigned int start, void (*redraw)(int x, int y, int w, int h))
+{
+    unsigned int length = get_le(start, 4);
+    unsigned int position = start + HEADER_SIZE, end = start + length - FOOTER_SIZE;
+    unsigned int tile, byteMask, repeat, equal, value;
+    unsigned long rowMask, delta = 0;
+    int row, top, column, b;
+
+    while (position != end) {
+        tile = get_le(position, 2);
+        rowMask = get_le(position + 2, 4) | (unsigned long)get_le(position + 6, 4) << 32;
+        position += 10;
+
+        top = (tile / UNDO_TILES_X) * UNDO_TILE_SIZE;
+        column = tile % UNDO_TILES_X;
+        repeat = 0;
+
+        for (row = 0; rowMask != 0; row++, rowMask >>= 1) {
+            if (!(rowMask & 0x1))
+                continue;
+
+            // Decode the next row, or run of rows, unless in a run
+            if (repeat == 0) {
+                byteMask = arena[position++ & (UNDO_ARENA_SIZE - 1)];
+                repeat = 1;
+                equal = 0;
+                if (byteMask == 0) {
+                    value = arena[position++ & (UNDO_ARENA_SIZE - 1)];
+                    repeat = (value & 0x3F) + 1;
+                    equal = value & 0x80;
+                    byteMask = arena[position++ & (UNDO_ARENA_SIZE - 1)];
+                }
+
+                delta = 0;
+                value = 0;
+                if (equal)
+                    value = arena[position++ & (UNDO_ARENA_SIZE - 1)];
+                for (b = 0; b < 8; b++) {
+                    if (byteMask & (1 << b)) {
+                        if (!equal)
+                            value = arena[position++ & (UNDO_ARENA_SIZE - 1)];
+                        delta |= (unsigned long)value << (b * 8);
+                    }
+                }
+            }
+
+            canvas[top + row][column] ^= delta;
+            repeat--;
+        }
+
+        redraw(column * UNDO_TILE_SIZE, top, UNDO_TILE_SIZE, tile_rows(tile));
+    }
+
+    return length;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_undo
+//
+//  Arguments:      x, y:      The pen position, which is moved back to
+//                             where it was before the undone step
+//                  redraw:    Function that redraws a region of the canvas
+//
+//  Returns:        TRUE (non-zero) if a step was undone, FALSE (zero) if
+//                  there is no history left
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int undo_undo(int *x, int *y, void (*redraw)(int x, int y, int w, int h))
+{
+    unsigned int start;
+
+    undo_checkpoint(*x, *y);
+
+    if (cursor == tail)
+        return 0;
+
+    start = cursor - get_le(cursor - FOOTER_SIZE, 4);
+    apply_step(start, redraw);
+
+    *x = get_le(start + 4, 2);
+    *y = get_le(start + 6, 2);
+    startX = *x;
+    startY = *y;
+
+    cursor = start;
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_redo
+//
+//  Arguments:      x, y:      The pen position, which is moved to where it
+//                             was after the redone step
+//                  redraw:    Function that redraws a region of the canvas
+//
+//  Returns:        TRUE (non-zero) if a step was redone, FALSE (zero) if
+//                  there is nothing to redo
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int undo_redo(int *x, int *y, void (*redraw)(int x, int y, int w, int h))
+{
+    unsigned int start;
+
+    undo_checkpoint(*x, *y);
+
+    if (cursor == head)
+        return 0;
+
+    start = cursor;
+    cursor += apply_step(start, redraw);
+
+    *x = get_le(start + 8, 2);
+    *y = get_le(start + 10, 2);
+    startX = *x;
+    startY = *y;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       undo_used
+//
+//  Arguments:      none
+//
+//  Returns:        The number of arena bytes holding history
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int undo_used()
+{
+    return head - tail;
+}
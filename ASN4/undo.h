@@ -0,0 +1,30 @@
+#ifndef UNDO_H
+#define UNDO_H
+
+#include "canvas.h"
+
+// The canvas is divided into square tiles of 64 x 64 pixels, so a tile row
+// is exactly one canvas word
+#define UNDO_TILE_SIZE      64
+#define UNDO_TILES_X        (CANVAS_WIDTH / UNDO_TILE_SIZE)
+#define UNDO_TILES_Y        ((CANVAS_HEIGHT + UNDO_TILE_SIZE - 1) / UNDO_TILE_SIZE)
+#define UNDO_TILES          (UNDO_TILES_X * UNDO_TILES_Y)
+
+// Memory budget for the compressed history in bytes (must be a power of
+// 2). When it is full, the oldest steps are forgotten.
+#define UNDO_ARENA_SIZE     131072
+
+// Number of tiles whose original contents can be held uncompressed while
+// a step is being drawn. When more are touched, the changes made so far
+// are compressed into the arena early.
+#define UNDO_SCRATCH_TILES  32
+
+// Function prototypes
+void undo_checkpoint(int x, int y);
+void undo_clear(int x, int y);
+void undo_touch(int x, int y);
+int undo_undo(int *x, int *y, void (*redraw)(int x, int y, int w, int h));
+int undo_redo(int *x, int *y, void (*redraw)(int x, int y, int w, int h));
+unsigned int undo_used();
+
+#endif
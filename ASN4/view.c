@@ -0,0 +1,297 @@
+// The functions in this file show part of a canvas that is bigger than the
+// screen, and scroll it to follow the pen. The virtual frame buffer is
+// bigger than the screen too, and holds a window of the canvas around the
+// visible part. Scrolling inside that window only changes the virtual
+// offset the display is scanned out from, which is done by the firmware,
+// and then fills in the strips of pixels that have just come into view.
+// Only when the view would leave the window is the window moved and the
+// screen repainted from the canvas.
+//
+// All coordinates passed to these functions are canvas coordinates.
+
+#include "framebuffer.h"
+#include "canvas.h"
+#include "view.h"
+#include "smp.h"
+
+// Top left corner of the visible part, and of the window of the canvas held
+// in the virtual frame buffer
+static int viewX, viewY, windowX, windowY;
+
+// The visible part of the virtual frame buffer, as a surface of its own
+static struct Surface visible;
+
+
+
+static int clamp(int value, int low, int high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       place_window
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function centers the window on the view, keeping it
+//                  inside the canvas and on a VIEW_ALIGN boundary.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void place_window()
+{
+    int spareX = screen.width - frameBufferWidth;
+    int spareY = screen.height - frameBufferHeight;
+
+    windowX = clamp((viewX - spareX / 2) & ~(VIEW_ALIGN - 1), 0, CANVAS_WIDTH - (int)screen.width);
+    windowY = clamp((viewY - spareY / 2) & ~(VIEW_ALIGN - 1), 0, CANVAS_HEIGHT - (int)screen.height);
+
+    // The view must still fit, which matters only near the canvas edges
+    windowX = clamp(windowX, viewX - spareX, viewX);
+    windowY = clamp(windowY, viewY - spareY, viewY);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       show
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function points the display and the visible surface
+//                  at the view's position in the virtual frame buffer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void show()
+{
+    surface_window(&visible, &screen, viewX - windowX, viewY - windowY,
+                   frameBufferWidth, frameBufferHeight);
+    setVirtualOffset(viewX - windowX, viewY - windowY);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_init
+//
+//  Arguments:      x, y:      Canvas position to center the view on
+//
+//  Returns:        void
+//
+//  Description:    This function places the view, and must be called after
+//                  the frame buffer is set up and before anything is drawn.
+//                  The screen is not painted.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void view_init(int x, int y)
+{
+    viewX = clamp(x - (int)frameBufferWidth / 2, 0, CANVAS_WIDTH - frameBufferWidth);
+    viewY = clamp(y - (int)frameBufferHeight / 2, 0, CANVAS_HEIGHT - frameBufferHeight);
+
+    place_window();
+    show();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_follow
+//
+//  Arguments:      x, y:      The pen position
+//
+//  Returns:        TRUE (non-zero) if the view moved, FALSE (zero) if not
+//
+//  Description:    This function scrolls the view just enough to keep the
+//                  pen VIEW_MARGIN pixels away from its edges. Strips that
+//                  come into view are drawn from the canvas; if the view
+//                  leaves the window, the window is moved and the whole
+//                  screen is repainted.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int view_follow(int x, int y)
+{
+    int oldX = viewX, oldY = viewY, width = frameBufferWidth, height = frameBufferHeight;
+    int newX, newY;
+
+    newX = clamp(viewX, x + VIEW_MARGIN - width, x - VIEW_MARGIN);
+    newY = clamp(viewY, y + VIEW_MARGIN - height, y - VIEW_MARGIN);
+    newX = clamp(newX, 0, CANVAS_WIDTH - width);
+    newY = clamp(newY, 0, CANVAS_HEIGHT - height);
+
+    if (newX == oldX && newY == oldY)
+        return 0;
+
+    viewX = newX;
+    viewY = newY;
+
+    if (viewX < windowX || viewY < windowY ||
+        viewX + width > windowX + (int)screen.width ||
+        viewY + height > windowY + (int)screen.height) {
+        place_window();
+        show();
+        view_repaint();
+        return 1;
+    }
+
+    show();
+
+    // Fill in the columns, then the rows, that were not visible before
+    if (viewX > oldX)
+        view_present(oldX + width, viewY, viewX - oldX, height);
+    else if (viewX < oldX)
+        view_present(viewX, viewY, oldX - viewX, height);
+
+    if (viewY > oldY)
+        view_present(viewX, oldY + height, width, viewY - oldY);
+    else if (viewY < oldY)
+        view_present(viewX, viewY, width, oldY - viewY);
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_present
+//
+//  Arguments:      x, y:      Top left corner of a canvas region
+//                  w, h:      Size of the region in pixels
+//
+//  Returns:        void
+//
+//  Description:    This function draws the visible part of a canvas region
+//                  on the screen.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void view_present(int x, int y, int w, int h)
+{
+    int right = x + w, bottom = y + h;
+
+    x = clamp(x, viewX, viewX + frameBufferWidth);
+    y = clamp(y, viewY, viewY + frameBufferHeight);
+    right = clamp(right, viewX, viewX + frameBufferWidth);
+    bottom = clamp(bottom, viewY, viewY + frameBufferHeight);
+
+    if (right > x && bottom > y)
+        canvas_present(&screen, windowX, windowY, x, y, right - x, bottom - y);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_fill
+//
+//  Arguments:      x, y:      Top left corner of a canvas region
+//                  w, h:      Size of the region in pixels
+//                  colour:    RGB color code
+//
+//  Returns:        void
+//
+//  Description:    This function fills the visible part of a region of the
+//                  screen with a color, without changing the canvas.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void view_fill(int x, int y, int w, int h, unsigned int colour)
+{
+    surface_fill_rect(&visible, x - viewX, y - viewY, w, h,
+                      surface_map_color(&visible, colour));
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       repaint_band
+//
+//  Arguments:      arg:       Unused
+//                  y, h:      Rows of the screen to draw
+//
+//  Returns:        void
+//
+//  Description:    This function draws a band of the view from the canvas.
+//                  It runs on every core at once during a repaint.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static void repaint_band(void *arg, int y, int h)
+{
+    if (h > 0)
+        view_present(viewX, viewY + y, frameBufferWidth, h);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_repaint
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function draws the whole view from the canvas, with
+//                  the rows split between the cores.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void view_repaint()
+{
+    smp_bands(&visible, 0, frameBufferHeight, repaint_band, 0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_x, view_y
+//
+//  Returns:        The canvas position of the top left corner of the screen
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int view_x()
+{
+    return viewX;
+}
+
+int view_y()
+{
+    return viewY;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       view_surface
+//
+//  Arguments:      none
+//
+//  Returns:        A surface covering exactly the visible part of the
+//                  screen, in screen coordinates. It is updated in place
+//                  when the view scrolls, so it can be kept by the HUD.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Surface *view_surface()
+{
+    return &visible;
+}
+
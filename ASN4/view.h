@@ -0,0 +1,23 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include "surface.h"
+
+// The view scrolls when the pen comes closer than this to its edge
+#define VIEW_MARGIN         64
+
+// When the view has to leave the part of the canvas held in the virtual
+// frame buffer, the held part is moved in steps of this many pixels
+#define VIEW_ALIGN          64
+
+// Function prototypes
+void view_init(int x, int y);
+int view_follow(int x, int y);
+void view_present(int x, int y, int w, int h);
+void view_fill(int x, int y, int w, int h, unsigned int colour);
+void view_repaint();
+int view_x();
+int view_y();
+struct Surface *view_surface();
+
+#endif
@@ -0,0 +1,676 @@
+// Reading Logisim 2.7 project files; see circ.h. The port layouts here
+// follow the component classes of Logisim 2.7.1.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "circ.h"
+#include "xml.h"
+
+// How far (in pixels) a text may be from a component to name it
+#define LABEL_DISTANCE  50
+
+namespace {
+
+enum Direction { EAST, NORTH, WEST, SOUTH };
+
+Direction direction(const std::string &facing)
+{
+    if (facing == "north")
+        return NORTH;
+    if (facing == "west")
+        return WEST;
+    if (facing == "south")
+        return SOUTH;
+    return EAST;
+}
+
+Direction reverse(Direction d)
+{
+    return (Direction)((d + 2) % 4);
+}
+
+// Moves dist along d and right to its right, as Logisim's Location.translate
+Point translate(Point p, Direction d, int dist, int right = 0)
+{
+    switch (d) {
+    case EAST:  return {p.x + dist, p.y + right};
+    case WEST:  return {p.x - dist, p.y - right};
+    case SOUTH: return {p.x - right, p.y + dist};
+    default:    return {p.x + right, p.y - dist};
+    }
+}
+
+// Turns an offset drawn facing east so that it faces d
+Point rotate(Point p, Direction d)
+{
+    switch (d) {
+    case NORTH: return {p.y, -p.x};
+    case WEST:  return {-p.x, -p.y};
+    case SOUTH: return {-p.y, p.x};
+    default:    return p;
+    }
+}
+
+Point parse_point(const std::string &text)
+{
+    Point p;
+
+    if (sscanf(text.c_str(), " (%d ,%d )", &p.x, &p.y) != 2)
+        throw std::runtime_error("bad location " + text);
+    return p;
+}
+
+Kind kind_of(const std::string &library, const std::string &name)
+{
+    static const struct { const char *library, *name; Kind kind; } kinds[] = {
+        {"#Wiring", "Pin", Kind::Pin},
+        {"#Wiring", "Tunnel", Kind::Tunnel},
+        {"#Wiring", "Splitter", Kind::Splitter},
+        {"#Wiring", "Constant", Kind::Constant},
+        {"#Wiring", "Power", Kind::Constant},
+        {"#Wiring", "Ground", Kind::Constant},
+        {"#Wiring", "Clock", Kind::Clock},
+        {"#Wiring", "Probe", Kind::Probe},
+        {"#Gates", "AND Gate", Kind::Gate},
+        {"#Gates", "OR Gate", Kind::Gate},
+        {"#Gates", "NAND Gate", Kind::Gate},
+        {"#Gates", "NOR Gate", Kind::Gate},
+        {"#Gates", "XOR Gate", Kind::Gate},
+        {"#Gates", "XNOR Gate", Kind::Gate},
+        {"#Gates", "Odd Parity", Kind::Gate},
+        {"#Gates", "Even Parity", Kind::Gate},
+        {"#Gates", "NOT Gate", Kind::Buffer},
+        {"#Gates", "Buffer", Kind::Buffer},
+        {"#Gates", "Controlled Buffer", Kind::Tristate},
+        {"#Gates", "Controlled Inverter", Kind::Tristate},
+        {"#Plexers", "Multiplexer", Kind::Mux},
+        {"#Arithmetic", "Adder", Kind::Adder},
+        {"#Arithmetic", "Subtractor", Kind::Subtractor},
+        {"#Arithmetic", "Comparator", Kind::Comparator},
+        {"#Memory", "ROM", Kind::Rom},
+        {"#Memory", "Register", Kind::Register},
+        {"#Memory", "D Flip-Flop", Kind::FlipFlop},
+        {"#I/O", "Button", Kind::Button},
+        {"#I/O", "LED", Kind::Led},
+        {"#I/O", "DotMatrix", Kind::DotMatrix},
+        {"#Base", "Text", Kind::Ignored},
+    };
+
+    for (const auto &k : kinds) {
+        if (library == k.library && name == k.name)
+            return k.kind;
+    }
+    throw std::runtime_error("unsupported component " + name);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       gate_ports
+//
+//  Arguments:      c:      An AND, OR, XOR (...) gate
+//
+//  Description:    This function places the output at the component's
+//                  location and spreads the inputs across its back, as
+//                  Logisim's AbstractGate.getInputOffset does.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void gate_ports(Component &c)
+{
+    std::string size = c.get("size", "50");
+    int inputs = c.number("inputs", 5);
+    int width = c.number("width", 1);
+    int length = size == "narrow" ? 30 : size == "medium" ? 50 : size == "wide" ? 70 : atoi(size.c_str());
+    int start, step, lowerEven;
+    Direction facing = direction(c.get("facing", "east"));
+
+    if (c.name == "XOR Gate" || c.name == "XNOR Gate")
+        length += 10;
+    if (c.name == "NAND Gate" || c.name == "NOR Gate" || c.name == "XNOR Gate")
+        length += 10;
+
+    if (inputs <= 3) {
+        if (length < 40) {
+            start = -5, step = 10, lowerEven = 10;
+        } else if (length < 60 || inputs <= 2) {
+            start = -10, step = 20, lowerEven = 20;
+        } else {
+            start = -15, step = 30, lowerEven = 30;
+        }
+    } else if (inputs == 4 && length >= 60) {
+        start = -5, step = 20, lowerEven = 0;
+    } else {
+        start = -5, step = 10, lowerEven = 10;
+    }
+
+    c.ports.push_back({c.loc, width});
+    for (int i = 0; i < inputs; i++) {
+        int dy, dx = length;
+
+        if (inputs & 1) {
+            dy = start * (inputs - 1) + step * i;
+        } else {
+            dy = start * inputs + step * i;
+            if (i >= inputs / 2)
+                dy += lowerEven;
+        }
+        if (c.get("negate" + std::to_string(i), "false") == "true")
+            dx += 10;
+
+        Point offset = facing == NORTH ? Point{dy, dx} : facing == SOUTH ? Point{dy, -dx}
+            : facing == WEST ? Point{dx, dy} : Point{-dx, dy};
+        c.ports.push_back({{c.loc.x + offset.x, c.loc.y + offset.y}, width});
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       splitter_ports
+//
+//  Arguments:      c:      A splitter
+//
+//  Description:    This function places the combined end at the location
+//                  and the split ends beside it, as SplitterParameters
+//                  does. Each split end is as wide as the number of bits
+//                  the "bitN" attributes send to it; bits without such an
+//                  attribute are shared out in order, as Logisim does.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void splitter_ports(Component &c)
+{
+    int fanout = c.number("fanout", 2);
+    int incoming = c.number("incoming", 2);
+    if (fanout < 1 || incoming < 1)
+        throw std::runtime_error("splitter without ends");
+    std::string appear = c.get("appear", "left");
+    int justify = appear == "center" || appear == "legacy" ? 0 : appear == "right" ? 1 : -1;
+    Direction facing = direction(c.get("facing", "east"));
+    int dx, dy, ddx, ddy;
+
+    if (facing == NORTH || facing == SOUTH) {
+        int m = facing == NORTH ? 1 : -1;
+        dx = justify == 0 ? 10 * ((fanout + 1) / 2 - 1) : m * justify < 0 ? -10 : 10 * fanout;
+        dy = -m * 20;
+        ddx = -10, ddy = 0;
+    } else {
+        int m = facing == WEST ? -1 : 1;
+        dx = m * 20;
+        dy = justify == 0 ? -10 * (fanout / 2) : m * justify > 0 ? 10 : -10 * fanout;
+        ddx = 0, ddy = 10;
+    }
+
+    // Bits per end: the explicit ones, and the default spread for the rest
+    std::vector<int> widths(fanout, 0);
+    int perEnd = incoming / fanout, extra = incoming % fanout, end = -1, left = 0;
+    for (int i = 0; i < incoming; i++) {
+        int defaultEnd;
+
+        if (fanout >= incoming) {
+            defaultEnd = i;
+        } else {
+            if (left == 0) {
+                end++;
+                left = perEnd + (extra > 0);
+                extra -= extra > 0;
+            }
+            defaultEnd = end;
+            left--;
+        }
+
+        std::string bit = c.get("bit" + std::to_string(i), std::to_string(defaultEnd));
+        if (bit != "none") {
+            int e = atoi(bit.c_str());
+            if (e < 0 || e >= fanout)
+                throw std::runtime_error("splitter bit " + std::to_string(i) + " goes to a missing end");
+            widths[e]++;
+        }
+        c.attributes["bit" + std::to_string(i)] = bit;
+    }
+
+    c.ports.push_back({c.loc, incoming});
+    for (int i = 0; i < fanout; i++)
+        c.ports.push_back({{c.loc.x + dx + ddx * i, c.loc.y + dy + ddy * i}, widths[i]});
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mux_ports
+//
+//  Arguments:      c:      A multiplexer
+//
+//  Description:    This function lays out a multiplexer as Logisim's
+//                  Multiplexer.updatePorts does.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void mux_ports(Component &c)
+{
+    int width = c.number("width", 1);
+    int select = c.number("select", 1);
+    int ways = 1 << select;
+    int side = c.get("selloc", "bl") == "tr" ? -1 : 1;
+    Direction facing = direction(c.get("facing", "east"));
+    Point sel;
+
+    c.ports.push_back({c.loc, width});
+    if (ways == 2) {
+        Point end0, end1;
+
+        switch (facing) {
+        case WEST:  end0 = {30, -10}; end1 = {30, 10}; sel = {20, side * 20}; break;
+        case NORTH: end0 = {-10, 30}; end1 = {10, 30}; sel = {side * -20, 20}; break;
+        case SOUTH: end0 = {-10, -30}; end1 = {10, -30}; sel = {side * -20, -20}; break;
+        default:    end0 = {-30, -10}; end1 = {-30, 10}; sel = {-20, side * 20}; break;
+        }
+        c.ports.push_back({{c.loc.x + end0.x, c.loc.y + end0.y}, width});
+        c.ports.push_back({{c.loc.x + end1.x, c.loc.y + end1.y}, width});
+    } else {
+        int dx = -(ways / 2) * 10, ddx = 10, dy = -(ways / 2) * 10, ddy = 10;
+
+        switch (facing) {
+        case WEST:  dx = 40; ddx = 0; sel = {20, side * (dy + 10 * ways)}; break;
+        case NORTH: dy = 40; ddy = 0; sel = {side * dx, 20}; break;
+        case SOUTH: dy = -40; ddy = 0; sel = {side * dx, -20}; break;
+        default:    dx = -40; ddx = 0; sel = {-20, side * (dy + 10 * ways)}; break;
+        }
+        for (int i = 0; i < ways; i++)
+            c.ports.push_back({{c.loc.x + dx + ddx * i, c.loc.y + dy + ddy * i}, width});
+    }
+
+    sel = {c.loc.x + sel.x, c.loc.y + sel.y};
+    c.ports.push_back({sel, select});
+    if (c.get("enable", "true") == "true")
+        c.ports.push_back({translate(sel, facing, 10), 1});
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       place_pins
+//
+//  Arguments:      circuit:    A circuit that other circuits may contain
+//
+//  Description:    This function works out where the ports of an instance
+//                  of the circuit are, the way Logisim's DefaultAppearance
+//                  draws it: each pin goes on the side of the box opposite
+//                  the way it faces (so inputs facing east are on the west
+//                  side), in order along that side, and the instance's
+//                  location is the first port on the east side.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int side_offset(int count, int opposite, int others)
+{
+    int most = std::max(count, opposite);
+    int offset = most <= 1 ? (others == 0 ? 15 : 10) : most == 2 ? 10 : (others == 0 ? 5 : 10);
+
+    return offset + 10 * ((most - count) / 2);
+}
+
+int side_length(int most, int others)
+{
+    return most < 3 ? 30 : others == 0 ? 10 * most : 10 * most + 10;
+}
+
+void place_pins(Circuit &circuit)
+{
+    std::vector<int> side[4];
+
+    for (size_t i = 0; i < circuit.components.size(); i++) {
+        const Component &c = circuit.components[i];
+        if (c.kind == Kind::Pin) {
+            side[reverse(direction(c.get("facing", "east")))].push_back(i);
+        }
+    }
+    for (int d = 0; d < 4; d++) {
+        bool across = d == NORTH || d == SOUTH;
+        std::sort(side[d].begin(), side[d].end(), [&](int a, int b) {
+            Point p = circuit.components[a].loc, q = circuit.components[b].loc;
+            return across ? (p.x != q.x ? p.x < q.x : p.y < q.y) : (p.y != q.y ? p.y < q.y : p.x < q.x);
+        });
+    }
+
+    int north = side[NORTH].size(), south = side[SOUTH].size();
+    int east = side[EAST].size(), west = side[WEST].size();
+    int vertical = std::max(north, south), horizontal = std::max(east, west);
+    int offsNorth = side_offset(north, south, horizontal);
+    int offsSouth = side_offset(south, north, horizontal);
+    int offsEast = side_offset(east, west, vertical);
+    int offsWest = side_offset(west, east, vertical);
+    int width = side_length(vertical, horizontal);
+    int height = side_length(horizontal, vertical);
+    Point anchor = east > 0 ? Point{width, offsEast} : north > 0 ? Point{offsNorth, 0}
+        : west > 0 ? Point{0, offsWest} : south > 0 ? Point{offsSouth, height} : Point{0, 0};
+
+    // Sides in the order DefaultAppearance places them
+    const struct { Direction d; Point first; Point step; } order[] = {
+        {WEST, {0, offsWest}, {0, 10}},
+        {EAST, {width, offsEast}, {0, 10}},
+        {NORTH, {offsNorth, 0}, {10, 0}},
+        {SOUTH, {offsSouth, height}, {10, 0}},
+    };
+    for (const auto &o : order) {
+        for (size_t k = 0; k < side[o.d].size(); k++) {
+            circuit.pins.push_back(side[o.d][k]);
+            circuit.pinOffsets.push_back({o.first.x + o.step.x * (int)k - anchor.x,
+                                          o.first.y + o.step.y * (int)k - anchor.y});
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       place_ports
+//
+//  Arguments:      c:          A component
+//                  project:    The project, for the layout of subcircuits
+//
+//  Description:    This function fills in c.ports in the order circ.h
+//                  gives for its kind.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void place_ports(Component &c, const Project &project)
+{
+    Point at = c.loc;
+    Direction facing = direction(c.get("facing", "east"));
+    auto add = [&](int dx, int dy, int width) {
+        c.ports.push_back({{at.x + dx, at.y + dy}, width});
+    };
+
+    switch (c.kind) {
+    case Kind::Ignored:
+        break;
+
+    case Kind::Pin:
+    case Kind::Tunnel:
+    case Kind::Constant:
+        add(0, 0, c.number("width", 1));
+        break;
+
+    case Kind::Clock:
+    case Kind::Button:
+    case Kind::Led:
+        add(0, 0, 1);
+        break;
+
+    case Kind::Probe:
+        add(0, 0, 0);
+        break;
+
+    case Kind::Splitter:
+        splitter_ports(c);
+        break;
+
+    case Kind::Gate:
+        gate_ports(c);
+        break;
+
+    case Kind::Buffer: {
+        int width = c.number("width", 1);
+        std::string size = c.get("size", "30");
+        int length = c.name == "Buffer" || size == "20" || size == "narrow" ? 20 : 30;
+        c.ports.push_back({at, width});
+        c.ports.push_back({translate(at, reverse(facing), length), width});
+        break;
+    }
+
+    case Kind::Tristate: {
+        int width = c.number("width", 1);
+        int d = c.name == "Controlled Inverter" ? 10 : 0;
+        int right = c.get("control", "right") == "left" ? 10 : -10;
+        c.ports.push_back({at, width});
+        c.ports.push_back({translate(at, reverse(facing), 20 + d), width});
+        c.ports.push_back({translate(at, reverse(facing), 10 + d, right), 1});
+        break;
+    }
+
+    case Kind::Mux:
+        mux_ports(c);
+        break;
+
+    case Kind::Adder:
+    case Kind::Subtractor: {
+        int width = c.number("width", 8);
+        add(0, 0, width);
+        add(-40, -10, width);
+        add(-40, 10, width);
+        add(-20, -20, 1);
+        add(-20, 20, 1);
+        break;
+    }
+
+    case Kind::Comparator: {
+        int width = c.number("width", 8);
+        add(-40, -10, width);
+        add(-40, 10, width);
+        add(0, -10, 1);
+        add(0, 0, 1);
+        add(0, 10, 1);
+        break;
+    }
+
+    case Kind::Rom:
+        add(0, 0, c.number("dataWidth", 8));
+        add(-140, 0, c.number("addrWidth", 8));
+        add(-90, 40, 1);
+        break;
+
+    case Kind::Register: {
+        int width = c.number("width", 8);
+        add(0, 0, width);
+        add(-30, 0, width);
+        add(-20, 20, 1);
+        add(-10, 20, 1);
+        add(-30, 10, 1);
+        break;
+    }
+
+    case Kind::FlipFlop:
+        add(-40, 20, 1);
+        add(-40, 0, 1);
+        add(0, 0, 1);
+        add(0, 20, 1);
+        add(-10, 30, 1);
+        add(-30, 30, 1);
+        break;
+
+    case Kind::DotMatrix: {
+        int columns = c.number("matrixcols", 5), rows = c.number("matrixrows", 7);
+        std::string input = c.get("inputtype", "column");
+        if (input == "column") {
+            for (int i = 0; i < columns; i++)
+                add(10 * i, 0, rows);
+        } else if (input == "row") {
+            for (int i = 0; i < rows; i++)
+                add(0, 10 * i, columns);
+        } else {
+            throw std::runtime_error("unsupported dot matrix input type " + input);
+        }
+        break;
+    }
+
+    case Kind::Subcircuit: {
+        const Circuit *sub = project.find(c.name);
+        for (size_t i = 0; i < sub->pins.size(); i++) {
+            Point offset = rotate(sub->pinOffsets[i], facing);
+            add(offset.x, offset.y, sub->components[sub->pins[i]].number("width", 1));
+        }
+        break;
+    }
+    }
+}
+
+} // namespace
+
+
+
+std::string to_string(Point p)
+{
+    return "(" + std::to_string(p.x) + "," + std::to_string(p.y) + ")";
+}
+
+std::string Component::get(const std::string &key, const std::string &otherwise) const
+{
+    auto found = attributes.find(key);
+
+    return found == attributes.end() ? otherwise : found->second;
+}
+
+long Component::number(const std::string &key, long otherwise) const
+{
+    auto found = attributes.find(key);
+
+    return found == attributes.end() ? otherwise : strtol(found->second.c_str(), nullptr, 0);
+}
+
+const Circuit *Project::find(const std::string &name) const
+{
+    for (const Circuit &c : circuits) {
+        if (c.name == name)
+            return &c;
+    }
+    return nullptr;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       read_project
+//
+//  Arguments:      path:   The .circ file
+//
+//  Returns:        The project with the ports of every component placed
+//
+//  Description:    This function reads the circuits of a Logisim project.
+//                  Components come from the libraries the file declares
+//                  with <lib>, or are subcircuits when they name no library.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Project read_project(const std::string &path)
+{
+    XmlElement root = read_xml(path);
+    std::map<std::string, std::string> libraries;
+    Project project;
+
+    if (root.name != "project")
+        throw std::runtime_error("not a Logisim project");
+    project.strictGates = false;
+
+    for (const XmlElement &e : root.children) {
+        if (e.name == "lib" && e.attribute("name") && e.attribute("desc")) {
+            libraries[*e.attribute("name")] = *e.attribute("desc");
+        } else if (e.name == "main" && e.attribute("name")) {
+            project.main = *e.attribute("name");
+        } else if (e.name == "options") {
+            for (const XmlElement &a : e.children) {
+                if (a.attribute("name") && *a.attribute("name") == "gateUndefined")
+                    project.strictGates = a.attribute("val") && *a.attribute("val") == "error";
+            }
+        } else if (e.name == "circuit") {
+            Circuit circuit;
+            circuit.name = e.attribute("name") ? *e.attribute("name") : "";
+            project.circuits.push_back(circuit);
+        }
+    }
+
+    // Read the circuits once their names are all known, since a circuit
+    // can contain one that is defined after it
+    size_t index = 0;
+    for (const XmlElement &e : root.children) {
+        if (e.name != "circuit")
+            continue;
+        Circuit &circuit = project.circuits[index++];
+
+        for (const XmlElement &child : e.children) {
+            if (child.name == "appear")
+                throw std::runtime_error("circuit " + circuit.name + ": custom appearances are not supported");
+
+            if (child.name == "wire") {
+                const std::string *from = child.attribute("from"), *to = child.attribute("to");
+                if (from == nullptr || to == nullptr)
+                    throw std::runtime_error("circuit " + circuit.name + ": wire without ends");
+                circuit.wires.push_back({parse_point(*from), parse_point(*to)});
+                continue;
+            }
+            if (child.name != "comp")
+                continue;
+
+            Component c;
+            const std::string *lib = child.attribute("lib"), *name = child.attribute("name"), *loc = child.attribute("loc");
+            if (name == nullptr || loc == nullptr)
+                throw std::runtime_error("circuit " + circuit.name + ": component without a name or location");
+            c.name = *name;
+            c.loc = parse_point(*loc);
+            for (const XmlElement &a : child.children) {
+                if (a.name == "a" && a.attribute("name"))
+                    c.attributes[*a.attribute("name")] = a.attribute("val") ? *a.attribute("val") : a.text;
+            }
+
+            try {
+                if (lib == nullptr) {
+                    if (project.find(c.name) == nullptr)
+                        throw std::runtime_error("unknown circuit " + c.name);
+                    c.kind = Kind::Subcircuit;
+                } else {
+                    c.kind = kind_of(libraries[*lib], c.name);
+                }
+            } catch (const std::runtime_error &error) {
+                throw std::runtime_error("circuit " + circuit.name + ": " + error.what() + " at " + to_string(c.loc));
+            }
+            circuit.components.push_back(c);
+        }
+    }
+
+    if (project.find(project.main) == nullptr)
+        throw std::runtime_error("no main circuit");
+
+    for (Circuit &circuit : project.circuits)
+        place_pins(circuit);
+    for (Circuit &circuit : project.circuits) {
+        for (Component &c : circuit.components) {
+            try {
+                place_ports(c, project);
+            } catch (const std::runtime_error &error) {
+                throw std::runtime_error("circuit " + circuit.name + ": " + error.what() + " at " + to_string(c.loc));
+            }
+        }
+    }
+    return project;
+}
+
+std::string label_of(const Circuit &circuit, const Component &component)
+{
+    std::string label = component.get("label", "");
+    long best = (long)LABEL_DISTANCE * LABEL_DISTANCE + 1;
+
+    if (!label.empty())
+        return label;
+
+    for (const Component &text : circuit.components) {
+        if (text.name != "Text" || text.get("text", "").empty())
+            continue;
+
+        long dx = text.loc.x - component.loc.x, dy = text.loc.y - component.loc.y;
+        if (dx * dx + dy * dy < best) {
+            best = dx * dx + dy * dy;
+            label = text.get("text", "");
+        }
+    }
+    return label;
+}
@@ -0,0 +1,116 @@
+// Reading Logisim 2.7 project files (.circ). A project is a set of circuits,
+// and a circuit is a set of wire segments and components placed on a grid.
+// Logisim does not store where a component's ports are, only where the
+// component is and its attributes, so this module also knows the port
+// layout of every supported component, and of subcircuits drawn with
+// Logisim's default appearance.
+
+#ifndef CIRC_H
+#define CIRC_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Point
+{
+    int x, y;
+};
+
+inline bool operator<(Point a, Point b)
+{
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+inline bool operator==(Point a, Point b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+std::string to_string(Point p);
+
+// What a component is, as far as simulation goes. The comment after each
+// kind lists its ports in the order they appear in Component::ports.
+enum class Kind
+{
+    Ignored,        // Text: none
+    Pin,            // the pin
+    Tunnel,         // the tunnel
+    Splitter,       // combined end, then each split end
+    Constant,       // the output (also Power and Ground)
+    Clock,          // the output
+    Probe,          // the input; its width is the width of the wire
+    Gate,           // output, then each input (AND, OR, XOR, parity, ...)
+    Buffer,         // output, input (NOT gate and Buffer)
+    Tristate,       // output, input, control (Controlled Buffer/Inverter)
+    Mux,            // output, each data input, select, enable if present
+    Adder,          // output, a, b, carry in, carry out
+    Subtractor,     // output, a, b, borrow in, borrow out
+    Comparator,     // a, b, greater, equal, less
+    Rom,            // data, address, chip select
+    Register,       // output, input, clock, clear, enable
+    FlipFlop,       // data, clock, Q, not Q, reset, preset (D flip-flop)
+    Button,         // the output
+    Led,            // the input
+    DotMatrix,      // one per column (or row) of dots
+    Subcircuit      // one per pin of the circuit, as in Circuit::pins
+};
+
+struct Port
+{
+    Point at;
+    int width;      // 0 for a port that takes the width of its wire
+};
+
+struct Component
+{
+    Kind kind;
+    std::string name;       // "AND Gate", "Pin", or the name of a subcircuit
+    Point loc;
+    std::map<std::string, std::string> attributes;
+    std::vector<Port> ports;
+
+    // An attribute as written in the file, or a default
+    std::string get(const std::string &key, const std::string &otherwise) const;
+
+    // A decimal or 0x-prefixed hexadecimal attribute, or a default
+    long number(const std::string &key, long otherwise) const;
+};
+
+struct Wire
+{
+    Point from, to;
+};
+
+struct Circuit
+{
+    std::string name;
+    std::vector<Wire> wires;
+    std::vector<Component> components;
+
+    // The circuit's Pin components, in the order of the ports of every
+    // instance of it, and where those ports are relative to an instance
+    // that faces east
+    std::vector<int> pins;
+    std::vector<Point> pinOffsets;
+};
+
+struct Project
+{
+    std::string main;       // The circuit Logisim opens first
+    bool strictGates;       // Floating gate inputs are errors, not ignored
+    std::vector<Circuit> circuits;
+
+    const Circuit *find(const std::string &name) const;
+};
+
+// Throws std::runtime_error when the file cannot be read, is not a
+// Logisim project, or uses components that are not supported
+Project read_project(const std::string &path);
+
+// The name of a component: its label, or else the nearest text within a
+// few grid squares (the templates label their pins with separate text), or
+// else an empty string
+std::string label_of(const Circuit &circuit, const Component &component);
+
+#endif
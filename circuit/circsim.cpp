@@ -0,0 +1,462 @@
+// This host tool simulates a circuit of a Logisim project without Logisim.
+// It flattens the circuit and its subcircuits into a netlist and evaluates
+// it for 64 input vectors at a time (see simulate.h), so a truth table over
+// every combination of its inputs takes milliseconds. The columns are the
+// circuit's input pins and buttons, then its output pins, probes, LEDs and
+// dot matrix columns, then its registers and flip-flops, each in the order
+// they are drawn (top to bottom, then left to right). Pins without a label
+// take the name of the text next to them.
+//
+// With -e the outputs are checked against a table of expected values
+// instead, written in the same form as the truth table: a header line of
+// signal names, then one row per line. Values are binary, or hexadecimal
+// after "0x", and may contain X (error), Z (floating) and - (any value);
+// "-" alone matches anything. Inputs that are "-" or missing from the
+// header are tried with every value. Lines starting with # are comments.
+//
+// With -n the clocks tick that many times, after the registers and
+// flip-flops are cleared, before the outputs are read.
+//
+// Usage:  circsim [-c circuit] [-n cycles] [-e expected.txt] [-v] file.circ
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "circ.h"
+#include "netlist.h"
+#include "simulate.h"
+
+// Most input bits for a full truth table (16M rows)
+#define MAX_TABLE_BITS  24
+
+// Most rows one line of an expected table may stand for
+#define MAX_ROW_BITS    20
+
+// Mismatches printed in full before only counting the rest
+#define MAX_REPORTED    20
+
+namespace {
+
+// A column of a table: which signal, and where its bits are
+struct Column
+{
+    const Signal *signal;
+    bool input;
+    int first;          // For an input, its first bit as in Node::arg
+};
+
+std::vector<Column> columns_of(const Netlist &netlist)
+{
+    std::vector<Column> columns;
+    int first = 0;
+
+    for (const Signal &s : netlist.inputs) {
+        columns.push_back({&s, true, first});
+        first += s.bits.size();
+    }
+    for (const Signal &s : netlist.outputs)
+        columns.push_back({&s, false, 0});
+    for (const Signal &s : netlist.states)
+        columns.push_back({&s, false, 0});
+    return columns;
+}
+
+char bit_char(uint64_t h, uint64_t l, int lane)
+{
+    int v = (h >> lane & 1) | (l >> lane & 1) << 1;
+
+    return "Z10X"[v];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       format
+//
+//  Arguments:      sim:        The simulator
+//                  signal:     A signal
+//                  lane:       Which of the 64 vectors
+//
+//  Returns:        The signal's value: in binary when it is up to 8 bits
+//                  wide, or else in hexadecimal, where a digit with an
+//                  error bit shows as X and one with a floating bit as Z
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::string format(const Simulator &sim, const Signal &signal, int lane)
+{
+    int width = signal.bits.size();
+    std::string text;
+
+    if (width <= 8) {
+        for (int k = width - 1; k >= 0; k--)
+            text += bit_char(sim.hi(signal.bits[k]), sim.lo(signal.bits[k]), lane);
+        return text;
+    }
+
+    text = "0x";
+    for (int d = (width + 3) / 4 - 1; d >= 0; d--) {
+        int digit = 0;
+        bool error = false, floating = false;
+        for (int k = 4 * d; k < 4 * d + 4 && k < width; k++) {
+            char c = bit_char(sim.hi(signal.bits[k]), sim.lo(signal.bits[k]), lane);
+            digit |= (c == '1') << (k - 4 * d);
+            error |= c == 'X';
+            floating |= c == 'Z';
+        }
+        text += error ? 'X' : floating ? 'Z' : "0123456789abcdef"[digit];
+    }
+    return text;
+}
+
+int text_width(const Signal &signal)
+{
+    int width = signal.bits.size();
+
+    return width <= 8 ? width : 2 + (width + 3) / 4;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       print_table
+//
+//  Arguments:      netlist:    The flattened circuit
+//                  sim:        Its simulator
+//                  cycles:     Clock cycles before reading the outputs
+//
+//  Returns:        The number of rows
+//
+//  Description:    This function prints the outputs for every combination
+//                  of the inputs, the first column changing slowest. Lane
+//                  i of block b is row 64b + i, so the low 6 bits of the
+//                  row number are the same patterns in every block.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t print_table(const Netlist &netlist, Simulator &sim, int cycles)
+{
+    static const uint64_t patterns[6] = {
+        0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+        0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+    };
+    std::vector<Column> columns = columns_of(netlist);
+    int bits = netlist.inputBits;
+    uint64_t rows = 1ull << bits;
+
+    if (bits > MAX_TABLE_BITS)
+        throw std::runtime_error(std::to_string(bits) + " input bits are too many for a full table; use -e");
+
+    std::vector<int> widths;
+    std::string line;
+    for (size_t i = 0; i < columns.size(); i++) {
+        const Column &c = columns[i];
+        widths.push_back(std::max<int>(c.signal->name.size(), text_width(*c.signal)));
+        if (i > 0)
+            line += c.input != columns[i - 1].input ? " | " : " ";
+        line += c.signal->name + std::string(widths[i] - c.signal->name.size(), ' ');
+    }
+    printf("%s\n", line.substr(0, line.find_last_not_of(' ') + 1).c_str());
+
+    for (uint64_t block = 0; block * LANES < rows; block++) {
+        for (const Column &c : columns) {
+            if (!c.input)
+                continue;
+            int width = c.signal->bits.size();
+            for (int j = 0; j < width; j++) {
+                int p = bits - c.first - width + j;
+                sim.set_input(c.first + j, p < 6 ? patterns[p] : (block >> (p - 6) & 1) ? ~0ull : 0);
+            }
+        }
+        sim.reset();
+        for (int i = 0; i < cycles; i++)
+            sim.cycle();
+
+        for (int lane = 0; lane < LANES && block * LANES + lane < rows; lane++) {
+            line.clear();
+            for (size_t i = 0; i < columns.size(); i++) {
+                std::string value = format(sim, *columns[i].signal, lane);
+                if (i > 0)
+                    line += columns[i].input != columns[i - 1].input ? " | " : " ";
+                line += value + std::string(widths[i] - value.size(), ' ');
+            }
+            printf("%s\n", line.substr(0, line.find_last_not_of(' ') + 1).c_str());
+        }
+    }
+    return rows;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       parse_value
+//
+//  Arguments:      token:  A value from an expected table
+//                  width:  The width of its signal
+//
+//  Returns:        One of 0, 1, X, Z or - per bit, least significant first
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::string parse_value(const std::string &token, int width)
+{
+    std::string bits;
+
+    if (token == "-")
+        return std::string(width, '-');
+
+    if (token.compare(0, 2, "0x") == 0) {
+        for (size_t i = token.size(); i-- > 2;) {
+            char c = toupper(token[i]);
+            const char *hex = "0123456789ABCDEF";
+            const char *digit = strchr(hex, c);
+            for (int k = 0; k < 4; k++)
+                bits += digit != nullptr && c != '\0' ? "01"[(digit - hex) >> k & 1] : c;
+        }
+        for (size_t k = width; k < bits.size(); k++) {
+            if (bits[k] != '0')
+                throw std::runtime_error("value " + token + " is wider than " + std::to_string(width) + " bits");
+        }
+        if ((int)bits.size() < width)
+            bits += std::string(width - bits.size(), '0');
+        bits.resize(width);
+    } else {
+        if ((int)token.size() != width)
+            throw std::runtime_error("value " + token + " is not " + std::to_string(width) + " bits");
+        for (size_t i = token.size(); i-- > 0;)
+            bits += toupper(token[i]);
+    }
+
+    for (char c : bits) {
+        if (strchr("01XZ-", c) == nullptr)
+            throw std::runtime_error("bad value " + token);
+    }
+    return bits;
+}
+
+// A vector to check: the inputs, and the line of the table it came from
+struct Check
+{
+    std::vector<uint8_t> inputs;
+    size_t row;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       check_table
+//
+//  Arguments:      netlist:    The flattened circuit
+//                  sim:        Its simulator
+//                  cycles:     Clock cycles before reading the outputs
+//                  path:       The table of expected values
+//                  checked:    Set to the number of vectors simulated
+//
+//  Returns:        The number of vectors with wrong outputs
+//
+//  Description:    This function turns each row of the table into the
+//                  input vectors it stands for, simulates them 64 at a
+//                  time and compares the outputs with the row.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t check_table(const Netlist &netlist, Simulator &sim, int cycles, const std::string &path, uint64_t &checked)
+{
+    std::ifstream file(path);
+    std::vector<Column> all = columns_of(netlist), columns;
+    std::vector<std::vector<std::string>> rows;
+    std::vector<int> lines;
+    std::string line;
+    uint64_t wrong = 0;
+
+    if (!file)
+        throw std::runtime_error(path + ": cannot open file");
+
+    for (int number = 1; std::getline(file, line); number++) {
+        std::istringstream words(line);
+        std::vector<std::string> tokens;
+        std::string word;
+
+        while (words >> word) {
+            if (word != "|")
+                tokens.push_back(word);
+        }
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+
+        if (columns.empty()) {
+            for (const std::string &name : tokens) {
+                size_t i = 0;
+                while (i < all.size() && all[i].signal->name != name)
+                    i++;
+                if (i == all.size())
+                    throw std::runtime_error(path + ":" + std::to_string(number) + ": no signal named " + name);
+                columns.push_back(all[i]);
+            }
+            continue;
+        }
+
+        if (tokens.size() != columns.size())
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": expected " + std::to_string(columns.size()) + " values");
+        std::vector<std::string> row;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            try {
+                row.push_back(parse_value(tokens[i], columns[i].signal->bits.size()));
+            } catch (const std::runtime_error &error) {
+                throw std::runtime_error(path + ":" + std::to_string(number) + ": " + error.what());
+            }
+            if (columns[i].input && row.back().find_first_not_of("01-") != std::string::npos)
+                throw std::runtime_error(path + ":" + std::to_string(number) + ": inputs can only be 0, 1 or -");
+        }
+        rows.push_back(row);
+        lines.push_back(number);
+    }
+
+    // Simulates the vectors gathered so far and compares their outputs
+    std::vector<Check> batch;
+    auto run = [&]() {
+        for (int k = 0; k < netlist.inputBits; k++) {
+            uint64_t word = 0;
+            for (size_t lane = 0; lane < batch.size(); lane++)
+                word |= (uint64_t)batch[lane].inputs[k] << lane;
+            sim.set_input(k, word);
+        }
+        sim.reset();
+        for (int i = 0; i < cycles; i++)
+            sim.cycle();
+
+        for (size_t lane = 0; lane < batch.size(); lane++) {
+            const std::vector<std::string> &row = rows[batch[lane].row];
+            std::string report;
+
+            for (size_t i = 0; i < columns.size(); i++) {
+                const Signal &s = *columns[i].signal;
+                if (columns[i].input)
+                    continue;
+                for (size_t k = 0; k < s.bits.size(); k++) {
+                    char want = row[i][k];
+                    if (want != '-' && want != bit_char(sim.hi(s.bits[k]), sim.lo(s.bits[k]), lane)) {
+                        report += " " + s.name + "=" + format(sim, s, lane);
+                        break;
+                    }
+                }
+            }
+            if (report.empty())
+                continue;
+
+            if (++wrong <= MAX_REPORTED) {
+                std::string inputs;
+                for (const Column &c : all) {
+                    if (c.input)
+                        inputs += " " + c.signal->name + "=" + format(sim, *c.signal, lane);
+                }
+                printf("%s:%d:%s:%s\n", path.c_str(), lines[batch[lane].row], inputs.c_str(), report.c_str());
+            }
+        }
+        checked += batch.size();
+        batch.clear();
+    };
+
+    for (size_t r = 0; r < rows.size(); r++) {
+        std::vector<uint8_t> inputs(netlist.inputBits, 0);
+        std::vector<int> open;
+
+        // Inputs not in the table are open, as are bits given as -
+        std::vector<bool> given(netlist.inputBits, false);
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (!columns[i].input)
+                continue;
+            for (size_t k = 0; k < rows[r][i].size(); k++) {
+                int bit = columns[i].first + k;
+                given[bit] = rows[r][i][k] != '-';
+                inputs[bit] = rows[r][i][k] == '1';
+            }
+        }
+        for (int k = 0; k < netlist.inputBits; k++) {
+            if (!given[k])
+                open.push_back(k);
+        }
+        if (open.size() > MAX_ROW_BITS)
+            throw std::runtime_error(path + ":" + std::to_string(lines[r]) + ": too many inputs left open");
+
+        for (uint64_t combination = 0; combination < 1ull << open.size(); combination++) {
+            for (size_t k = 0; k < open.size(); k++)
+                inputs[open[k]] = combination >> k & 1;
+            batch.push_back({inputs, r});
+            if (batch.size() == LANES)
+                run();
+        }
+    }
+    if (!batch.empty())
+        run();
+
+    if (wrong > MAX_REPORTED)
+        printf("... and %llu more\n", (unsigned long long)(wrong - MAX_REPORTED));
+    return wrong;
+}
+
+} // namespace
+
+
+
+int main(int argc, char *argv[])
+{
+    std::string top, expected;
+    int cycles = 0, option;
+    bool verbose = false;
+
+    while ((option = getopt(argc, argv, "c:n:e:v")) != -1) {
+        switch (option) {
+        case 'c': top = optarg; break;
+        case 'n': cycles = atoi(optarg); break;
+        case 'e': expected = optarg; break;
+        case 'v': verbose = true; break;
+        default:  optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-c circuit] [-n cycles] [-e expected.txt] [-v] file.circ\n", argv[0]);
+        return 2;
+    }
+
+    try {
+        Project project = read_project(argv[optind]);
+        if (top.empty())
+            top = project.main;
+
+        Netlist netlist = build_netlist(project, top);
+        Simulator sim(netlist);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t vectors = 0, wrong = 0;
+
+        if (expected.empty())
+            vectors = print_table(netlist, sim, cycles);
+        else
+            wrong = check_table(netlist, sim, cycles, expected, vectors);
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!expected.empty())
+            printf("%llu vectors checked, %llu wrong\n", (unsigned long long)vectors, (unsigned long long)wrong);
+        if (verbose) {
+            fprintf(stderr, "%s: %d nets, %zu nodes, %d levels, %zu latches\n", top.c_str(),
+                    netlist.nets, netlist.nodes.size(), sim.levels().depth, netlist.latches.size());
+            fprintf(stderr, "%llu vectors in %.3f ms\n", (unsigned long long)vectors, ms);
+        }
+        return wrong > 0;
+    } catch (const std::runtime_error &error) {
+        fprintf(stderr, "%s: %s\n", argv[optind], error.what());
+        return 2;
+    }
+}
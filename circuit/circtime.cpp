@@ -0,0 +1,636 @@
+// This host tool estimates how fast a circuit of a Logisim project could be
+// clocked. It flattens the circuit like circsim does, gives every component
+// a propagation delay, and works out when each net settles after a clock
+// edge: the arrival time. Paths start at input pins, constants and the
+// outputs of registers and flip-flops, and end at output pins, probes, LEDs
+// and dot matrices, and at the inputs of registers and flip-flops. The
+// longest of them is the critical path, and sets the shortest clock period.
+//
+// The report lists the components and the fan-out of the nets, the
+// critical path step by step, and the slack of every end point: how much
+// sooner than the clock period its inputs settle. The period is the
+// critical path's length unless -t gives one. With -g the netlist is also
+// written as a Graphviz DOT graph, one node per component, with the
+// critical path in red and any combinational loop in orange.
+//
+// The delays are in gate delays by default (see DEFAULT_DELAYS). A file
+// given with -d changes them, one component per line, e.g. "XOR Gate 1.5";
+// lines starting with # are comments. Adders, subtractors and comparators
+// are rippled through: their delay is per bit.
+//
+// Usage:  circtime [-c circuit] [-d delays.txt] [-t period] [-g graph.dot] file.circ
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "circ.h"
+#include "netlist.h"
+
+// Nets listed as having the highest fan-out
+#define MAX_FANOUT_LISTED   5
+
+namespace {
+
+const std::pair<const char *, double> DEFAULT_DELAYS[] = {
+    {"Pin", 0},
+    {"Constant", 0},
+    {"Power", 0},
+    {"Ground", 0},
+    {"Clock", 0},
+    {"NOT Gate", 1},
+    {"Buffer", 1},
+    {"AND Gate", 1},
+    {"OR Gate", 1},
+    {"NAND Gate", 1},
+    {"NOR Gate", 1},
+    {"XOR Gate", 2},
+    {"XNOR Gate", 2},
+    {"Odd Parity", 2},
+    {"Even Parity", 2},
+    {"Controlled Buffer", 1},
+    {"Controlled Inverter", 1},
+    {"Multiplexer", 2},
+    {"Adder", 2},           // Per bit of carry
+    {"Subtractor", 2},
+    {"Comparator", 1},      // Per bit compared
+    {"ROM", 3},
+    {"Register", 1},        // From the clock edge to the output
+    {"D Flip-Flop", 1},
+};
+
+typedef std::map<std::string, double> Delays;
+
+// When the nets settle, and for each the node and input net that settle it
+// last (-1 for a net that starts a path)
+struct Timing
+{
+    std::vector<double> arrival;
+    std::vector<int> via;
+    std::vector<int> from;
+    std::vector<bool> timed;    // Clear for nets on or after a loop
+};
+
+// Where paths end: an output, or the inputs of a register or flip-flop
+struct Endpoint
+{
+    std::string name;
+    std::vector<int> nets;
+    int part;               // For a latch, its part; -1 for an output
+    int output;             // For an output, its index in Netlist::outputs
+    double arrival = 0;
+    int last = -1;          // The net that settles last
+    bool timed = true;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       read_delays
+//
+//  Arguments:      path:       A file of component names and delays
+//                  delays:     The delays to change
+//
+//  Description:    This function reads lines of the form "<name> <delay>",
+//                  where the name is a component's as Logisim shows it and
+//                  may contain spaces. Unknown names are rejected, since
+//                  they would otherwise be silently ignored.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void read_delays(const std::string &path, Delays &delays)
+{
+    std::ifstream file(path);
+    std::string line;
+    int number = 0;
+
+    if (!file)
+        throw std::runtime_error("cannot open " + path);
+    while (std::getline(file, line)) {
+        number++;
+        size_t end = line.find_last_not_of(" \t\r");
+        if (end == std::string::npos || line[line.find_first_not_of(" \t")] == '#')
+            continue;
+        line.erase(end + 1);
+
+        size_t space = line.find_last_of(" \t");
+        size_t start = line.find_first_not_of(" \t");
+        std::string name = space == std::string::npos ? "" : line.substr(start, space - start);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        char *rest;
+        double delay = space == std::string::npos ? 0 : strtod(line.c_str() + space + 1, &rest);
+
+        std::string where = path + ":" + std::to_string(number) + ": ";
+        if (name.empty() || *rest != '\0' || delay < 0)
+            throw std::runtime_error(where + "expected a component name and a delay");
+        if (delays.find(name) == delays.end())
+            throw std::runtime_error(where + "unknown component " + name);
+        delays[name] = delay;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arc_delay
+//
+//  Arguments:      node:   A node
+//                  i:      One of its inputs
+//                  j:      One of its outputs
+//                  delay:  The delay of its component
+//
+//  Returns:        How long a change takes to get from the input to the
+//                  output, or -1 if the output does not depend on it
+//
+//  Description:    Adders and subtractors pass their carry up one bit at a
+//                  time, and comparators decide from the top bit down, so
+//                  a bit's delay depends on how many bits it ripples
+//                  through. A multiplexer's data bit only reaches the
+//                  output bit with the same number.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double arc_delay(const Node &node, int i, int j, double delay)
+{
+    int w = node.width;
+
+    switch (node.op) {
+    case Op::Add: {
+        int bit = i == 2 * w ? 0 : i % w;
+        int last = j == w ? w - 1 : j;
+        return bit <= last ? delay * (last - bit + 1) : -1;
+    }
+
+    case Op::Compare:
+        return delay * (w - i % w);
+
+    case Op::Mux:
+        if (i < (1 << node.arg) * w && i % w != j)
+            return -1;
+        return delay;
+
+    default:
+        return delay;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       analyze
+//
+//  Arguments:      netlist:    The netlist
+//                  levels:     Its nodes in order, from levelize
+//                  delays:     The delay of each component
+//
+//  Returns:        The arrival time of every net. Nodes without inputs
+//                  (pins, constants, and the outputs of registers and
+//                  flip-flops) start paths at their own delay. Nets that
+//                  nothing drives are left at 0, and those on or after a
+//                  combinational loop are marked as not timed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Timing analyze(const Netlist &netlist, const Levels &levels, const Delays &delays)
+{
+    Timing timing;
+
+    timing.arrival.assign(netlist.nets, 0);
+    timing.via.assign(netlist.nets, -1);
+    timing.from.assign(netlist.nets, -1);
+    timing.timed.assign(netlist.nets, true);
+
+    std::vector<bool> ordered(netlist.nodes.size(), false);
+    for (int n : levels.order)
+        ordered[n] = true;
+    for (size_t n = 0; n < netlist.nodes.size(); n++) {
+        for (int b : netlist.nodes[n].out) {
+            if (b >= 0 && !ordered[n])
+                timing.timed[b] = false;
+        }
+    }
+
+    for (int n : levels.order) {
+        const Node &node = netlist.nodes[n];
+        double delay = delays.at(netlist.parts[node.part].name);
+
+        for (size_t j = 0; j < node.out.size(); j++) {
+            int out = node.out[j];
+            double latest = delay;
+            int from = -1;
+
+            if (out < 0)
+                continue;
+            for (size_t i = 0; i < node.in.size(); i++) {
+                int in = node.in[i];
+                double d = in < 0 ? -1 : arc_delay(node, i, j, delay);
+                if (d >= 0 && (from < 0 || timing.arrival[in] + d > latest)) {
+                    latest = timing.arrival[in] + d;
+                    from = in;
+                }
+            }
+            if (timing.via[out] < 0 || latest > timing.arrival[out]) {
+                timing.arrival[out] = latest;
+                timing.via[out] = n;
+                timing.from[out] = from;
+            }
+        }
+    }
+    return timing;
+}
+
+std::vector<Endpoint> endpoints_of(const Netlist &netlist, const std::vector<std::vector<int>> &drivers)
+{
+    std::vector<Endpoint> endpoints;
+
+    for (size_t i = 0; i < netlist.outputs.size(); i++) {
+        const Signal &s = netlist.outputs[i];
+        endpoints.push_back({s.name, s.bits, -1, (int)i});
+    }
+
+    // Latches are named after their state signals, which are driven by
+    // State nodes that share the latch's first state bit
+    std::map<int, std::string> names;
+    for (const Signal &s : netlist.states) {
+        for (int d : drivers[s.bits[0]]) {
+            if (netlist.nodes[d].op == Op::State)
+                names[netlist.nodes[d].arg] = s.name;
+        }
+    }
+    for (const Latch &latch : netlist.latches) {
+        Endpoint e = {names[latch.state], latch.d, latch.part, -1};
+        for (int b : {latch.enable, latch.clear, latch.preset}) {
+            if (b >= 0)
+                e.nets.push_back(b);
+        }
+        endpoints.push_back(e);
+    }
+    return endpoints;
+}
+
+// The part that drives a net, with the bit number for a node with several
+// outputs, e.g. "main/Adder(400,200)[3]"
+std::string net_name(const Netlist &netlist, const std::vector<std::vector<int>> &drivers, int net)
+{
+    if (drivers[net].empty())
+        return "(undriven net " + std::to_string(net) + ")";
+
+    const Node &node = netlist.nodes[drivers[net][0]];
+    std::string name = netlist.parts[node.part].path;
+    if (node.out.size() > 1) {
+        size_t k = std::find(node.out.begin(), node.out.end(), net) - node.out.begin();
+        name += "[" + std::to_string(k) + "]";
+    }
+    return name;
+}
+
+// The nets along the path that settles a net last, from where it starts
+std::vector<int> critical_path(const Timing &timing, int net)
+{
+    std::vector<int> path;
+
+    for (; net >= 0; net = timing.from[net])
+        path.push_back(net);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       print_counts
+//
+//  Arguments:      netlist:    The netlist
+//                  drivers:    The nodes driving each net
+//
+//  Description:    This function prints how many of each component the
+//                  flattened circuit has (and how many one-bit nodes they
+//                  make), and the fan-out of the nets: the number of
+//                  component inputs each one drives.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void print_counts(const Netlist &netlist, const std::vector<std::vector<int>> &drivers)
+{
+    std::map<std::string, std::set<int>> parts;
+    std::map<std::string, int> nodes;
+
+    for (const Node &node : netlist.nodes) {
+        const Part &part = netlist.parts[node.part];
+        parts[part.name].insert(node.part);
+        nodes[part.name]++;
+    }
+    printf("Components:\n");
+    for (const auto &p : parts)
+        printf("  %-20s %5zu  (%d nodes)\n", p.first.c_str(), p.second.size(), nodes[p.first]);
+
+    std::vector<int> fanout(netlist.nets, 0);
+    for (const Node &node : netlist.nodes) {
+        for (int b : node.in) {
+            if (b >= 0)
+                fanout[b]++;
+        }
+    }
+    for (const Latch &latch : netlist.latches) {
+        for (int b : latch.d)
+            fanout[b]++;
+        for (int b : {latch.clock, latch.enable, latch.clear, latch.preset}) {
+            if (b >= 0)
+                fanout[b]++;
+        }
+    }
+
+    std::vector<int> nets;
+    int total = 0;
+    for (int b = 0; b < netlist.nets; b++) {
+        if (!drivers[b].empty() && fanout[b] > 0) {
+            nets.push_back(b);
+            total += fanout[b];
+        }
+    }
+    std::stable_sort(nets.begin(), nets.end(), [&](int a, int b) { return fanout[a] > fanout[b]; });
+
+    printf("\nFan-out: %.2f on average over %zu nets\n", nets.empty() ? 0.0 : (double)total / nets.size(), nets.size());
+    for (size_t i = 0; i < nets.size() && i < MAX_FANOUT_LISTED; i++)
+        printf("  %5d  %s\n", fanout[nets[i]], net_name(netlist, drivers, nets[i]).c_str());
+}
+
+std::string quote(const std::string &text)
+{
+    std::string quoted = "\"";
+
+    for (char c : text) {
+        if (c == '\n') {
+            quoted += "\\n";
+            continue;
+        }
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       write_graph
+//
+//  Arguments:      path:       The DOT file to write
+//                  netlist:    The netlist
+//                  levels:     Its order, from levelize
+//                  timing:     Its arrival times
+//                  endpoints:  Where paths end
+//                  critical:   The index of the endpoint of the critical
+//                              path, or -1
+//
+//  Description:    This function writes one graph node per component, with
+//                  its latest arrival time, and one per output, inside a
+//                  cluster for each subcircuit. An edge means that some
+//                  output of a component drives some input of another.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void write_graph(const std::string &path, const Netlist &netlist, const Levels &levels,
+                 const Timing &timing, const std::vector<Endpoint> &endpoints, int critical)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        throw std::runtime_error("cannot create " + path);
+
+    std::vector<double> arrival(netlist.parts.size(), 0);
+    std::vector<bool> used(netlist.parts.size(), false), hot(netlist.parts.size(), false);
+    std::vector<bool> looped(netlist.parts.size(), false);
+    std::set<std::pair<std::string, std::string>> edges, hotEdges;
+    auto id = [](int part) { return "p" + std::to_string(part); };
+
+    for (const Node &node : netlist.nodes) {
+        used[node.part] = true;
+        for (int b : node.out) {
+            if (b >= 0)
+                arrival[node.part] = std::max(arrival[node.part], timing.arrival[b]);
+        }
+    }
+    for (int n : levels.loop)
+        looped[netlist.nodes[n].part] = true;
+
+    // An edge from the driver of every net a component or output reads
+    std::vector<std::vector<int>> drivers = net_drivers(netlist);
+    auto connect = [&](int net, const std::string &to) {
+        if (net < 0)
+            return;
+        for (int d : drivers[net])
+            edges.insert({id(netlist.nodes[d].part), to});
+    };
+    for (const Node &node : netlist.nodes) {
+        for (int b : node.in)
+            connect(b, id(node.part));
+    }
+    for (const Endpoint &e : endpoints) {
+        for (int b : e.nets)
+            connect(b, e.part >= 0 ? id(e.part) : "o" + std::to_string(e.output));
+    }
+
+    if (critical >= 0) {
+        const Endpoint &e = endpoints[critical];
+        std::string last;
+        for (int b : critical_path(timing, e.last)) {
+            if (timing.via[b] < 0)
+                continue;
+            int part = netlist.nodes[timing.via[b]].part;
+            hot[part] = true;
+            if (!last.empty() && last != id(part))
+                hotEdges.insert({last, id(part)});
+            last = id(part);
+        }
+        if (!last.empty())
+            hotEdges.insert({last, e.part >= 0 ? id(e.part) : "o" + std::to_string(e.output)});
+        if (e.part >= 0)
+            hot[e.part] = true;
+    }
+
+    // Subcircuits become clusters, nested as they are in the circuit
+    std::map<std::string, std::vector<int>> members;
+    std::map<std::string, std::set<std::string>> children;
+    for (size_t p = 0; p < netlist.parts.size(); p++) {
+        if (!used[p])
+            continue;
+        const std::string &full = netlist.parts[p].path;
+        size_t slash = full.rfind('/');
+        std::string parent = slash == std::string::npos ? "" : full.substr(0, slash);
+        members[parent].push_back(p);
+        while (!parent.empty()) {
+            slash = parent.rfind('/');
+            std::string above = slash == std::string::npos ? "" : parent.substr(0, slash);
+            children[above].insert(parent);
+            parent = above;
+        }
+    }
+
+    int clusters = 0;
+    std::function<void(const std::string &, int)> emit = [&](const std::string &prefix, int depth) {
+        std::string indent(4 * depth, ' ');
+        for (int p : members[prefix]) {
+            const std::string &full = netlist.parts[p].path;
+            std::string label = full.substr(full.rfind('/') + 1);
+            char time[32];
+            snprintf(time, sizeof time, "%g", arrival[p]);
+            fprintf(file, "%s%s [label=%s%s];\n", indent.c_str(), id(p).c_str(),
+                    quote(label + "\n" + time).c_str(),
+                    looped[p] ? ", color=orange, fontcolor=orange"
+                    : hot[p] ? ", color=red, fontcolor=red, penwidth=2" : "");
+        }
+        for (const std::string &child : children[prefix]) {
+            // The top circuit is the graph itself rather than a cluster
+            bool cluster = child.find('/') != std::string::npos;
+            if (cluster) {
+                fprintf(file, "%ssubgraph cluster%d {\n", indent.c_str(), clusters++);
+                fprintf(file, "%s    label=%s;\n", indent.c_str(), quote(child.substr(child.rfind('/') + 1)).c_str());
+            }
+            emit(child, depth + cluster);
+            if (cluster)
+                fprintf(file, "%s}\n", indent.c_str());
+        }
+    };
+
+    fprintf(file, "digraph circuit {\n    rankdir=LR;\n    node [shape=box, fontsize=10];\n");
+    emit("", 1);
+    for (const Endpoint &e : endpoints) {
+        if (e.part < 0) {
+            char time[32];
+            snprintf(time, sizeof time, "%g", e.arrival);
+            fprintf(file, "    o%d [shape=ellipse, label=%s%s];\n", e.output, quote(e.name + "\n" + time).c_str(),
+                    e.output >= 0 && critical >= 0 && endpoints[critical].output == e.output
+                    ? ", color=red, fontcolor=red, penwidth=2" : "");
+        }
+    }
+    for (const auto &edge : edges) {
+        fprintf(file, "    %s -> %s%s;\n", edge.first.c_str(), edge.second.c_str(),
+                hotEdges.count(edge) ? " [color=red, penwidth=2]" : "");
+    }
+    fprintf(file, "}\n");
+    fclose(file);
+}
+
+} // namespace
+
+
+
+int main(int argc, char *argv[])
+{
+    std::string top, delayFile, graph;
+    double period = -1;
+    int option;
+
+    while ((option = getopt(argc, argv, "c:d:t:g:")) != -1) {
+        switch (option) {
+        case 'c': top = optarg; break;
+        case 'd': delayFile = optarg; break;
+        case 't': period = atof(optarg); break;
+        case 'g': graph = optarg; break;
+        default:  optind = argc + 1; break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-c circuit] [-d delays.txt] [-t period] [-g graph.dot] file.circ\n", argv[0]);
+        return 2;
+    }
+
+    Delays delays(std::begin(DEFAULT_DELAYS), std::end(DEFAULT_DELAYS));
+    try {
+        if (!delayFile.empty())
+            read_delays(delayFile, delays);
+    } catch (const std::runtime_error &error) {
+        fprintf(stderr, "%s\n", error.what());
+        return 2;
+    }
+
+    try {
+        Project project = read_project(argv[optind]);
+        if (top.empty())
+            top = project.main;
+
+        Netlist netlist = build_netlist(project, top);
+        Levels levels = levelize(netlist);
+        std::vector<std::vector<int>> drivers = net_drivers(netlist);
+        Timing timing = analyze(netlist, levels, delays);
+        std::vector<Endpoint> endpoints = endpoints_of(netlist, drivers);
+
+        int critical = -1;
+        for (size_t i = 0; i < endpoints.size(); i++) {
+            Endpoint &e = endpoints[i];
+            for (int b : e.nets) {
+                e.timed = e.timed && timing.timed[b];
+                if (e.last < 0 || timing.arrival[b] > e.arrival) {
+                    e.arrival = timing.arrival[b];
+                    e.last = b;
+                }
+            }
+            if (e.timed && e.last >= 0 && (critical < 0 || e.arrival > endpoints[critical].arrival))
+                critical = i;
+        }
+        if (period < 0)
+            period = critical < 0 ? 0 : endpoints[critical].arrival;
+
+        printf("%s: %d nets, %zu nodes, %d gate levels, %zu latches\n\n", top.c_str(), netlist.nets,
+               netlist.nodes.size(), std::max(levels.depth - 1, 0), netlist.latches.size());
+        print_counts(netlist, drivers);
+
+        bool loop = !levels.loop.empty();
+        if (loop) {
+            printf("\nCombinational loop: %s\n", loop_path(netlist, levels.loop).c_str());
+            printf("  %zu nodes on or after it are not timed\n", netlist.nodes.size() - levels.order.size());
+        }
+
+        if (critical >= 0) {
+            const Endpoint &e = endpoints[critical];
+            printf("\nCritical path: %g, to %s\n", e.arrival, e.name.c_str());
+            printf("  %8s %8s  %s\n", "arrival", "delay", "through");
+            double before = 0;
+            for (int b : critical_path(timing, e.last)) {
+                printf("  %8g %8g  %s\n", timing.arrival[b], timing.arrival[b] - before,
+                       net_name(netlist, drivers, b).c_str());
+                before = timing.arrival[b];
+            }
+        }
+
+        // Latches are told from outputs by their component's name
+        std::vector<std::string> names;
+        int width = 9, late = 0;
+        for (const Endpoint &e : endpoints) {
+            names.push_back(e.part >= 0 ? e.name + " (" + netlist.parts[e.part].name + ")" : e.name);
+            width = std::max(width, (int)names.back().size());
+        }
+        printf("\nSlack for a clock period of %g:\n", period);
+        printf("  %-*s %8s %8s\n", width, "end point", "arrival", "slack");
+        for (size_t i = 0; i < endpoints.size(); i++) {
+            const Endpoint &e = endpoints[i];
+            if (!e.timed) {
+                printf("  %-*s %8s %8s\n", width, names[i].c_str(), "-", "-");
+                continue;
+            }
+            printf("  %-*s %8g %8g%s\n", width, names[i].c_str(), e.arrival, period - e.arrival,
+                   e.arrival > period ? "  too late" : "");
+            late += e.arrival > period;
+        }
+
+        if (!graph.empty())
+            write_graph(graph, netlist, levels, timing, endpoints, critical);
+        return loop || late > 0;
+    } catch (const std::runtime_error &error) {
+        fprintf(stderr, "%s: %s\n", argv[optind], error.what());
+        return 2;
+    }
+}
@@ -0,0 +1,716 @@
+// Flattening a Logisim circuit into a netlist; see netlist.h.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "netlist.h"
+
+// How deeply subcircuits may nest before one is taken to contain itself
+#define MAX_NESTING     64
+
+// Widest ROM address supported (the contents are held as a table)
+#define MAX_ROM_ADDRESS 20
+
+namespace {
+
+class UnionFind
+{
+public:
+    int add(int count = 1)
+    {
+        int first = parent.size();
+
+        for (int i = 0; i < count; i++)
+            parent.push_back(first + i);
+        return first;
+    }
+
+    int find(int x)
+    {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    }
+
+    void unite(int a, int b)
+    {
+        parent[find(a)] = find(b);
+    }
+
+    int size() const
+    {
+        return parent.size();
+    }
+
+private:
+    std::vector<int> parent;
+};
+
+// How the ports of one circuit are wired together
+struct Layout
+{
+    std::vector<std::vector<int>> portNet;  // Net of each port of each component
+    std::vector<int> width;                 // Bits in each net
+    std::vector<int> ports;                 // Ports on each net
+    std::vector<int> pinSlot;               // Index in Circuit::pins, or -1
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       make_layout
+//
+//  Arguments:      circuit:    A circuit
+//
+//  Returns:        How the circuit's ports connect
+//
+//  Description:    This function joins wires that share an end point, the
+//                  ports at those points, and tunnels with the same label.
+//                  As in Logisim, wires that cross, or that end in the
+//                  middle of another wire, are not connected.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Layout make_layout(const Circuit &circuit)
+{
+    std::map<Point, int> ids;
+    std::map<std::string, int> tunnels;
+    UnionFind points;
+    Layout layout;
+    auto id = [&](Point p) {
+        auto found = ids.find(p);
+        if (found != ids.end())
+            return found->second;
+        return ids[p] = points.add();
+    };
+
+    for (const Wire &w : circuit.wires)
+        points.unite(id(w.from), id(w.to));
+    for (const Component &c : circuit.components) {
+        for (const Port &p : c.ports)
+            id(p.at);
+        if (c.kind == Kind::Tunnel) {
+            std::string label = c.get("label", "");
+            auto found = tunnels.find(label);
+            if (found == tunnels.end())
+                tunnels[label] = id(c.loc);
+            else
+                points.unite(id(c.loc), found->second);
+        }
+    }
+
+    std::vector<int> net(points.size(), -1);
+    int nets = 0;
+    for (int i = 0; i < points.size(); i++) {
+        int root = points.find(i);
+        if (net[root] < 0)
+            net[root] = nets++;
+    }
+    layout.width.assign(nets, 0);
+    layout.ports.assign(nets, 0);
+    layout.pinSlot.assign(circuit.components.size(), -1);
+    for (size_t i = 0; i < circuit.pins.size(); i++)
+        layout.pinSlot[circuit.pins[i]] = i;
+
+    for (const Component &c : circuit.components) {
+        layout.portNet.emplace_back();
+        for (const Port &p : c.ports) {
+            int n = net[points.find(id(p.at))];
+            layout.portNet.back().push_back(n);
+            layout.ports[n]++;
+            if (p.width == 0)
+                continue;
+            if (layout.width[n] != 0 && layout.width[n] != p.width) {
+                std::ostringstream message;
+                message << "circuit " << circuit.name << ": " << c.name << " at " << to_string(c.loc)
+                        << " has a " << p.width << "-bit port at " << to_string(p.at)
+                        << " on a " << layout.width[n] << "-bit wire";
+                throw std::runtime_error(message.str());
+            }
+            layout.width[n] = p.width;
+        }
+    }
+    return layout;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       rom_contents
+//
+//  Arguments:      c:      A ROM
+//
+//  Returns:        The word at each address
+//
+//  Description:    This function reads Logisim's "contents" attribute, a
+//                  header such as "addr/data: 5 6" followed by hexadecimal
+//                  words, where "4*1a" stands for four words of 1a. Words
+//                  that are not given are 0.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint64_t> rom_contents(const Component &c)
+{
+    int addressBits = c.number("addrWidth", 8);
+    std::istringstream text(c.get("contents", ""));
+    std::string word;
+    size_t address = 0;
+
+    if (addressBits > MAX_ROM_ADDRESS)
+        throw std::runtime_error("ROM address is wider than " + std::to_string(MAX_ROM_ADDRESS) + " bits");
+    std::vector<uint64_t> table((size_t)1 << addressBits, 0);
+
+    text >> word;
+    if (word == "addr/data:") {
+        text >> word >> word;
+    } else {
+        text.seekg(0);
+    }
+    while (text >> word && address < table.size()) {
+        size_t star = word.find('*');
+        unsigned long count = star == std::string::npos ? 1 : strtoul(word.c_str(), nullptr, 10);
+        uint64_t value = strtoull(word.c_str() + (star == std::string::npos ? 0 : star + 1), nullptr, 16);
+
+        for (unsigned long i = 0; i < count && address < table.size(); i++)
+            table[address++] = value;
+    }
+    return table;
+}
+
+// An input or output of the top circuit, before they are put in order
+struct Pending
+{
+    Point at;
+    Signal signal;
+};
+
+class Builder
+{
+public:
+    Builder(const Project &project, Netlist &netlist) : project(project), netlist(netlist) {}
+
+    void instantiate(const Circuit &circuit, const std::string &path,
+                     const std::vector<std::vector<int>> *outside, int depth);
+    void finish();
+
+private:
+    const Project &project;
+    Netlist &netlist;
+    UnionFind bits;
+    std::map<const Circuit *, Layout> layouts;
+    std::vector<Pending> inputs, outputs, states;
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Builder::instantiate
+//
+//  Arguments:      circuit:    The circuit to add
+//                  path:       Its place in the hierarchy, e.g. "main/L0(450,70)"
+//                  outside:    For a subcircuit, the bits wired to each of
+//                              its ports; nullptr for the top circuit
+//                  depth:      How deeply it is nested
+//
+//  Description:    This function gives every net of the circuit fresh bits
+//                  and turns its components into nodes and latches. Pins,
+//                  splitters and subcircuits make no nodes; they only join
+//                  bits, which finish() then merges into single nets.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Builder::instantiate(const Circuit &circuit, const std::string &path,
+                          const std::vector<std::vector<int>> *outside, int depth)
+{
+    if (depth > MAX_NESTING)
+        throw std::runtime_error("circuit " + circuit.name + " contains itself");
+    if (layouts.find(&circuit) == layouts.end())
+        layouts[&circuit] = make_layout(circuit);
+    const Layout &layout = layouts[&circuit];
+
+    std::vector<int> base(layout.width.size());
+    for (size_t n = 0; n < base.size(); n++)
+        base[n] = bits.add(layout.width[n]);
+
+    for (size_t i = 0; i < circuit.components.size(); i++) {
+        const Component &c = circuit.components[i];
+        std::string where = path + "/" + c.name + to_string(c.loc);
+        auto port = [&](int p) {
+            int n = layout.portNet[i][p];
+            std::vector<int> b(layout.width[n]);
+            for (int k = 0; k < layout.width[n]; k++)
+                b[k] = base[n] + k;
+            return b;
+        };
+        auto bit = [&](int p) {
+            std::vector<int> b = port(p);
+            return b.empty() ? -1 : b[0];
+        };
+        auto connected = [&](int p) {
+            return layout.ports[layout.portNet[i][p]] > 1;
+        };
+        auto part = [&]() {
+            netlist.parts.push_back({where, c.name});
+            return (int)netlist.parts.size() - 1;
+        };
+        auto name = [&]() {
+            std::string label = label_of(circuit, c);
+            if (label.empty())
+                label = c.name + to_string(c.loc);
+            return outside == nullptr ? label : path + "/" + label;
+        };
+
+        switch (c.kind) {
+        case Kind::Ignored:
+        case Kind::Tunnel:
+            break;
+
+        case Kind::Pin:
+            if (outside != nullptr) {
+                std::vector<int> inner = port(0), outer = (*outside)[layout.pinSlot[i]];
+                for (size_t k = 0; k < inner.size() && k < outer.size(); k++)
+                    bits.unite(inner[k], outer[k]);
+            } else if (c.get("output", "false") == "true") {
+                outputs.push_back({c.loc, {name(), port(0)}});
+            } else {
+                inputs.push_back({c.loc, {name(), port(0)}});
+            }
+            break;
+
+        case Kind::Button:
+            inputs.push_back({c.loc, {name(), port(0)}});
+            break;
+
+        case Kind::Probe:
+        case Kind::Led:
+            if (outside == nullptr && !port(0).empty())
+                outputs.push_back({c.loc, {name(), port(0)}});
+            break;
+
+        case Kind::DotMatrix:
+            if (outside == nullptr) {
+                for (size_t p = 0; p < c.ports.size(); p++)
+                    outputs.push_back({c.ports[p].at, {name() + "[" + std::to_string(p) + "]", port(p)}});
+            }
+            break;
+
+        case Kind::Splitter: {
+            std::vector<int> combined = port(0);
+            std::vector<int> used(c.ports.size(), 0);
+            for (size_t k = 0; k < combined.size(); k++) {
+                std::string end = c.get("bit" + std::to_string(k), "none");
+                if (end == "none")
+                    continue;
+                int e = atoi(end.c_str()) + 1;
+                bits.unite(combined[k], port(e)[used[e]++]);
+            }
+            break;
+        }
+
+        case Kind::Subcircuit: {
+            std::vector<std::vector<int>> ports;
+            for (size_t p = 0; p < c.ports.size(); p++)
+                ports.push_back(port(p));
+            instantiate(*project.find(c.name), where, &ports, depth + 1);
+            break;
+        }
+
+        case Kind::Constant: {
+            Node node;
+            node.op = Op::Constant;
+            node.out = port(0);
+            node.table.push_back(c.name == "Power" ? ~0ull : c.name == "Ground" ? 0 : (uint64_t)c.number("value", 1));
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Clock: {
+            Node node;
+            node.op = Op::Clock;
+            node.out = port(0);
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Gate: {
+            Op op = c.name == "AND Gate" || c.name == "NAND Gate" ? Op::And
+                : c.name == "OR Gate" || c.name == "NOR Gate" ? Op::Or
+                : c.name == "Odd Parity" || c.name == "Even Parity" || c.get("xor", "1") == "odd" ? Op::Parity
+                : Op::OneHot;
+            bool invert = c.name == "NAND Gate" || c.name == "NOR Gate" || c.name == "XNOR Gate" || c.name == "Even Parity";
+            std::vector<int> out = port(0);
+            int self = -1;
+
+            for (size_t b = 0; b < out.size(); b++) {
+                Node node;
+                node.op = op;
+                node.invert = invert;
+                for (size_t p = 1; p < c.ports.size(); p++) {
+                    if (!connected(p))
+                        continue;
+                    if (c.get("negate" + std::to_string(p - 1), "false") == "true")
+                        node.negate |= 1u << node.in.size();
+                    node.in.push_back(port(p)[b]);
+                }
+                if (node.in.empty())
+                    break;
+                node.out = {out[b]};
+                if (self < 0)
+                    self = part();
+                node.part = self;
+                netlist.nodes.push_back(node);
+            }
+            break;
+        }
+
+        case Kind::Buffer:
+        case Kind::Tristate: {
+            std::vector<int> out = port(0), in = port(1);
+            int self = part();
+
+            for (size_t b = 0; b < out.size(); b++) {
+                Node node;
+                node.op = c.kind == Kind::Buffer ? Op::Buffer : Op::Tristate;
+                node.invert = c.name == "NOT Gate" || c.name == "Controlled Inverter";
+                node.in = {in[b]};
+                if (c.kind == Kind::Tristate)
+                    node.in.push_back(bit(2));
+                node.out = {out[b]};
+                node.part = self;
+                netlist.nodes.push_back(node);
+            }
+            break;
+        }
+
+        case Kind::Mux: {
+            int select = c.number("select", 1), ways = 1 << select;
+            Node node;
+            node.op = Op::Mux;
+            node.width = c.number("width", 1);
+            node.arg = select;
+            node.flag = c.get("disabled", "Z") == "0";
+            for (int p = 1; p <= ways + 1; p++) {
+                std::vector<int> b = port(p);
+                node.in.insert(node.in.end(), b.begin(), b.end());
+            }
+            node.in.push_back((int)c.ports.size() > ways + 2 ? bit(ways + 2) : -1);
+            node.out = port(0);
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Adder:
+        case Kind::Subtractor: {
+            Node node;
+            node.op = Op::Add;
+            node.width = c.number("width", 8);
+            node.flag = c.kind == Kind::Subtractor;
+            node.in = port(1);
+            for (int b : port(2))
+                node.in.push_back(b);
+            node.in.push_back(bit(3));
+            node.out = port(0);
+            node.out.push_back(bit(4));
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Comparator: {
+            Node node;
+            node.op = Op::Compare;
+            node.width = c.number("width", 8);
+            node.flag = c.get("mode", "twosComplement") != "unsigned";
+            node.in = port(0);
+            for (int b : port(1))
+                node.in.push_back(b);
+            node.out = {bit(2), bit(3), bit(4)};
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Rom: {
+            Node node;
+            node.op = Op::Rom;
+            node.arg = c.number("addrWidth", 8);
+            node.width = c.number("dataWidth", 8);
+            node.in = port(1);
+            node.in.push_back(bit(2));
+            node.out = port(0);
+            try {
+                node.table = rom_contents(c);
+            } catch (const std::runtime_error &error) {
+                throw std::runtime_error(where + ": " + error.what());
+            }
+            node.part = part();
+            netlist.nodes.push_back(node);
+            break;
+        }
+
+        case Kind::Register:
+        case Kind::FlipFlop: {
+            bool reg = c.kind == Kind::Register;
+            std::string trigger = c.get("trigger", "rising");
+            Latch latch;
+            Node q;
+
+            if (trigger != "rising" && trigger != "falling")
+                throw std::runtime_error(where + ": level-triggered latches are not supported");
+            latch.reg = reg;
+            latch.falling = trigger == "falling";
+            latch.d = port(reg ? 1 : 0);
+            latch.clock = bit(reg ? 2 : 1);
+            latch.clear = bit(reg ? 3 : 4);
+            latch.enable = reg ? bit(4) : -1;
+            latch.preset = reg ? -1 : bit(5);
+            latch.state = netlist.stateBits;
+            latch.part = part();
+            netlist.stateBits += latch.d.size();
+            netlist.latches.push_back(latch);
+
+            q.op = Op::State;
+            q.arg = latch.state;
+            q.out = port(reg ? 0 : 2);
+            q.part = latch.part;
+            netlist.nodes.push_back(q);
+            if (!reg) {
+                q.out = port(3);
+                q.invert = true;
+                netlist.nodes.push_back(q);
+            }
+            states.push_back({c.loc, {name(), port(reg ? 0 : 2)}});
+            break;
+        }
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Builder::finish
+//
+//  Description:    This function numbers the nets that remain once joined
+//                  bits are merged, puts the inputs and outputs in order
+//                  (top to bottom, then left to right, as they are drawn)
+//                  and adds a node for each input.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Builder::finish()
+{
+    std::vector<int> net(bits.size(), -1);
+    auto rename = [&](int &b) {
+        if (b < 0)
+            return;
+        int root = bits.find(b);
+        if (net[root] < 0)
+            net[root] = netlist.nets++;
+        b = net[root];
+    };
+    auto by_place = [](const Pending &a, const Pending &b) {
+        return a.at.y != b.at.y ? a.at.y < b.at.y : a.at.x < b.at.x;
+    };
+
+    std::stable_sort(inputs.begin(), inputs.end(), by_place);
+    std::stable_sort(outputs.begin(), outputs.end(), by_place);
+    std::stable_sort(states.begin(), states.end(), by_place);
+    for (Pending &p : inputs) {
+        Node node;
+        node.op = Op::Input;
+        node.arg = netlist.inputBits;
+        node.out = p.signal.bits;
+        netlist.parts.push_back({p.signal.name, "Pin"});
+        node.part = netlist.parts.size() - 1;
+        netlist.nodes.push_back(node);
+        netlist.inputBits += p.signal.bits.size();
+        netlist.inputs.push_back(p.signal);
+    }
+    for (Pending &p : outputs)
+        netlist.outputs.push_back(p.signal);
+    for (Pending &p : states)
+        netlist.states.push_back(p.signal);
+
+    for (Node &node : netlist.nodes) {
+        for (int &b : node.in)
+            rename(b);
+        for (int &b : node.out)
+            rename(b);
+    }
+    for (Latch &latch : netlist.latches) {
+        for (int &b : latch.d)
+            rename(b);
+        rename(latch.clock);
+        rename(latch.enable);
+        rename(latch.clear);
+        rename(latch.preset);
+    }
+
+    // Names are single words, so that tables can be split at spaces, and
+    // signals that share a name are told apart by their position
+    std::map<std::string, int> seen;
+    std::vector<Signal> *groups[] = {&netlist.inputs, &netlist.outputs, &netlist.states};
+    for (auto *group : groups) {
+        for (Signal &s : *group) {
+            std::replace_if(s.name.begin(), s.name.end(), isspace, '_');
+            seen[s.name]++;
+        }
+    }
+    for (auto *group : groups) {
+        for (size_t i = 0; i < group->size(); i++) {
+            Signal &s = (*group)[i];
+            for (int &b : s.bits)
+                rename(b);
+            if (seen[s.name] > 1)
+                s.name += "#" + std::to_string(i);
+        }
+    }
+}
+
+} // namespace
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       build_netlist
+//
+//  Arguments:      project:    A project read by read_project
+//                  top:        The circuit to flatten
+//
+//  Returns:        The netlist of that circuit
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Netlist build_netlist(const Project &project, const std::string &top)
+{
+    const Circuit *circuit = project.find(top);
+    Netlist netlist;
+
+    if (circuit == nullptr)
+        throw std::runtime_error("no circuit named " + top);
+    netlist.strictGates = project.strictGates;
+
+    Builder builder(project, netlist);
+    builder.instantiate(*circuit, top, nullptr, 0);
+    builder.finish();
+    return netlist;
+}
+
+std::vector<std::vector<int>> net_drivers(const Netlist &netlist)
+{
+    std::vector<std::vector<int>> drivers(netlist.nets);
+
+    for (size_t n = 0; n < netlist.nodes.size(); n++) {
+        for (int b : netlist.nodes[n].out) {
+            if (b >= 0)
+                drivers[b].push_back(n);
+        }
+    }
+    return drivers;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       levelize
+//
+//  Arguments:      netlist:    A netlist
+//
+//  Returns:        An evaluation order for its nodes
+//
+//  Description:    This function sorts the nodes topologically (Kahn's
+//                  algorithm), so one pass in that order settles every net.
+//                  Latches break the graph at clock edges: their State
+//                  nodes have no inputs. If some nodes are left over they
+//                  form combinational loops, and the function walks back
+//                  from one of them to report a loop it belongs to.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Levels levelize(const Netlist &netlist)
+{
+    std::vector<std::vector<int>> drivers = net_drivers(netlist);
+    size_t count = netlist.nodes.size();
+    std::vector<std::vector<int>> next(count);
+    std::vector<int> waiting(count, 0);
+    Levels levels;
+
+    for (size_t n = 0; n < count; n++) {
+        for (int b : netlist.nodes[n].in) {
+            if (b < 0)
+                continue;
+            for (int d : drivers[b]) {
+                next[d].push_back(n);
+                waiting[n]++;
+            }
+        }
+    }
+
+    levels.level.assign(count, 0);
+    for (size_t n = 0; n < count; n++) {
+        if (waiting[n] == 0)
+            levels.order.push_back(n);
+    }
+    for (size_t i = 0; i < levels.order.size(); i++) {
+        int n = levels.order[i];
+        levels.depth = std::max(levels.depth, levels.level[n] + 1);
+        for (int s : next[n]) {
+            levels.level[s] = std::max(levels.level[s], levels.level[n] + 1);
+            if (--waiting[s] == 0)
+                levels.order.push_back(s);
+        }
+    }
+
+    if (levels.order.size() < count) {
+        std::vector<int> seen(count, -1);
+        std::vector<int> walk;
+        int n = 0;
+
+        while (waiting[n] == 0)
+            n++;
+        while (seen[n] < 0) {
+            seen[n] = walk.size();
+            walk.push_back(n);
+            int previous = -1;
+            for (int b : netlist.nodes[n].in) {
+                if (b < 0)
+                    continue;
+                for (int d : drivers[b]) {
+                    if (waiting[d] > 0)
+                        previous = d;
+                }
+            }
+            n = previous;
+        }
+        levels.loop.assign(walk.rbegin(), walk.rend() - seen[n]);
+    }
+    return levels;
+}
+
+std::string loop_path(const Netlist &netlist, const std::vector<int> &loop)
+{
+    std::string path;
+    int last = -1;
+
+    for (int n : loop) {
+        int part = netlist.nodes[n].part;
+        if (part != last)
+            path += netlist.parts[part].path + " -> ";
+        last = part;
+    }
+    return loop.empty() ? path : path + netlist.parts[netlist.nodes[loop[0]].part].path;
+}
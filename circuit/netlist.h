@@ -0,0 +1,114 @@
+// A flattened netlist: one circuit of a project with all its subcircuits
+// expanded in place, and every wire, tunnel and splitter reduced to plain
+// one-bit nets. What is left are nodes that compute nets from other nets,
+// and latches (registers and flip-flops) that hold state between clock
+// edges.
+
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "circ.h"
+
+enum class Op
+{
+    Input,      // out: the bits of a top-level input pin or button
+    Clock,      // out: a clock's bit
+    Constant,   // out: the bits of table[0]
+    State,      // out: latch bits, starting at arg (inverted for not Q)
+    And,        // in: inputs, out: one bit; negate has a bit per inverted
+    Or,         //   input, and invert is set for NAND, NOR and XNOR
+    Parity,     // XOR with an odd number of inputs high
+    OneHot,     // XOR with exactly one input high (Logisim's default)
+    Buffer,     // in: input, out: output (invert for a NOT gate)
+    Tristate,   // in: input, control, out: output
+    Mux,        // in: arg select bits after width bits per data input,
+                //   then enable; out: width bits; flag: 0 when disabled
+    Add,        // in: a, b (width bits each), carry in; out: sum, carry
+                //   out; flag: subtract (carries are then borrows)
+    Compare,    // in: a, b (width bits each), out: greater, equal, less;
+                //   flag: two's complement
+    Rom         // in: arg address bits, chip select; out: width bits;
+                //   table: the contents
+};
+
+struct Node
+{
+    Op op;
+    std::vector<int> in;        // Input nets, -1 for nothing
+    std::vector<int> out;       // Output nets
+    bool invert = false;
+    bool flag = false;
+    uint32_t negate = 0;
+    int width = 1;
+    int arg = 0;
+    std::vector<uint64_t> table;
+    int part;                   // Index in Netlist::parts
+};
+
+// A register or flip-flop. Its state bits are read through a State node
+// and change on clock edges.
+struct Latch
+{
+    bool reg;                   // Register: keeps its value when d is undefined
+    bool falling;               // Triggered by falling edges
+    std::vector<int> d;         // Data input nets
+    int clock, enable, clear, preset;
+    int state;                  // First bit in the state vector
+    int part;
+};
+
+// The component that a node or latch was made from
+struct Part
+{
+    std::string path;           // e.g. "main/L0(450,70)/AND Gate(330,230)"
+    std::string name;           // e.g. "AND Gate"
+};
+
+// A named group of nets, least significant bit first
+struct Signal
+{
+    std::string name;
+    std::vector<int> bits;
+};
+
+struct Netlist
+{
+    int nets = 0;
+    std::vector<Node> nodes;
+    std::vector<Latch> latches;
+    std::vector<Part> parts;
+    std::vector<Signal> inputs;     // Input pins and buttons of the top circuit
+    std::vector<Signal> outputs;    // Its output pins, probes, LEDs and dot matrices
+    std::vector<Signal> states;     // Every register and flip-flop
+    int inputBits = 0;
+    int stateBits = 0;
+    bool strictGates = false;
+};
+
+// The nodes in an order where every node comes after those that drive
+// its inputs, and the depth of each
+struct Levels
+{
+    std::vector<int> order;
+    std::vector<int> level;     // 0 for nodes with no inputs driven by others
+    std::vector<int> loop;      // The nodes of a combinational loop, if any
+    int depth = 0;              // Highest level plus one
+};
+
+// Throws std::runtime_error for a missing circuit, a recursive subcircuit
+// or wires joining ports of different widths
+Netlist build_netlist(const Project &project, const std::string &top);
+
+// For each net, the nodes that drive it
+std::vector<std::vector<int>> net_drivers(const Netlist &netlist);
+
+Levels levelize(const Netlist &netlist);
+
+// The components along a loop found by levelize, as "a -> b -> a"
+std::string loop_path(const Netlist &netlist, const std::vector<int> &loop);
+
+#endif
@@ -0,0 +1,373 @@
+// Bit-parallel evaluation of a netlist; see simulate.h. Each node follows
+// the propagate() method of the Logisim component it was made from,
+// applied to 64 vectors with word operations.
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "simulate.h"
+
+// Passes over the nodes allowed before latches that keep clocking each
+// other (a flip-flop clocked by its own output) are reported
+#define MAX_SETTLE      1000
+
+Simulator::Simulator(const Netlist &netlist)
+    : netlist(netlist), sorted(levelize(netlist)), high(netlist.nets), low(netlist.nets),
+      inputs(netlist.inputBits, 0), stateHigh(netlist.stateBits), stateLow(netlist.stateBits),
+      clockHigh(netlist.latches.size()), clockLow(netlist.latches.size()), clock(false)
+{
+    if (!sorted.loop.empty())
+        throw std::runtime_error("combinational loop: " + loop_path(netlist, sorted.loop));
+}
+
+void Simulator::set_input(int bit, uint64_t value)
+{
+    inputs[bit] = value;
+}
+
+inline void Simulator::read(int net, uint64_t &h, uint64_t &l) const
+{
+    h = net < 0 ? 0 : high[net];
+    l = net < 0 ? 0 : low[net];
+}
+
+inline void Simulator::drive(int net, uint64_t h, uint64_t l)
+{
+    if (net >= 0) {
+        high[net] |= h;
+        low[net] |= l;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Simulator::evaluate
+//
+//  Arguments:      node:   The node to evaluate
+//
+//  Description:    This function ORs the node's outputs into its output
+//                  nets, from the nets driving its inputs. Gates ignore
+//                  floating inputs, as Logisim does unless the project's
+//                  "gateUndefined" option is "error".
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Simulator::evaluate(const Node &node)
+{
+    uint64_t h, l;
+
+    switch (node.op) {
+    case Op::Input:
+        for (size_t k = 0; k < node.out.size(); k++)
+            drive(node.out[k], inputs[node.arg + k], ~inputs[node.arg + k]);
+        break;
+
+    case Op::Clock:
+        drive(node.out[0], clock ? ~0ull : 0, clock ? 0 : ~0ull);
+        break;
+
+    case Op::Constant:
+        for (size_t k = 0; k < node.out.size(); k++) {
+            uint64_t v = k < 64 && (node.table[0] >> k & 1) ? ~0ull : 0;
+            drive(node.out[k], v, ~v);
+        }
+        break;
+
+    case Op::State:
+        for (size_t k = 0; k < node.out.size(); k++) {
+            h = stateHigh[node.arg + k];
+            l = stateLow[node.arg + k];
+            if (node.invert)
+                std::swap(h, l);
+            drive(node.out[k], h, l);
+        }
+        break;
+
+    case Op::And:
+    case Op::Or:
+    case Op::Parity:
+    case Op::OneHot: {
+        uint64_t any = 0, allHigh = ~0ull, anyLow = 0, anyHigh = 0, allLow = ~0ull;
+        uint64_t error = 0, odd = 0, one = 0, two = 0;
+
+        for (size_t i = 0; i < node.in.size(); i++) {
+            read(node.in[i], h, l);
+            if (node.negate >> i & 1)
+                std::swap(h, l);
+            uint64_t floating = ~(h | l);
+            if (netlist.strictGates) {
+                h |= floating;
+                l |= floating;
+                floating = 0;
+            }
+
+            any |= h | l;
+            allHigh &= h | floating;
+            anyLow |= l;
+            anyHigh |= h;
+            allLow &= l | floating;
+            error |= h & l;
+            odd ^= h & ~l;
+            two |= one & h & ~l;
+            one |= h & ~l;
+        }
+
+        if (node.op == Op::And) {
+            h = any & allHigh;
+            l = anyLow;
+        } else if (node.op == Op::Or) {
+            h = anyHigh;
+            l = any & allLow;
+        } else {
+            uint64_t v = node.op == Op::Parity ? odd : one & ~two;
+            h = any & (error | v);
+            l = any & (error | ~v);
+        }
+        if (node.invert)
+            std::swap(h, l);
+        drive(node.out[0], h, l);
+        break;
+    }
+
+    case Op::Buffer:
+        read(node.in[0], h, l);
+        if (netlist.strictGates) {
+            uint64_t floating = ~(h | l);
+            h |= floating;
+            l |= floating;
+        }
+        if (node.invert)
+            std::swap(h, l);
+        drive(node.out[0], h, l);
+        break;
+
+    case Op::Tristate: {
+        uint64_t ch, cl;
+
+        read(node.in[0], h, l);
+        read(node.in[1], ch, cl);
+        if (node.invert)
+            std::swap(h, l);
+
+        // A control that is neither 0 nor 1 gives an error
+        uint64_t on = ch & ~cl, unknown = ~(on | (cl & ~ch));
+        drive(node.out[0], (on & h) | unknown, (on & l) | unknown);
+        break;
+    }
+
+    case Op::Mux: {
+        int ways = 1 << node.arg, selects = ways * node.width;
+        uint64_t bad = 0, eh, el;
+        std::vector<uint64_t> match(ways, ~0ull);
+
+        for (int k = 0; k < node.arg; k++) {
+            read(node.in[selects + k], h, l);
+            bad |= ~(h ^ l);
+            for (int w = 0; w < ways; w++)
+                match[w] &= (w >> k & 1) ? h & ~l : l & ~h;
+        }
+        read(node.in[selects + node.arg], eh, el);
+        uint64_t disabled = el & ~eh;
+        bad = (bad | (eh & el)) & ~disabled;
+
+        for (int j = 0; j < node.width; j++) {
+            uint64_t oh = 0, ol = 0;
+            for (int w = 0; w < ways; w++) {
+                read(node.in[w * node.width + j], h, l);
+                oh |= match[w] & h;
+                ol |= match[w] & l;
+            }
+            oh = (oh | bad) & ~disabled;
+            ol = (ol | bad) & ~disabled;
+            if (node.flag)
+                ol |= disabled;
+            drive(node.out[j], oh, ol);
+        }
+        break;
+    }
+
+    case Op::Add: {
+        // A floating carry in counts as 0; a subtractor adds the
+        // complement of b with the complement of its borrow in
+        uint64_t ch, cl;
+        int w = node.width;
+
+        read(node.in[2 * w], ch, cl);
+        cl |= ~(ch | cl);
+        if (node.flag)
+            std::swap(ch, cl);
+
+        for (int j = 0; j < w; j++) {
+            uint64_t ah, al, bh, bl;
+            read(node.in[j], ah, al);
+            read(node.in[w + j], bh, bl);
+            if (node.flag)
+                std::swap(bh, bl);
+
+            // Errors and floating bits spoil the sum from there upwards
+            uint64_t carryUnknown = ~(ch | cl);
+            uint64_t error = (ch & cl) | (~carryUnknown & ((ah & al) | (bh & bl)));
+            uint64_t unknown = ~error & (carryUnknown | ~(ah | al) | ~(bh | bl));
+            uint64_t good = ~(error | unknown);
+            uint64_t sum = ah ^ bh ^ ch;
+            uint64_t carry = (ah & bh) | (ch & (ah ^ bh));
+
+            drive(node.out[j], (good & sum) | error, (good & ~sum) | error);
+            ch = (good & carry) | error;
+            cl = (good & ~carry) | error;
+        }
+        if (node.flag)
+            std::swap(ch, cl);
+        drive(node.out[w], ch, cl);
+        break;
+    }
+
+    case Op::Compare: {
+        int w = node.width;
+        uint64_t defined = ~0ull, greater = 0, less = 0, equal = ~0ull;
+
+        for (int j = w - 1; j >= 0; j--) {
+            uint64_t ah, al, bh, bl;
+            read(node.in[j], ah, al);
+            read(node.in[w + j], bh, bl);
+            defined &= (ah ^ al) & (bh ^ bl);
+
+            // A set sign bit makes a two's complement number smaller
+            if (node.flag && j == w - 1)
+                std::swap(ah, bh);
+            greater |= equal & ah & ~bh;
+            less |= equal & ~ah & bh;
+            equal &= ~(ah ^ bh);
+        }
+
+        uint64_t results[3] = {greater, equal, less};
+        for (int k = 0; k < 3; k++)
+            drive(node.out[k], (results[k] & defined) | ~defined, (~results[k] & defined) | ~defined);
+        break;
+    }
+
+    case Op::Rom: {
+        // Looked up lane by lane: one table read per lane is cheaper than
+        // decoding every address across the lanes
+        uint64_t defined = ~0ull, csh, csl;
+        std::vector<uint64_t> address(node.arg * 2);
+        std::vector<uint64_t> dh(node.width, 0), dl(node.width, 0);
+
+        for (int k = 0; k < node.arg; k++) {
+            read(node.in[k], address[2 * k], address[2 * k + 1]);
+            defined &= address[2 * k] ^ address[2 * k + 1];
+        }
+        read(node.in[node.arg], csh, csl);
+        uint64_t off = csl & ~csh;
+
+        for (int lane = 0; lane < LANES; lane++) {
+            if (!(defined >> lane & 1))
+                continue;
+            size_t a = 0;
+            for (int k = 0; k < node.arg; k++)
+                a |= (size_t)(address[2 * k] >> lane & 1) << k;
+            uint64_t word = node.table[a];
+            for (int j = 0; j < node.width; j++) {
+                if (j < 64 && (word >> j & 1))
+                    dh[j] |= 1ull << lane;
+                else
+                    dl[j] |= 1ull << lane;
+            }
+        }
+        for (int j = 0; j < node.width; j++)
+            drive(node.out[j], (dh[j] | ~defined) & ~off, (dl[j] | ~defined) & ~off);
+        break;
+    }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Simulator::update_latches
+//
+//  Returns:        true if any latch changed
+//
+//  Description:    This function loads the latches that saw their clock
+//                  edge since the last call, all from the same settled
+//                  nets, then applies clears and presets. A register only
+//                  loads when enabled (a floating enable counts as on) and
+//                  when its input is fully defined, like Logisim's.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+bool Simulator::update_latches()
+{
+    bool changed = false;
+
+    for (size_t i = 0; i < netlist.latches.size(); i++) {
+        const Latch &latch = netlist.latches[i];
+        uint64_t ch, cl, eh, el, h, l;
+
+        read(latch.clock, ch, cl);
+        uint64_t was = latch.falling ? clockHigh[i] & ~clockLow[i] : clockLow[i] & ~clockHigh[i];
+        uint64_t now = latch.falling ? cl & ~ch : ch & ~cl;
+        uint64_t load = was & now;
+        clockHigh[i] = ch;
+        clockLow[i] = cl;
+
+        read(latch.enable, eh, el);
+        load &= ~(el & ~eh);
+        if (latch.reg) {
+            for (int b : latch.d) {
+                read(b, h, l);
+                load &= h ^ l;
+            }
+        }
+        read(latch.clear, h, l);
+        uint64_t clear = h & ~l;
+        read(latch.preset, h, l);
+        uint64_t preset = h & ~l & ~clear;
+
+        for (size_t k = 0; k < latch.d.size(); k++) {
+            uint64_t &sh = stateHigh[latch.state + k], &sl = stateLow[latch.state + k];
+            read(latch.d[k], h, l);
+            uint64_t nh = (((sh & ~load) | (h & load)) & ~clear) | preset;
+            uint64_t nl = (((sl & ~load) | (l & load)) | clear) & ~preset;
+            changed |= nh != sh || nl != sl;
+            sh = nh;
+            sl = nl;
+        }
+    }
+    return changed;
+}
+
+void Simulator::settle()
+{
+    for (int pass = 0; pass < MAX_SETTLE; pass++) {
+        std::fill(high.begin(), high.end(), 0);
+        std::fill(low.begin(), low.end(), 0);
+        for (int n : sorted.order)
+            evaluate(netlist.nodes[n]);
+        if (!update_latches())
+            return;
+    }
+    throw std::runtime_error("the latches do not settle (a clock that depends on its own latch?)");
+}
+
+void Simulator::reset()
+{
+    std::fill(stateHigh.begin(), stateHigh.end(), 0);
+    std::fill(stateLow.begin(), stateLow.end(), ~0ull);
+    std::fill(clockHigh.begin(), clockHigh.end(), 0);
+    std::fill(clockLow.begin(), clockLow.end(), 0);
+    clock = false;
+    settle();
+}
+
+void Simulator::cycle()
+{
+    clock = true;
+    settle();
+    clock = false;
+    settle();
+}
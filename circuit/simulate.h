@@ -0,0 +1,53 @@
+// Bit-parallel (bit-sliced) evaluation of a netlist. Every net carries 64
+// lanes at once, one per input vector, in two words: hi has a lane set
+// when something drives the net high and lo when something drives it low.
+// A lane with neither is floating (blue in Logisim), and one with both is
+// an error (red). That is also how a net with several drivers, such as a
+// bus of controlled buffers, is resolved: by OR-ing their words together.
+
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "netlist.h"
+
+#define LANES   64
+
+class Simulator
+{
+public:
+    // Throws std::runtime_error when the netlist has a combinational loop
+    explicit Simulator(const Netlist &netlist);
+
+    // Sets an input bit (numbered as in Node::arg) in every lane
+    void set_input(int bit, uint64_t value);
+
+    // Clears every register and flip-flop, and settles the nets
+    void reset();
+
+    // Drives the clocks high and then low, settling after each edge
+    void cycle();
+
+    uint64_t hi(int net) const { return high[net]; }
+    uint64_t lo(int net) const { return low[net]; }
+    const Levels &levels() const { return sorted; }
+
+private:
+    const Netlist &netlist;
+    Levels sorted;
+    std::vector<uint64_t> high, low;
+    std::vector<uint64_t> inputs;
+    std::vector<uint64_t> stateHigh, stateLow;
+    std::vector<uint64_t> clockHigh, clockLow;     // Last clock seen by each latch
+    bool clock;
+
+    void read(int net, uint64_t &h, uint64_t &l) const;
+    void drive(int net, uint64_t h, uint64_t l);
+    void evaluate(const Node &node);
+    bool update_latches();
+    void settle();
+};
+
+#endif
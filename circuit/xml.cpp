@@ -0,0 +1,308 @@
+// A small recursive descent XML reader; see xml.h.
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "xml.h"
+
+namespace {
+
+class Parser
+{
+public:
+    explicit Parser(const std::string &text) : text(text), pos(0) {}
+
+    XmlElement document();
+
+private:
+    const std::string &text;
+    size_t pos;
+
+    [[noreturn]] void fail(const std::string &message) const;
+    bool starts(const char *s) const;
+    void expect(char c);
+    void skip_space();
+    void skip_past(const char *end);
+    void skip_misc();
+    std::string name();
+    std::string decode(size_t start, size_t end) const;
+    void element(XmlElement &e);
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Parser::fail
+//
+//  Arguments:      message:    What is wrong
+//
+//  Description:    This function throws std::runtime_error for an error at
+//                  the current position, prefixed with its line number.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Parser::fail(const std::string &message) const
+{
+    size_t end = pos < text.size() ? pos : text.size();
+    int line = 1;
+
+    for (size_t i = 0; i < end; i++)
+        line += text[i] == '\n';
+    throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+}
+
+bool Parser::starts(const char *s) const
+{
+    return text.compare(pos, strlen(s), s) == 0;
+}
+
+void Parser::expect(char c)
+{
+    if (pos >= text.size() || text[pos] != c)
+        fail(std::string("expected '") + c + "'");
+    pos++;
+}
+
+void Parser::skip_space()
+{
+    while (pos < text.size() && strchr(" \t\r\n", text[pos]) != nullptr)
+        pos++;
+}
+
+void Parser::skip_past(const char *end)
+{
+    size_t found = text.find(end, pos);
+
+    if (found == std::string::npos)
+        fail(std::string("missing '") + end + "'");
+    pos = found + strlen(end);
+}
+
+// Skips comments, processing instructions and the document type declaration
+void Parser::skip_misc()
+{
+    for (;;) {
+        skip_space();
+        if (starts("<!--"))
+            skip_past("-->");
+        else if (starts("<?"))
+            skip_past("?>");
+        else if (starts("<!"))
+            skip_past(">");
+        else
+            return;
+    }
+}
+
+std::string Parser::name()
+{
+    size_t start = pos;
+
+    while (pos < text.size() && (isalnum((unsigned char)text[pos]) || strchr("_:-.", text[pos]) != nullptr))
+        pos++;
+    if (pos == start)
+        fail("expected a name");
+    return text.substr(start, pos - start);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Parser::decode
+//
+//  Arguments:      start, end:     The range of text to decode
+//
+//  Returns:        The text with character references replaced
+//
+//  Description:    This function replaces the five predefined entities and
+//                  numeric references (&#65; and &#x41;), which it encodes
+//                  in UTF-8.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::string Parser::decode(size_t start, size_t end) const
+{
+    static const char *const entities[][2] = {
+        {"lt", "<"}, {"gt", ">"}, {"amp", "&"}, {"quot", "\""}, {"apos", "'"}
+    };
+    std::string out;
+
+    for (size_t i = start; i < end; i++) {
+        if (text[i] != '&') {
+            out += text[i];
+            continue;
+        }
+
+        size_t semi = text.find(';', i);
+        if (semi == std::string::npos || semi >= end)
+            throw std::runtime_error("unterminated character reference");
+        std::string ref = text.substr(i + 1, semi - i - 1);
+        i = semi;
+
+        if (!ref.empty() && ref[0] == '#') {
+            unsigned long c = ref.size() > 1 && ref[1] == 'x'
+                ? strtoul(ref.c_str() + 2, nullptr, 16) : strtoul(ref.c_str() + 1, nullptr, 10);
+
+            if (c < 0x80) {
+                out += (char)c;
+            } else if (c < 0x800) {
+                out += (char)(0xC0 | c >> 6);
+                out += (char)(0x80 | (c & 0x3F));
+            } else if (c < 0x10000) {
+                out += (char)(0xE0 | c >> 12);
+                out += (char)(0x80 | (c >> 6 & 0x3F));
+                out += (char)(0x80 | (c & 0x3F));
+            } else {
+                out += (char)(0xF0 | c >> 18);
+                out += (char)(0x80 | (c >> 12 & 0x3F));
+                out += (char)(0x80 | (c >> 6 & 0x3F));
+                out += (char)(0x80 | (c & 0x3F));
+            }
+            continue;
+        }
+
+        bool known = false;
+        for (const auto &entity : entities) {
+            if (ref == entity[0]) {
+                out += entity[1];
+                known = true;
+            }
+        }
+        if (!known)
+            throw std::runtime_error("unknown entity &" + ref + ";");
+    }
+    return out;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       Parser::element
+//
+//  Arguments:      e:      The element to fill in
+//
+//  Description:    This function reads an element, starting at its '<',
+//                  together with everything inside it up to and including
+//                  its end tag.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Parser::element(XmlElement &e)
+{
+    expect('<');
+    e.name = name();
+
+    // Attributes, up to the end of the start tag
+    for (;;) {
+        skip_space();
+        if (starts("/>")) {
+            pos += 2;
+            return;
+        }
+        if (starts(">")) {
+            pos++;
+            break;
+        }
+
+        std::string key = name();
+        skip_space();
+        expect('=');
+        skip_space();
+        if (pos >= text.size() || (text[pos] != '"' && text[pos] != '\''))
+            fail("expected a quoted value for " + key);
+        size_t close = text.find(text[pos], pos + 1);
+        if (close == std::string::npos)
+            fail("unterminated value for " + key);
+        try {
+            e.attributes.emplace_back(key, decode(pos + 1, close));
+        } catch (const std::runtime_error &error) {
+            fail(error.what());
+        }
+        pos = close + 1;
+    }
+
+    // Content, up to the end tag
+    for (;;) {
+        if (pos >= text.size())
+            fail("missing </" + e.name + ">");
+
+        if (starts("</")) {
+            pos += 2;
+            if (name() != e.name)
+                fail("mismatched end tag for <" + e.name + ">");
+            skip_space();
+            expect('>');
+            return;
+        } else if (starts("<!--")) {
+            skip_past("-->");
+        } else if (starts("<![CDATA[")) {
+            size_t start = pos + 9;
+            skip_past("]]>");
+            e.text.append(text, start, pos - 3 - start);
+        } else if (starts("<?")) {
+            skip_past("?>");
+        } else if (text[pos] == '<') {
+            e.children.emplace_back();
+            element(e.children.back());
+        } else {
+            size_t start = pos;
+            while (pos < text.size() && text[pos] != '<')
+                pos++;
+            try {
+                e.text += decode(start, pos);
+            } catch (const std::runtime_error &error) {
+                fail(error.what());
+            }
+        }
+    }
+}
+
+XmlElement Parser::document()
+{
+    XmlElement root;
+
+    skip_misc();
+    if (pos >= text.size())
+        fail("no root element");
+    element(root);
+    skip_misc();
+    if (pos < text.size())
+        fail("text after the root element");
+    return root;
+}
+
+} // namespace
+
+
+
+const std::string *XmlElement::attribute(const std::string &key) const
+{
+    for (const auto &a : attributes) {
+        if (a.first == key)
+            return &a.second;
+    }
+    return nullptr;
+}
+
+XmlElement parse_xml(const std::string &text)
+{
+    return Parser(text).document();
+}
+
+XmlElement read_xml(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text;
+
+    if (!file)
+        throw std::runtime_error("cannot open file");
+    text << file.rdbuf();
+    return parse_xml(text.str());
+}
@@ -0,0 +1,28 @@
+// A small reader for the XML that Logisim writes. It understands elements,
+// attributes, character data, CDATA sections, comments, processing
+// instructions and character references, which covers every .circ file;
+// it does not read DTDs or check documents against them.
+
+#ifndef XML_H
+#define XML_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct XmlElement
+{
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    std::vector<XmlElement> children;
+    std::string text;           // Character data directly inside the element
+
+    // The value of an attribute, or nullptr when it is not set
+    const std::string *attribute(const std::string &key) const;
+};
+
+// Both throw std::runtime_error, with the line number, on malformed input
+XmlElement parse_xml(const std::string &text);
+XmlElement read_xml(const std::string &path);
+
+#endif